@@ -273,7 +273,8 @@ int main(int argc, char* argv[])
 	// render to file
 	if (coptsParser.Render) {
 		engine.UI().Open(coptsParser.ProjectFile);
-		printf("Rendering to file...\n");
+		if (coptsParser.RenderPath != "-") // don't mix the message with the video stream
+			printf("Rendering to file...\n");
 		engine.UI().SavePreviewToFile();
 	}
 
@@ -1,4 +1,5 @@
 #include <SHADERed/EditorEngine.h>
+#include <SHADERed/Objects/Profiler.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 
@@ -22,6 +23,10 @@ namespace ed {
 	}
 	void EditorEngine::Update(float delta)
 	{
+		// everything until the end of Render() belongs to this frame
+		Profiler::Instance().SetEnabled(Settings::Instance().General.Profiler);
+		Profiler::Instance().BeginFrame();
+
 		// first update system time delta value
 		SystemVariableManager::Instance().SetTimeDelta(delta);
 
@@ -31,6 +36,8 @@ namespace ed {
 	void EditorEngine::Render()
 	{
 		m_ui.Render();
+
+		Profiler::Instance().EndFrame();
 	}
 	void EditorEngine::Destroy()
 	{
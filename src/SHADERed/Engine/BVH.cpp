@@ -0,0 +1,224 @@
+#include <SHADERed/Engine/BVH.h>
+#include <SHADERed/Engine/Ray.h>
+#include <algorithm>
+
+#define BVH_BIN_COUNT 16
+#define BVH_MAX_LEAF_SIZE 8
+
+namespace ed {
+	namespace eng {
+		static inline float getHalfArea(const glm::vec3& minb, const glm::vec3& maxb)
+		{
+			glm::vec3 size = maxb - minb;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+		static inline bool intersectNode(const BVH::Node& node, const glm::vec3& origin, const glm::vec3& invDir, float maxDist, float& distHit)
+		{
+			glm::vec3 t1 = (node.Min - origin) * invDir;
+			glm::vec3 t2 = (node.Max - origin) * invDir;
+			glm::vec3 tmin = glm::min(t1, t2);
+			glm::vec3 tmax = glm::max(t1, t2);
+
+			float tnear = std::max<float>(std::max<float>(tmin.x, tmin.y), std::max<float>(tmin.z, 0.0f));
+			float tfar = std::min<float>(std::min<float>(tmax.x, tmax.y), std::min<float>(tmax.z, maxDist));
+
+			distHit = tnear;
+			return tnear <= tfar;
+		}
+
+		void BVH::Build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+		{
+			Clear();
+
+			uint32_t triCount = indices.size() / 3;
+			if (triCount == 0)
+				return;
+
+			std::vector<BuildTriangle> tris(triCount);
+			std::vector<uint32_t> ids(triCount);
+			for (uint32_t i = 0; i < triCount; i++) {
+				const glm::vec3& v0 = positions[indices[i * 3 + 0]];
+				const glm::vec3& v1 = positions[indices[i * 3 + 1]];
+				const glm::vec3& v2 = positions[indices[i * 3 + 2]];
+				tris[i].Min = glm::min(v0, glm::min(v1, v2));
+				tris[i].Max = glm::max(v0, glm::max(v1, v2));
+				tris[i].Center = (tris[i].Min + tris[i].Max) * 0.5f;
+				ids[i] = i;
+			}
+
+			m_nodes.reserve(triCount * 2 / 3 + 1);
+			m_build(tris, ids, 0, triCount);
+			m_nodes.shrink_to_fit();
+
+			// store the triangles in leaf order
+			m_positions = positions;
+			m_indices.resize(triCount * 3);
+			for (uint32_t i = 0; i < triCount; i++) {
+				m_indices[i * 3 + 0] = indices[ids[i] * 3 + 0];
+				m_indices[i * 3 + 1] = indices[ids[i] * 3 + 1];
+				m_indices[i * 3 + 2] = indices[ids[i] * 3 + 2];
+			}
+		}
+		void BVH::Clear()
+		{
+			m_nodes.clear();
+			m_positions.clear();
+			m_indices.clear();
+		}
+		uint32_t BVH::m_build(const std::vector<BuildTriangle>& tris, std::vector<uint32_t>& ids, uint32_t begin, uint32_t end)
+		{
+			uint32_t index = m_nodes.size();
+			m_nodes.push_back(Node());
+
+			glm::vec3 minb(std::numeric_limits<float>::infinity()), maxb(-std::numeric_limits<float>::infinity());
+			glm::vec3 minc = minb, maxc = maxb;
+			for (uint32_t i = begin; i < end; i++) {
+				const BuildTriangle& tri = tris[ids[i]];
+				minb = glm::min(minb, tri.Min);
+				maxb = glm::max(maxb, tri.Max);
+				minc = glm::min(minc, tri.Center);
+				maxc = glm::max(maxc, tri.Center);
+			}
+			m_nodes[index].Min = minb;
+			m_nodes[index].Max = maxb;
+
+			uint32_t count = end - begin;
+
+			// find the cheapest split: SAH cost of a split == area(left) * count(left) + area(right) * count(right),
+			// every split costs one extra node visit (area(parent) * 1)
+			int bestAxis = -1, bestBin = 0;
+			float bestCost = std::numeric_limits<float>::infinity();
+			if (count > 2) {
+				for (int axis = 0; axis < 3; axis++) {
+					float extent = maxc[axis] - minc[axis];
+					if (extent <= 0.0f)
+						continue;
+
+					uint32_t binCount[BVH_BIN_COUNT] = { 0 };
+					glm::vec3 binMin[BVH_BIN_COUNT], binMax[BVH_BIN_COUNT];
+					for (int b = 0; b < BVH_BIN_COUNT; b++) {
+						binMin[b] = glm::vec3(std::numeric_limits<float>::infinity());
+						binMax[b] = glm::vec3(-std::numeric_limits<float>::infinity());
+					}
+
+					float scale = BVH_BIN_COUNT / extent;
+					for (uint32_t i = begin; i < end; i++) {
+						const BuildTriangle& tri = tris[ids[i]];
+						int b = std::min<int>(BVH_BIN_COUNT - 1, (int)((tri.Center[axis] - minc[axis]) * scale));
+						binCount[b]++;
+						binMin[b] = glm::min(binMin[b], tri.Min);
+						binMax[b] = glm::max(binMax[b], tri.Max);
+					}
+
+					// sweep from the right to get the cost of everything right of a split
+					float rightCost[BVH_BIN_COUNT];
+					glm::vec3 rmin(std::numeric_limits<float>::infinity()), rmax(-std::numeric_limits<float>::infinity());
+					uint32_t rcount = 0;
+					for (int b = BVH_BIN_COUNT - 1; b > 0; b--) {
+						rmin = glm::min(rmin, binMin[b]);
+						rmax = glm::max(rmax, binMax[b]);
+						rcount += binCount[b];
+						rightCost[b] = rcount ? getHalfArea(rmin, rmax) * rcount : 0.0f;
+					}
+
+					// and from the left to combine them
+					glm::vec3 lmin(std::numeric_limits<float>::infinity()), lmax(-std::numeric_limits<float>::infinity());
+					uint32_t lcount = 0;
+					for (int b = 0; b < BVH_BIN_COUNT - 1; b++) {
+						lmin = glm::min(lmin, binMin[b]);
+						lmax = glm::max(lmax, binMax[b]);
+						lcount += binCount[b];
+						if (lcount == 0 || lcount == count)
+							continue;
+
+						float cost = getHalfArea(lmin, lmax) * lcount + rightCost[b + 1];
+						if (cost < bestCost) {
+							bestCost = cost;
+							bestAxis = axis;
+							bestBin = b;
+						}
+					}
+				}
+			}
+
+			float nodeArea = getHalfArea(minb, maxb);
+			bool makeLeaf = bestAxis == -1 || (count <= BVH_MAX_LEAF_SIZE && bestCost + nodeArea >= nodeArea * count);
+			if (makeLeaf) {
+				m_nodes[index].Offset = begin;
+				m_nodes[index].Count = count;
+				return index;
+			}
+
+			float scale = BVH_BIN_COUNT / (maxc[bestAxis] - minc[bestAxis]);
+			auto mid = std::partition(ids.begin() + begin, ids.begin() + end, [&](uint32_t id) {
+				return std::min<int>(BVH_BIN_COUNT - 1, (int)((tris[id].Center[bestAxis] - minc[bestAxis]) * scale)) <= bestBin;
+			});
+			uint32_t split = mid - ids.begin();
+
+			m_build(tris, ids, begin, split); // == index + 1
+			uint32_t second = m_build(tris, ids, split, end);
+
+			m_nodes[index].Offset = second;
+			m_nodes[index].Count = 0;
+
+			return index;
+		}
+		bool BVH::Intersect(const glm::vec3& origin, const glm::vec3& dir, float& distHit, float maxDist) const
+		{
+			if (m_nodes.empty())
+				return false;
+
+			glm::vec3 invDir = 1.0f / dir;
+			float nodeDist = 0.0f;
+
+			bool hit = false;
+			float closest = maxDist;
+
+			std::vector<uint32_t> stack;
+			stack.reserve(64);
+			stack.push_back(0);
+
+			while (!stack.empty()) {
+				uint32_t index = stack.back();
+				stack.pop_back();
+
+				const Node& node = m_nodes[index];
+				if (!intersectNode(node, origin, invDir, closest, nodeDist))
+					continue;
+
+				if (node.Count != 0) {
+					for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++) {
+						float triDist = 0.0f;
+						const uint32_t* tri = &m_indices[i * 3];
+						if (ray::IntersectTriangle(origin, dir, m_positions[tri[0]], m_positions[tri[1]], m_positions[tri[2]], triDist) && triDist < closest) {
+							closest = triDist;
+							hit = true;
+						}
+					}
+					continue;
+				}
+
+				// visit the closer child first so that the farther one can be skipped more often
+				uint32_t first = index + 1, second = node.Offset;
+				float firstDist = 0.0f, secondDist = 0.0f;
+				bool firstHit = intersectNode(m_nodes[first], origin, invDir, closest, firstDist);
+				bool secondHit = intersectNode(m_nodes[second], origin, invDir, closest, secondDist);
+
+				if (firstHit && secondHit) {
+					if (firstDist > secondDist)
+						std::swap(first, second);
+					stack.push_back(second);
+					stack.push_back(first);
+				} else if (firstHit)
+					stack.push_back(first);
+				else if (secondHit)
+					stack.push_back(second);
+			}
+
+			if (hit)
+				distHit = closest;
+
+			return hit;
+		}
+	}
+}
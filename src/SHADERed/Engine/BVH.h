@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+namespace ed {
+	namespace eng {
+		// bounding volume hierarchy over a list of triangles - built with binned SAH and stored as a flat
+		// array of nodes in depth-first order, used for ray picking
+		class BVH {
+		public:
+			// 32 bytes, two nodes per cache line. First child of an inner node is stored right after it,
+			// second one at Offset. Leaves hold Count triangles starting at triangle Offset
+			struct Node {
+				glm::vec3 Min;
+				uint32_t Offset;
+				glm::vec3 Max;
+				uint32_t Count; // 0 -> inner node
+			};
+
+			// 3 indices per triangle. Only the positions (12 bytes per vertex) and the reordered indices (12 bytes per
+			// triangle) are kept next to the nodes, so Model can free its Vertex arrays once they are uploaded
+			void Build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+			void Clear();
+
+			// dir doesn't have to be normalized - distHit is measured in multiples of dir. Only hits closer than maxDist are reported
+			bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float& distHit, float maxDist = std::numeric_limits<float>::infinity()) const;
+
+			inline bool IsEmpty() const { return m_nodes.empty(); }
+			inline const std::vector<Node>& GetNodes() const { return m_nodes; }
+
+		private:
+			struct BuildTriangle {
+				glm::vec3 Min, Max, Center;
+			};
+			uint32_t m_build(const std::vector<BuildTriangle>& tris, std::vector<uint32_t>& ids, uint32_t begin, uint32_t end);
+
+			std::vector<Node> m_nodes;
+			std::vector<glm::vec3> m_positions;
+			std::vector<uint32_t> m_indices; // reordered so that the triangles of a leaf are next to each other
+		};
+	}
+}
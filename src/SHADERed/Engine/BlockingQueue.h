@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace ed {
+	namespace eng {
+		// fixed capacity FIFO shared between threads - Push() waits while the queue is full, Pop()
+		// waits while it is empty. After Close(), Pop() returns false once the remaining items are taken
+		template <typename T>
+		class BlockingQueue {
+		public:
+			BlockingQueue(size_t capacity)
+					: m_capacity(capacity)
+					, m_closed(false)
+			{
+			}
+
+			void Push(const T& item)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_notFull.wait(lock, [&]() { return m_items.size() < m_capacity; });
+					m_items.push_back(item);
+				}
+				m_notEmpty.notify_one();
+			}
+			bool Pop(T& item)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_notEmpty.wait(lock, [&]() { return m_closed || !m_items.empty(); });
+
+					if (m_items.empty())
+						return false;
+
+					item = m_items.front();
+					m_items.pop_front();
+				}
+				m_notFull.notify_one();
+				return true;
+			}
+			void Close()
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_closed = true;
+				}
+				m_notEmpty.notify_all();
+			}
+
+		private:
+			std::deque<T> m_items;
+			size_t m_capacity;
+			bool m_closed;
+			std::mutex m_lock;
+			std::condition_variable m_notFull, m_notEmpty;
+		};
+	}
+}
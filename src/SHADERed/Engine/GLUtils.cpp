@@ -187,7 +187,8 @@ namespace ed {
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 
-		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO, GLuint bufVBO, std::vector<ed::ShaderVariable::ValueType> types)
+		// vertexFormat == nullptr -> geoVBO holds 18 floats per vertex (the built-in geometry layout)
+		static void createVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO, GLuint bufVBO, const std::vector<ed::ShaderVariable::ValueType>& types, const eng::Model::Mesh::VertexFormat* vertexFormat)
 		{
 			int fmtIndex = 0;
 
@@ -207,7 +208,11 @@ namespace ed {
 					offset = layOffset;
 
 				// vertex positions
-				glVertexAttribPointer(fmtIndex, size, GL_FLOAT, GL_FALSE, 18 * sizeof(float), (void*)offset);
+				if (vertexFormat != nullptr && layitem.Value < InputLayoutValue::BufferFloat) {
+					const auto& attr = vertexFormat->Attributes[(int)layitem.Value];
+					glVertexAttribPointer(fmtIndex, attr.Size, attr.Type, attr.Normalized, vertexFormat->Stride, (void*)(uintptr_t)attr.Offset);
+				} else
+					glVertexAttribPointer(fmtIndex, size, GL_FLOAT, GL_FALSE, vertexFormat ? vertexFormat->Stride : 18 * sizeof(float), (void*)offset);
 				glEnableVertexAttribArray(fmtIndex);
 				fmtIndex++;
 				layOffset += size;
@@ -257,6 +262,14 @@ namespace ed {
 			glBindVertexArray(0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
+		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO, GLuint bufVBO, std::vector<ed::ShaderVariable::ValueType> types)
+		{
+			createVAO(geoVAO, geoVBO, ilayout, geoEBO, bufVBO, types, nullptr);
+		}
+		void CreateVAO(eng::Model::Mesh& mesh, const std::vector<InputLayoutItem>& ilayout, GLuint bufVBO, std::vector<ed::ShaderVariable::ValueType> types)
+		{
+			createVAO(mesh.VAO, mesh.VBO, ilayout, mesh.EBO, bufVBO, types, &mesh.Format);
+		}
 		std::vector<InputLayoutItem> CreateDefaultInputLayout()
 		{
 			std::vector<InputLayoutItem> ret;
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace ed {
+	namespace eng {
+		// 64 bit FNV-1a - used to build keys for the on-disk caches, not meant to be cryptographically secure
+		const uint64_t HashSeed = 14695981039346656037ULL;
+
+		inline uint64_t Hash(const void* data, size_t size, uint64_t hash = HashSeed)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			for (size_t i = 0; i < size; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+		inline uint64_t Hash(const std::string& str, uint64_t hash = HashSeed)
+		{
+			return Hash(str.data(), str.size(), hash);
+		}
+		inline std::string HashToString(uint64_t hash)
+		{
+			static const char digits[] = "0123456789abcdef";
+			std::string ret(16, '0');
+			for (int i = 15; i >= 0; i--, hash >>= 4)
+				ret[i] = digits[hash & 0xF];
+			return ret;
+		}
+	}
+}
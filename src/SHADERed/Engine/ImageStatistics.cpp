@@ -0,0 +1,341 @@
+#include <SHADERed/Engine/ImageStatistics.h>
+#include <SHADERed/Engine/GLUtils.h>
+#include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/Profiler.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <string.h>
+
+static const char* StatisticsShaderCode = R"(
+#version 430
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0) uniform sampler2D tex;
+uniform ivec2 size;
+
+struct Partial {
+	float sum[5];
+	float minValue[5];
+	float maxValue[5];
+	uint pixelCount, nanCount, infCount, invalidCount;
+};
+
+layout(std430, binding = 0) buffer HistogramBuffer { uint histogram[5 * 256]; };
+layout(std430, binding = 1) buffer PartialBuffer { Partial partials[]; };
+
+shared uint sHistogram[5 * 256];
+shared vec4 sSum[256], sMin[256], sMax[256];
+shared vec3 sLum[256]; // sum, min, max
+shared uvec4 sCount[256]; // pixels, NaN, Inf, invalid
+
+void main()
+{
+	uint id = gl_LocalInvocationIndex;
+	for (uint i = id; i < 5u * 256u; i += 256u)
+		sHistogram[i] = 0u;
+	barrier();
+
+	vec4 sum = vec4(0.0), minValue = vec4(3.4e38), maxValue = vec4(-3.4e38);
+	vec3 lum = vec3(0.0, 3.4e38, -3.4e38);
+	uvec4 count = uvec4(0u);
+
+	// every work group loops over a part of the image so that only a few partial results are written
+	ivec2 stride = ivec2(gl_NumWorkGroups.xy * gl_WorkGroupSize.xy);
+	for (int y = int(gl_GlobalInvocationID.y); y < size.y; y += stride.y) {
+		for (int x = int(gl_GlobalInvocationID.x); x < size.x; x += stride.x) {
+			vec4 px = texelFetch(tex, ivec2(x, y), 0);
+			bool hasNaN = any(isnan(px)), hasInf = any(isinf(px));
+
+			count += uvec4(1u, uint(hasNaN), uint(hasInf), uint(hasNaN || hasInf));
+			if (hasNaN || hasInf)
+				continue;
+
+			float l = dot(px.rgb, vec3(0.2126, 0.7152, 0.0722));
+
+			sum += px;
+			minValue = min(minValue, px);
+			maxValue = max(maxValue, px);
+			lum = vec3(lum.x + l, min(lum.y, l), max(lum.z, l));
+
+			uvec4 bin = uvec4(clamp(px, 0.0, 1.0) * 255.0 + 0.5);
+			atomicAdd(sHistogram[bin.r], 1u);
+			atomicAdd(sHistogram[256u + bin.g], 1u);
+			atomicAdd(sHistogram[512u + bin.b], 1u);
+			atomicAdd(sHistogram[768u + bin.a], 1u);
+			atomicAdd(sHistogram[1024u + uint(clamp(l, 0.0, 1.0) * 255.0 + 0.5)], 1u);
+		}
+	}
+
+	sSum[id] = sum;
+	sMin[id] = minValue;
+	sMax[id] = maxValue;
+	sLum[id] = lum;
+	sCount[id] = count;
+	barrier();
+
+	for (uint s = 128u; s > 0u; s >>= 1u) {
+		if (id < s) {
+			sSum[id] += sSum[id + s];
+			sMin[id] = min(sMin[id], sMin[id + s]);
+			sMax[id] = max(sMax[id], sMax[id + s]);
+			sLum[id] = vec3(sLum[id].x + sLum[id + s].x, min(sLum[id].y, sLum[id + s].y), max(sLum[id].z, sLum[id + s].z));
+			sCount[id] += sCount[id + s];
+		}
+		barrier();
+	}
+
+	if (id == 0u) {
+		uint group = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+		for (int i = 0; i < 4; i++) {
+			partials[group].sum[i] = sSum[0][i];
+			partials[group].minValue[i] = sMin[0][i];
+			partials[group].maxValue[i] = sMax[0][i];
+		}
+		partials[group].sum[4] = sLum[0].x;
+		partials[group].minValue[4] = sLum[0].y;
+		partials[group].maxValue[4] = sLum[0].z;
+		partials[group].pixelCount = sCount[0].x;
+		partials[group].nanCount = sCount[0].y;
+		partials[group].infCount = sCount[0].z;
+		partials[group].invalidCount = sCount[0].w;
+	}
+
+	for (uint i = id; i < 5u * 256u; i += 256u)
+		if (sHistogram[i] != 0u)
+			atomicAdd(histogram[i], sHistogram[i]);
+}
+)";
+
+namespace ed {
+	namespace eng {
+		static int getBin(float value)
+		{
+			// same rounding as the float -> unorm8 conversion
+			return (int)(std::min<float>(std::max<float>(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+
+		ImageStatistics::ImageStatistics()
+		{
+			m_initialized = false;
+			m_program = 0;
+			m_histogramBuffer = m_partialBuffer = 0;
+			m_fbo = 0;
+			m_pool = nullptr;
+		}
+		ImageStatistics::~ImageStatistics()
+		{
+			if (m_program != 0) {
+				glDeleteProgram(m_program);
+				glDeleteBuffers(1, &m_histogramBuffer);
+				glDeleteBuffers(1, &m_partialBuffer);
+			}
+			if (m_fbo != 0)
+				glDeleteFramebuffers(1, &m_fbo);
+
+			delete m_pool;
+		}
+
+		void ImageStatistics::Compute(GLuint texture, int width, int height, Result& result)
+		{
+			ProfileScope statsScope("Image statistics", true);
+
+			memset(&result, 0, sizeof(Result));
+			if (width <= 0 || height <= 0)
+				return;
+
+			if (!m_initialized)
+				m_init();
+
+			if (m_program != 0)
+				m_computeGPU(texture, width, height, result);
+			else
+				m_computeCPU(texture, width, height, result);
+		}
+
+		void ImageStatistics::m_init()
+		{
+			m_initialized = true;
+
+			if (!GLEW_ARB_compute_shader || !GLEW_ARB_shader_storage_buffer_object) {
+				glGenFramebuffers(1, &m_fbo);
+				return;
+			}
+
+			GLchar msg[1024] = { 0 };
+			GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, StatisticsShaderCode);
+			if (!gl::CheckShaderCompilationStatus(cs, msg)) {
+				Logger::Get().Log("Failed to compile the image statistics shader, falling back to the CPU", true);
+				glDeleteShader(cs);
+				glGenFramebuffers(1, &m_fbo);
+				return;
+			}
+
+			m_program = glCreateProgram();
+			glAttachShader(m_program, cs);
+			glLinkProgram(m_program);
+			glDeleteShader(cs);
+
+			glGenBuffers(1, &m_histogramBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_histogramBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Result::Histogram), nullptr, GL_DYNAMIC_READ);
+
+			glGenBuffers(1, &m_partialBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_partialBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, IMAGE_STATISTICS_GROUPS * IMAGE_STATISTICS_GROUPS * sizeof(Partial), nullptr, GL_DYNAMIC_READ);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+		void ImageStatistics::m_computeGPU(GLuint texture, int width, int height, Result& result)
+		{
+			// work groups add their histograms to this one
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_histogramBuffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Result::Histogram), result.Histogram); // result is zeroed
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			glUseProgram(m_program);
+			glUniform2i(glGetUniformLocation(m_program, "size"), width, height);
+
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_histogramBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_partialBuffer);
+
+			glDispatchCompute(IMAGE_STATISTICS_GROUPS, IMAGE_STATISTICS_GROUPS, 1);
+			glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glUseProgram(0);
+
+			// only the results are copied back
+			Partial partials[IMAGE_STATISTICS_GROUPS * IMAGE_STATISTICS_GROUPS];
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_histogramBuffer);
+			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Result::Histogram), result.Histogram);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_partialBuffer);
+			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(partials), partials);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			double sum[ChannelCount] = { 0.0 };
+			uint64_t invalid = 0;
+			for (int c = 0; c < ChannelCount; c++) {
+				result.Min[c] = FLT_MAX;
+				result.Max[c] = -FLT_MAX;
+			}
+			for (const Partial& partial : partials) {
+				for (int c = 0; c < ChannelCount; c++) {
+					sum[c] += partial.Sum[c];
+					result.Min[c] = std::min<float>(result.Min[c], partial.Min[c]);
+					result.Max[c] = std::max<float>(result.Max[c], partial.Max[c]);
+				}
+				result.PixelCount += partial.PixelCount;
+				result.NaNCount += partial.NaNCount;
+				result.InfCount += partial.InfCount;
+				invalid += partial.InvalidCount;
+			}
+
+			uint64_t valid = result.PixelCount - invalid;
+			for (int c = 0; c < ChannelCount; c++) {
+				result.Mean[c] = valid > 0 ? sum[c] / valid : 0.0f;
+				if (valid == 0)
+					result.Min[c] = result.Max[c] = 0.0f;
+			}
+		}
+		void ImageStatistics::m_computeCPU(GLuint texture, int width, int height, Result& result)
+		{
+			struct Worker {
+				uint32_t Histogram[ChannelCount][IMAGE_STATISTICS_BINS];
+				double Sum[ChannelCount];
+				float Min[ChannelCount], Max[ChannelCount];
+				uint64_t NaNCount, InfCount, InvalidCount;
+			};
+
+			// calling thread is also used as a worker
+			if (m_pool == nullptr)
+				m_pool = new ThreadPool(std::max<int>(1, std::thread::hardware_concurrency()) - 1);
+			int workerCount = m_pool->GetThreadCount() + 1;
+
+			std::vector<Worker> workers(workerCount);
+			for (Worker& worker : workers) {
+				memset(&worker, 0, sizeof(Worker));
+				for (int c = 0; c < ChannelCount; c++) {
+					worker.Min[c] = FLT_MAX;
+					worker.Max[c] = -FLT_MAX;
+				}
+			}
+
+			// read a few rows at a time instead of copying the whole texture
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+			m_strip.resize(width * IMAGE_STATISTICS_STRIP_HEIGHT * 4);
+			for (int startY = 0; startY < height; startY += IMAGE_STATISTICS_STRIP_HEIGHT) {
+				int rows = std::min<int>(IMAGE_STATISTICS_STRIP_HEIGHT, height - startY);
+				glReadPixels(0, startY, width, rows, GL_RGBA, GL_FLOAT, m_strip.data());
+
+				m_pool->ParallelFor(rows, [&](size_t row, size_t workerIndex) {
+					Worker& worker = workers[workerIndex];
+					const float* px = &m_strip[row * width * 4];
+
+					// row sums are kept in float, everything above in double
+					float sum[ChannelCount] = { 0.0f };
+					for (int x = 0; x < width; x++, px += 4) {
+						bool hasNaN = std::isnan(px[0]) || std::isnan(px[1]) || std::isnan(px[2]) || std::isnan(px[3]);
+						bool hasInf = std::isinf(px[0]) || std::isinf(px[1]) || std::isinf(px[2]) || std::isinf(px[3]);
+						if (hasNaN || hasInf) {
+							worker.NaNCount += hasNaN;
+							worker.InfCount += hasInf;
+							worker.InvalidCount++;
+							continue;
+						}
+
+						float values[ChannelCount] = { px[0], px[1], px[2], px[3], 0.2126f * px[0] + 0.7152f * px[1] + 0.0722f * px[2] };
+						for (int c = 0; c < ChannelCount; c++) {
+							sum[c] += values[c];
+							worker.Min[c] = std::min<float>(worker.Min[c], values[c]);
+							worker.Max[c] = std::max<float>(worker.Max[c], values[c]);
+							worker.Histogram[c][getBin(values[c])]++;
+						}
+					}
+
+					for (int c = 0; c < ChannelCount; c++)
+						worker.Sum[c] += sum[c];
+				});
+			}
+
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+			// merge the results
+			double sum[ChannelCount] = { 0.0 };
+			uint64_t invalid = 0;
+			for (int c = 0; c < ChannelCount; c++) {
+				result.Min[c] = FLT_MAX;
+				result.Max[c] = -FLT_MAX;
+			}
+			for (const Worker& worker : workers) {
+				for (int c = 0; c < ChannelCount; c++) {
+					for (int i = 0; i < IMAGE_STATISTICS_BINS; i++)
+						result.Histogram[c][i] += worker.Histogram[c][i];
+					sum[c] += worker.Sum[c];
+					result.Min[c] = std::min<float>(result.Min[c], worker.Min[c]);
+					result.Max[c] = std::max<float>(result.Max[c], worker.Max[c]);
+				}
+				result.NaNCount += worker.NaNCount;
+				result.InfCount += worker.InfCount;
+				invalid += worker.InvalidCount;
+			}
+
+			result.PixelCount = (uint64_t)width * height;
+
+			uint64_t valid = result.PixelCount - invalid;
+			for (int c = 0; c < ChannelCount; c++) {
+				result.Mean[c] = valid > 0 ? sum[c] / valid : 0.0f;
+				if (valid == 0)
+					result.Min[c] = result.Max[c] = 0.0f;
+			}
+		}
+	}
+}
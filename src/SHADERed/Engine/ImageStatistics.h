@@ -0,0 +1,68 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <SHADERed/Engine/ThreadPool.h>
+#include <stdint.h>
+#include <vector>
+
+#define IMAGE_STATISTICS_BINS 256
+#define IMAGE_STATISTICS_GROUPS 8	  // compute shader runs 8x8 work groups that loop over the image
+#define IMAGE_STATISTICS_STRIP_HEIGHT 64 // rows read back at once when compute shaders aren't supported
+
+namespace ed {
+	namespace eng {
+		// histograms & min/max/mean of a 2D texture. With compute shaders only the results (a few KB) are
+		// copied to the CPU, otherwise the texture is read in strips of rows and processed on multiple threads
+		class ImageStatistics {
+		public:
+			enum Channel {
+				Red,
+				Green,
+				Blue,
+				Alpha,
+				Luminance, // Rec. 709
+				ChannelCount
+			};
+
+			struct Result {
+				uint32_t Histogram[ChannelCount][IMAGE_STATISTICS_BINS]; // values are clamped to [0, 1]
+				float Min[ChannelCount], Max[ChannelCount], Mean[ChannelCount];
+				uint64_t PixelCount;
+				uint64_t NaNCount, InfCount; // pixels with at least one NaN/Inf component - these are left out of everything else
+			};
+
+			ImageStatistics();
+			~ImageStatistics();
+
+			void Compute(GLuint texture, int width, int height, Result& result);
+			inline bool IsComputeSupported() { return m_program != 0; } // only valid after the first Compute()
+
+		private:
+			// per work group / per worker results
+			struct Partial {
+				float Sum[ChannelCount];
+				float Min[ChannelCount];
+				float Max[ChannelCount];
+				uint32_t PixelCount, NaNCount, InfCount, InvalidCount;
+			};
+
+			void m_init();
+			void m_computeGPU(GLuint texture, int width, int height, Result& result);
+			void m_computeCPU(GLuint texture, int width, int height, Result& result);
+
+			bool m_initialized;
+			GLuint m_program, m_histogramBuffer, m_partialBuffer;
+			GLuint m_fbo;
+
+			ThreadPool* m_pool;
+			std::vector<float> m_strip;
+		};
+	}
+}
@@ -1,5 +1,7 @@
 #include <SHADERed/Engine/Model.h>
+#include <SHADERed/Engine/Hash.h>
 #include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/Settings.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,7 +13,22 @@
 #include <GL/gl.h>
 #endif
 
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+#define MODEL_CACHE_VERSION 1
+#define MODEL_CACHE_MAX_SIZE 512	  // MB - least recently used files in cache/models are removed above this
+#define MODEL_CACHE_PRUNE_INTERVAL 16 // cache/models is only scanned every N writes
 
 namespace ed {
 	namespace eng {
@@ -21,36 +38,158 @@ namespace ed {
 			Vertices = vertices;
 			Indices = indices;
 			Textures = textures;
-			m_setup();
+			VAO = VBO = EBO = 0;
+			VertexCount = vertices.size();
+		}
+		void Model::Mesh::m_buildFormat(bool compact)
+		{
+			static const int components[6] = { 3, 3, 2, 3, 3, 4 };
+
+			// check which attributes fit in a smaller type without losing anything: normals, tangents
+			// and binormals need every component in [-1, 1], texcoords and colors in [0, 1]
+			bool unitNormal = true, unitTangent = true, unitBinormal = true;
+			bool unitUV = true, unitColor = true;
+			if (compact) {
+				for (const auto& vert : Vertices) {
+					for (int i = 0; i < 3; i++) {
+						unitNormal &= std::abs(vert.Normal[i]) <= 1.0f;
+						unitTangent &= std::abs(vert.Tangent[i]) <= 1.0f;
+						unitBinormal &= std::abs(vert.Binormal[i]) <= 1.0f;
+					}
+					for (int i = 0; i < 2; i++)
+						unitUV &= vert.TexCoords[i] >= 0.0f && vert.TexCoords[i] <= 1.0f;
+					for (int i = 0; i < 4; i++)
+						unitColor &= vert.Color[i] >= 0.0f && vert.Color[i] <= 1.0f;
+				}
+			}
+			bool packed[6] = { false, compact && unitNormal, compact && unitUV, compact && unitTangent, compact && unitBinormal, compact && unitColor };
+
+			unsigned int offset = 0;
+			for (int i = 0; i < 6; i++) {
+				VertexAttribute& attr = Format.Attributes[i];
+				attr.Offset = offset;
+
+				if (!packed[i]) {
+					attr.Type = GL_FLOAT;
+					attr.Size = components[i];
+					attr.Normalized = false;
+					offset += components[i] * sizeof(float);
+				} else if (components[i] == 3) {
+					attr.Type = GL_INT_2_10_10_10_REV;
+					attr.Size = 4;
+					attr.Normalized = true;
+					offset += sizeof(uint32_t);
+				} else if (components[i] == 2) {
+					attr.Type = GL_UNSIGNED_SHORT;
+					attr.Size = 2;
+					attr.Normalized = true;
+					offset += 2 * sizeof(uint16_t);
+				} else {
+					attr.Type = GL_UNSIGNED_BYTE;
+					attr.Size = 4;
+					attr.Normalized = true;
+					offset += 4 * sizeof(uint8_t);
+				}
+			}
+			Format.Stride = offset;
 		}
-		void Model::Mesh::m_setup()
+		void Model::Mesh::Upload(bool compact, bool keepVertices)
 		{
+			VertexCount = Vertices.size();
+			m_buildFormat(compact);
+
 			glGenVertexArrays(1, &VAO);
 			glGenBuffers(1, &VBO);
 			glGenBuffers(1, &EBO);
 			glBindVertexArray(VAO);
 
 			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), &Vertices[0],
-				GL_STATIC_DRAW);
+			if (!compact)
+				glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(), GL_STATIC_DRAW);
+			else {
+				std::vector<unsigned char> data(VertexCount * Format.Stride);
+				for (size_t v = 0; v < VertexCount; v++) {
+					const Vertex& vert = Vertices[v];
+					const float* src[6] = { &vert.Position.x, &vert.Normal.x, &vert.TexCoords.x, &vert.Tangent.x, &vert.Binormal.x, &vert.Color.x };
+
+					for (int i = 0; i < 6; i++) {
+						const VertexAttribute& attr = Format.Attributes[i];
+						unsigned char* dst = data.data() + v * Format.Stride + attr.Offset;
+
+						uint32_t bits = 0;
+						if (attr.Type == GL_FLOAT) {
+							memcpy(dst, src[i], attr.Size * sizeof(float));
+							continue;
+						} else if (attr.Type == GL_INT_2_10_10_10_REV) // w = 1, like the default for an unpacked vec3 attribute
+							bits = glm::packSnorm3x10_1x2(glm::vec4(src[i][0], src[i][1], src[i][2], 1.0f));
+						else if (attr.Type == GL_UNSIGNED_SHORT)
+							bits = glm::packUnorm2x16(glm::vec2(src[i][0], src[i][1]));
+						else
+							bits = glm::packUnorm4x8(glm::vec4(src[i][0], src[i][1], src[i][2], src[i][3]));
+						memcpy(dst, &bits, sizeof(uint32_t));
+					}
+				}
+				glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+			}
 
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int),
-				&Indices[0], GL_STATIC_DRAW);
+				Indices.data(), GL_STATIC_DRAW);
 
-			// vertex positions
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Model::Mesh::Vertex), (void*)0);
-			glEnableVertexAttribArray(0);
+			// vertex positions, normals & texture coords
+			for (int i = 0; i < 3; i++) {
+				const VertexAttribute& attr = Format.Attributes[i];
+				glVertexAttribPointer(i, attr.Size, attr.Type, attr.Normalized, Format.Stride, (void*)(uintptr_t)attr.Offset);
+				glEnableVertexAttribArray(i);
+			}
 
-			// vertex normals
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Model::Mesh::Vertex), (void*)offsetof(Vertex, Normal));
-			glEnableVertexAttribArray(1);
+			glBindVertexArray(0);
 
-			// vertex texture coords
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Model::Mesh::Vertex), (void*)offsetof(Vertex, TexCoords));
-			glEnableVertexAttribArray(2);
+			if (!keepVertices)
+				std::vector<Vertex>().swap(Vertices);
+		}
+		void Model::Mesh::RestoreVertices()
+		{
+			if (Vertices.size() == VertexCount || VBO == 0)
+				return;
 
-			glBindVertexArray(0);
+			std::vector<unsigned char> data(VertexCount * Format.Stride);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, data.size(), data.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			Vertices.resize(VertexCount);
+			for (size_t v = 0; v < VertexCount; v++) {
+				Vertex& vert = Vertices[v];
+				float* dst[6] = { &vert.Position.x, &vert.Normal.x, &vert.TexCoords.x, &vert.Tangent.x, &vert.Binormal.x, &vert.Color.x };
+
+				for (int i = 0; i < 6; i++) {
+					const VertexAttribute& attr = Format.Attributes[i];
+					const unsigned char* src = data.data() + v * Format.Stride + attr.Offset;
+
+					uint32_t bits = 0;
+					if (attr.Type == GL_FLOAT) {
+						memcpy(dst[i], src, attr.Size * sizeof(float));
+						continue;
+					}
+					memcpy(&bits, src, sizeof(uint32_t));
+
+					if (attr.Type == GL_INT_2_10_10_10_REV) {
+						glm::vec4 val = glm::unpackSnorm3x10_1x2(bits);
+						dst[i][0] = val.x;
+						dst[i][1] = val.y;
+						dst[i][2] = val.z;
+					} else if (attr.Type == GL_UNSIGNED_SHORT) {
+						glm::vec2 val = glm::unpackUnorm2x16(bits);
+						dst[i][0] = val.x;
+						dst[i][1] = val.y;
+					} else {
+						glm::vec4 val = glm::unpackUnorm4x8(bits);
+						for (int c = 0; c < 4; c++)
+							dst[i][c] = val[c];
+					}
+				}
+			}
 		}
 		void Model::Mesh::Draw(bool instanced, int iCount)
 		{
@@ -73,12 +212,35 @@ namespace ed {
 		}
 
 		bool Model::LoadFromFile(const std::string& path)
+		{
+			if (!Import(path))
+				return false;
+
+			Upload();
+
+			return true;
+		}
+		bool Model::Import(const std::string& path)
 		{
 			ed::Logger::Get().Log("Loading a 3D model from file \"" + path + "\"");
 
+			// skip Assimp if this exact file was already imported before
+			std::string cachePath = m_getCachePath(path);
+			if (!cachePath.empty() && m_loadCache(cachePath)) {
+				ed::Logger::Get().Log("Loaded the model from cache \"" + cachePath + "\"");
+
+				// mark the file as recently used so that it's the last one to be evicted
+				std::error_code errCode;
+				std::filesystem::last_write_time(cachePath, std::filesystem::file_time_type::clock::now(), errCode);
+
+				Directory = path.substr(0, path.find_last_of("/\\"));
+				m_buildBVH();
+				return true;
+			}
+
 			// read file via ASSIMP
 			Assimp::Importer importer;
-			const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+			const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
 
 			// check for errors
 			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
@@ -91,9 +253,189 @@ namespace ed {
 			m_processNode(scene->mRootNode, scene);
 
 			m_findBounds();
+			m_buildBVH();
+
+			if (!cachePath.empty()) {
+				m_saveCache(cachePath);
+
+				static std::atomic<uint32_t> writeCount(0);
+				if (writeCount++ % MODEL_CACHE_PRUNE_INTERVAL == 0)
+					m_pruneCache(std::filesystem::path(cachePath).parent_path().string());
+			}
 
 			return true;
 		}
+		void Model::Upload(bool compact, bool keepVertices)
+		{
+			for (auto& mesh : Meshes)
+				mesh.Upload(compact, keepVertices);
+		}
+		std::string Model::m_getCachePath(const std::string& path)
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file.is_open())
+				return "";
+
+			std::vector<char> data((size_t)file.tellg());
+			file.seekg(0);
+			file.read(data.data(), data.size());
+			if (!file)
+				return "";
+
+			// key: file contents + everything that changes the processed output
+			uint32_t params[3] = { MODEL_CACHE_VERSION, MODEL_IMPORT_FLAGS, sizeof(Mesh::Vertex) };
+			uint64_t hash = eng::Hash(params, sizeof(params));
+			hash = eng::Hash(data.data(), data.size(), hash);
+
+			// some formats keep the geometry (or the material list that meshes are split by) in other files (.gltf -> .bin,
+			// .obj -> .mtl, ...) - the references aren't parsed here, the name, size & modification time of every file
+			// next to the model is part of the key instead
+			std::string ext = std::filesystem::path(path).extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			if (ext == ".gltf" || ext == ".obj" || ext == ".dae" || ext == ".x3d" || ext == ".3mf") {
+				std::error_code errCode;
+				std::vector<std::string> siblings;
+				for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(path).parent_path(), errCode))
+					if (entry.is_regular_file(errCode))
+						siblings.push_back(entry.path().filename().string());
+				std::sort(siblings.begin(), siblings.end()); // directory order isn't guaranteed
+
+				std::filesystem::path dir = std::filesystem::path(path).parent_path();
+				for (const auto& sibling : siblings) {
+					uint64_t info[2] = {
+						(uint64_t)std::filesystem::file_size(dir / sibling, errCode),
+						(uint64_t)std::filesystem::last_write_time(dir / sibling, errCode).time_since_epoch().count()
+					};
+					hash = eng::Hash(sibling, hash);
+					hash = eng::Hash(info, sizeof(info), hash);
+				}
+			}
+
+			return Settings::Instance().ConvertPath("cache/models/" + eng::HashToString(hash) + ".mesh");
+		}
+		/*
+			cache file layout:
+				char[4] "SEDM"; uint32 version; uint32 meshCount; vec3 minBound, maxBound
+				for each mesh: uint32 nameLength; char[nameLength] name; uint32 vertexCount, indexCount; Vertex[vertexCount]; uint32[indexCount]
+		*/
+		bool Model::m_loadCache(const std::string& cachePath)
+		{
+			FILE* file = fopen(cachePath.c_str(), "rb");
+			if (file == nullptr)
+				return false;
+
+			char magic[4] = { 0 };
+			uint32_t version = 0, meshCount = 0;
+			bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "SEDM", 4) == 0;
+			ok = ok && fread(&version, sizeof(uint32_t), 1, file) == 1 && version == MODEL_CACHE_VERSION;
+			ok = ok && fread(&meshCount, sizeof(uint32_t), 1, file) == 1;
+			ok = ok && fread(&m_minBound, sizeof(glm::vec3), 1, file) == 1;
+			ok = ok && fread(&m_maxBound, sizeof(glm::vec3), 1, file) == 1;
+
+			for (uint32_t i = 0; ok && i < meshCount; i++) {
+				uint32_t nameLength = 0, vertexCount = 0, indexCount = 0;
+				std::string name;
+
+				ok = fread(&nameLength, sizeof(uint32_t), 1, file) == 1;
+				if (ok) {
+					name.resize(nameLength);
+					ok = fread(&name[0], 1, nameLength, file) == nameLength;
+				}
+				ok = ok && fread(&vertexCount, sizeof(uint32_t), 1, file) == 1;
+				ok = ok && fread(&indexCount, sizeof(uint32_t), 1, file) == 1;
+				if (!ok)
+					break;
+
+				// read straight into the mesh's arrays
+				Meshes.push_back(Mesh(name, std::vector<Mesh::Vertex>(), std::vector<unsigned int>(), std::vector<Mesh::Texture>()));
+				Mesh& mesh = Meshes.back();
+				mesh.Vertices.resize(vertexCount);
+				mesh.Indices.resize(indexCount);
+
+				ok = fread(mesh.Vertices.data(), sizeof(Mesh::Vertex), vertexCount, file) == vertexCount;
+				ok = ok && fread(mesh.Indices.data(), sizeof(unsigned int), indexCount, file) == indexCount;
+			}
+
+			fclose(file);
+
+			if (!ok)
+				Meshes.clear();
+
+			return ok;
+		}
+		void Model::m_saveCache(const std::string& cachePath)
+		{
+			std::error_code errCode;
+			std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), errCode);
+
+			// write to a temporary file first so that a half written cache is never picked up - models are loaded
+			// from multiple threads, give each writer its own temporary file
+			std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+			FILE* file = fopen(tempPath.c_str(), "wb");
+			if (file == nullptr)
+				return;
+
+			uint32_t version = MODEL_CACHE_VERSION, meshCount = Meshes.size();
+			fwrite("SEDM", 1, 4, file);
+			fwrite(&version, sizeof(uint32_t), 1, file);
+			fwrite(&meshCount, sizeof(uint32_t), 1, file);
+			fwrite(&m_minBound, sizeof(glm::vec3), 1, file);
+			fwrite(&m_maxBound, sizeof(glm::vec3), 1, file);
+
+			for (const auto& mesh : Meshes) {
+				uint32_t nameLength = mesh.Name.size(), vertexCount = mesh.Vertices.size(), indexCount = mesh.Indices.size();
+				fwrite(&nameLength, sizeof(uint32_t), 1, file);
+				fwrite(mesh.Name.data(), 1, nameLength, file);
+				fwrite(&vertexCount, sizeof(uint32_t), 1, file);
+				fwrite(&indexCount, sizeof(uint32_t), 1, file);
+				fwrite(mesh.Vertices.data(), sizeof(Mesh::Vertex), vertexCount, file);
+				fwrite(mesh.Indices.data(), sizeof(unsigned int), indexCount, file);
+			}
+
+			bool failed = ferror(file) != 0;
+			fclose(file);
+
+			if (failed)
+				std::filesystem::remove(tempPath, errCode);
+			else
+				std::filesystem::rename(tempPath, cachePath, errCode);
+		}
+		void Model::m_pruneCache(const std::string& cacheDir)
+		{
+			// another thread is already doing this
+			static std::mutex pruneLock;
+			std::unique_lock<std::mutex> lock(pruneLock, std::try_to_lock);
+			if (!lock.owns_lock())
+				return;
+
+			struct CacheFile {
+				std::filesystem::path Path;
+				std::filesystem::file_time_type Time;
+				uintmax_t Size;
+			};
+
+			std::error_code errCode;
+			std::vector<CacheFile> files;
+			uintmax_t total = 0;
+			for (const auto& entry : std::filesystem::directory_iterator(cacheDir, errCode)) {
+				if (!entry.is_regular_file(errCode) || entry.path().extension() != ".mesh")
+					continue;
+
+				CacheFile file = { entry.path(), entry.last_write_time(errCode), entry.file_size(errCode) };
+				total += file.Size;
+				files.push_back(file);
+			}
+
+			const uintmax_t maxSize = (uintmax_t)MODEL_CACHE_MAX_SIZE * 1024 * 1024;
+			if (total <= maxSize)
+				return;
+
+			// oldest first - a cache hit refreshes the modification time
+			std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.Time < b.Time; });
+			for (size_t i = 0; i < files.size() && total > maxSize; i++)
+				if (std::filesystem::remove(files[i].Path, errCode))
+					total -= files[i].Size;
+		}
 		void Model::m_findBounds()
 		{
 			m_minBound = glm::vec3(std::numeric_limits<float>::infinity());
@@ -110,6 +452,30 @@ namespace ed {
 				}
 			}
 		}
+		void Model::m_buildBVH()
+		{
+			size_t vertexCount = 0, indexCount = 0;
+			for (const auto& mesh : Meshes) {
+				vertexCount += mesh.Vertices.size();
+				indexCount += mesh.Indices.size() / 3 * 3;
+			}
+
+			// every mesh's indices are offset by the number of vertices before it
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+			positions.reserve(vertexCount);
+			indices.reserve(indexCount);
+			for (const auto& mesh : Meshes) {
+				uint32_t base = positions.size();
+				for (const auto& vert : mesh.Vertices)
+					positions.push_back(vert.Position);
+				for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+					for (int j = 0; j < 3; j++)
+						indices.push_back(base + mesh.Indices[i + j]);
+			}
+
+			m_bvh.Build(positions, indices);
+		}
 		std::vector<std::string> Model::GetMeshNames()
 		{
 			std::vector<std::string> ret;
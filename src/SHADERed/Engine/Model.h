@@ -2,6 +2,7 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
+#include <SHADERed/Engine/BVH.h>
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
@@ -25,6 +26,18 @@ namespace ed {
 					std::string Type;
 				};
 
+				// how a single attribute is stored in the VBO
+				struct VertexAttribute {
+					unsigned int Type; // GL_FLOAT, GL_INT_2_10_10_10_REV, ...
+					int Size;
+					bool Normalized;
+					unsigned int Offset;
+				};
+				struct VertexFormat {
+					VertexAttribute Attributes[6]; // same order as InputLayoutValue: Position, Normal, Texcoord, Tangent, Binormal, Color
+					int Stride;
+				};
+
 				std::string Name;
 
 				std::vector<Vertex> Vertices;
@@ -35,10 +48,19 @@ namespace ed {
 
 				void Draw(bool instanced = false, int iCount = 0);
 
+				// create VAO, VBO & EBO - must be called on the GL thread. compact == false uploads the Vertex
+				// structs as they are, keepVertices == false frees Vertices once they are in the VBO
+				void Upload(bool compact = true, bool keepVertices = true);
+
+				// bring back Vertices (read from the VBO) if they were freed by Upload()
+				void RestoreVertices();
+
 				unsigned int VAO, VBO, EBO;
+				VertexFormat Format;
+				size_t VertexCount;
 
 			private:
-				void m_setup();
+				void m_buildFormat(bool compact);
 			};
 
 			~Model();
@@ -48,16 +70,32 @@ namespace ed {
 
 			std::vector<std::string> GetMeshNames();
 			bool LoadFromFile(const std::string& path);
+
+			// LoadFromFile() split in two: Import() only touches the CPU side so it can run on any thread
+			bool Import(const std::string& path);
+			void Upload(bool compact = true, bool keepVertices = true);
 			void Draw(bool instanced = false, int iCount = 0);
 			void Draw(const std::string& mesh);
 
 			inline glm::vec3 GetMinBound() { return m_minBound; }
 			inline glm::vec3 GetMaxBound() { return m_maxBound; }
 
+			// closest hit of a model space ray with the model's triangles - works even after Upload() freed the vertices
+			inline bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float& distHit, float maxDist = std::numeric_limits<float>::infinity()) const { return m_bvh.Intersect(origin, dir, distHit, maxDist); }
+			inline const BVH& GetBVH() const { return m_bvh; }
+
 		private:
 			void m_findBounds();
+			void m_buildBVH();
+
+			// processed meshes are cached on disk, keyed on the file's contents (and its neighbours for multi-file formats)
+			std::string m_getCachePath(const std::string& path);
+			bool m_loadCache(const std::string& cachePath);
+			void m_saveCache(const std::string& cachePath);
+			static void m_pruneCache(const std::string& cacheDir);
 
 			glm::vec3 m_minBound, m_maxBound;
+			BVH m_bvh;
 			void m_processNode(aiNode* node, const aiScene* scene);
 			Model::Mesh m_processMesh(aiMesh* mesh, const aiScene* scene);
 		};
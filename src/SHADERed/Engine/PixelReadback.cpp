@@ -0,0 +1,135 @@
+#include <SHADERed/Engine/PixelReadback.h>
+#include <SHADERed/Objects/Profiler.h>
+#include <string.h>
+
+namespace ed {
+	namespace eng {
+		static const uint8_t emptyPixel[4] = { 0, 0, 0, 0 };
+
+		PixelReadback::PixelReadback()
+		{
+			m_fence = nullptr;
+			m_capacity = 0;
+			m_count = 0;
+			m_ready = false;
+
+			glGenFramebuffers(1, &m_fbo);
+			glGenBuffers(1, &m_pbo);
+		}
+		PixelReadback::~PixelReadback()
+		{
+			if (m_fence != nullptr)
+				glDeleteSync(m_fence);
+			glDeleteFramebuffers(1, &m_fbo);
+			glDeleteBuffers(1, &m_pbo);
+		}
+
+		void PixelReadback::Begin(int count)
+		{
+			if (m_fence != nullptr) {
+				glDeleteSync(m_fence);
+				m_fence = nullptr;
+			}
+
+			m_ready = false;
+			m_count = 0;
+
+			// only grow the buffer, debug clicks usually need the same amount of texels each time
+			if (count > m_capacity) {
+				m_capacity = count;
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+				glBufferData(GL_PIXEL_PACK_BUFFER, m_capacity * 4, nullptr, GL_STREAM_READ);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+		}
+		int PixelReadback::Read(GLuint texture, int x, int y)
+		{
+			if (m_count >= m_capacity)
+				return -1;
+
+			int index = m_count++;
+
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+			// with a pack buffer bound, the last argument is an offset into it and the call returns right away
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+			glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*)(size_t)(index * 4));
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+			return index;
+		}
+		void PixelReadback::End()
+		{
+			m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush(); // make sure the fence reaches the GPU, otherwise IsReady() might never return true
+		}
+
+		bool PixelReadback::IsReady()
+		{
+			if (m_ready)
+				return true;
+			if (m_fence == nullptr)
+				return false;
+
+			GLenum status = glClientWaitSync(m_fence, 0, 0);
+			if (status == GL_TIMEOUT_EXPIRED)
+				return false;
+
+			m_fetch();
+			return true;
+		}
+		void PixelReadback::Wait()
+		{
+			if (m_ready || m_fence == nullptr)
+				return;
+
+			ProfileScope readbackScope("Pixel readback");
+			while (glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+				;
+
+			m_fetch();
+		}
+
+		const uint8_t* PixelReadback::Get(int index)
+		{
+			if (!m_ready || index < 0 || index >= m_count)
+				return emptyPixel;
+			return &m_data[index * 4];
+		}
+		glm::vec4 PixelReadback::GetColor(int index)
+		{
+			const uint8_t* px = Get(index);
+			return glm::vec4(px[0] / 255.0f, px[1] / 255.0f, px[2] / 255.0f, px[3] / 255.0f);
+		}
+		uint32_t PixelReadback::GetID(int index)
+		{
+			const uint8_t* px = Get(index);
+			return ((uint32_t)px[0] << 0) | ((uint32_t)px[1] << 8) | ((uint32_t)px[2] << 16) | ((uint32_t)px[3] << 24);
+		}
+
+		void PixelReadback::m_fetch()
+		{
+			glDeleteSync(m_fence);
+			m_fence = nullptr;
+
+			m_data.resize(m_count * 4);
+			if (m_count > 0) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+				void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_count * 4, GL_MAP_READ_BIT);
+				if (data != nullptr) {
+					memcpy(m_data.data(), data, m_count * 4);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				} else
+					memset(m_data.data(), 0, m_count * 4);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+
+			m_ready = true;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+namespace ed {
+	namespace eng {
+		// reads single RGBA8 texels of 2D textures into one pixel pack buffer. All reads of a batch
+		// are copied back to the CPU together once the GPU has finished them, so the caller doesn't
+		// have to wait for the whole pipeline (unless it calls Wait())
+		class PixelReadback {
+		public:
+			PixelReadback();
+			~PixelReadback();
+
+			void Begin(int count); // start a new batch of at most count reads - drops the previous one
+			int Read(GLuint texture, int x, int y); // returns the index of this read in the batch, -1 if the batch is full
+			void End();
+
+			bool IsReady(); // doesn't block
+			void Wait();
+
+			// only valid once IsReady() returned true
+			const uint8_t* Get(int index);
+			glm::vec4 GetColor(int index);
+			uint32_t GetID(int index);
+
+		private:
+			void m_fetch();
+
+			GLuint m_fbo, m_pbo;
+			GLsync m_fence;
+			int m_capacity, m_count;
+			bool m_ready;
+			std::vector<uint8_t> m_data;
+		};
+	}
+}
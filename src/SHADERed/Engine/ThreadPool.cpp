@@ -0,0 +1,89 @@
+#include <SHADERed/Engine/ThreadPool.h>
+#include <algorithm>
+
+namespace ed {
+	namespace eng {
+		ThreadPool::ThreadPool(size_t threadCount)
+		{
+			m_stop = false;
+
+			if (threadCount == 0)
+				threadCount = std::thread::hardware_concurrency();
+			if (threadCount == 0)
+				threadCount = 2;
+
+			for (size_t i = 0; i < threadCount; i++)
+				m_threads.push_back(std::thread(&ThreadPool::m_worker, this));
+		}
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_stop = true;
+			}
+			m_cond.notify_all();
+
+			for (auto& thread : m_threads)
+				if (thread.joinable())
+					thread.join();
+		}
+
+		std::future<void> ThreadPool::Submit(std::function<void()> task)
+		{
+			std::packaged_task<void()> pkg(std::move(task));
+			std::future<void> ret = pkg.get_future();
+
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_tasks.push_back(std::move(pkg));
+			}
+			m_cond.notify_one();
+
+			return ret;
+		}
+		void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t maxWorkers)
+		{
+			if (count == 0)
+				return;
+
+			size_t workerCount = std::min<size_t>(m_threads.size() + 1, count);
+			if (maxWorkers != 0)
+				workerCount = std::min<size_t>(workerCount, maxWorkers);
+
+			std::atomic<size_t> next(0);
+			auto work = [&](size_t worker) {
+				for (size_t i = next++; i < count; i = next++)
+					fn(i, worker);
+			};
+
+			std::vector<std::future<void>> pending;
+			for (size_t w = 1; w < workerCount; w++)
+				pending.push_back(Submit(std::bind(work, w)));
+
+			work(0);
+
+			for (auto& task : pending)
+				task.wait();
+		}
+
+		void ThreadPool::m_worker()
+		{
+			while (true) {
+				std::packaged_task<void()> task;
+
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_cond.wait(lock, [&]() { return m_stop || !m_tasks.empty(); });
+
+					if (m_stop && m_tasks.empty())
+						return;
+
+					task = std::move(m_tasks.front());
+					m_tasks.pop_front();
+				}
+
+				task();
+			}
+		}
+	}
+}
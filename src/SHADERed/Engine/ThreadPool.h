@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ed {
+	namespace eng {
+		class ThreadPool {
+		public:
+			ThreadPool(size_t threadCount = 0); // 0 -> std::thread::hardware_concurrency()
+			~ThreadPool();
+
+			inline size_t GetThreadCount() { return m_threads.size(); }
+
+			// queue a task; returned future becomes ready once the task has finished
+			std::future<void> Submit(std::function<void()> task);
+
+			// call fn(index, worker) for every index in [0, count) - the calling thread also takes part
+			// as worker 0, so worker is always < GetThreadCount() + 1. Idle workers keep pulling the
+			// next unprocessed index, so uneven work still gets spread over all threads
+			void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t maxWorkers = 0);
+
+		private:
+			void m_worker();
+
+			std::vector<std::thread> m_threads;
+			std::deque<std::packaged_task<void()>> m_tasks;
+			std::mutex m_lock;
+			std::condition_variable m_cond;
+			bool m_stop;
+		};
+	}
+}
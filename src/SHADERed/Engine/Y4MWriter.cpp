@@ -0,0 +1,189 @@
+#include <SHADERed/Engine/Y4MWriter.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define Y4M_USE_SSE2
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace ed {
+	namespace eng {
+		// 8 bit fixed point BT.601 (JPEG range) coefficients
+		static inline uint8_t clampByte(int v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+		static inline uint8_t getY(int r, int g, int b) { return clampByte((77 * r + 150 * g + 29 * b + 128) >> 8); }
+		static inline uint8_t getU(int r, int g, int b) { return clampByte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128); }
+		static inline uint8_t getV(int r, int g, int b) { return clampByte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128); }
+
+#ifdef Y4M_USE_SSE2
+		// dot product of 4 RGBA8 pixels with coeff (r, g, b, 0, r, g, b, 0) -> (sum + 128) >> 8 as 4x int32
+		static inline __m128i dot4(__m128i px, __m128i coeff)
+		{
+			__m128i zero = _mm_setzero_si128();
+			__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeff); // [p0.rg, p0.ba, p1.rg, p1.ba]
+			__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeff); // [p2.rg, p2.ba, p3.rg, p3.ba]
+
+			__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+			__m128i sum = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+
+			return _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+		}
+		static inline __m128i packBytes(__m128i a, __m128i b) // 8x int32 -> 8x uint8 in the low half
+		{
+			__m128i words = _mm_packs_epi32(a, b);
+			return _mm_packus_epi16(words, words);
+		}
+		// sum 2x2 blocks of 4x2 RGBA8 pixels in 16 bit -> (sum + 2) >> 2 for 2 pixels as 8x int16
+		static inline __m128i average2(const uint8_t* row0, const uint8_t* row1)
+		{
+			__m128i zero = _mm_setzero_si128();
+			__m128i a = _mm_loadu_si128((const __m128i*)row0);
+			__m128i b = _mm_loadu_si128((const __m128i*)row1);
+
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)); // [p0, p1]
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)); // [p2, p3]
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+			__m128i sum = _mm_unpacklo_epi64(lo, hi);
+			return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+		}
+		// average 2x2 blocks of 8x2 RGBA8 pixels -> 4 RGBA8 pixels, rounded the same way as the scalar path
+		static inline __m128i average4(const uint8_t* row0, const uint8_t* row1)
+		{
+			return _mm_packus_epi16(average2(row0, row1), average2(row0 + 16, row1 + 16));
+		}
+#endif
+
+		Y4MWriter::Y4MWriter()
+		{
+			m_file = nullptr;
+			m_isStdout = false;
+			m_width = m_height = 0;
+			m_nextFrame = 0;
+		}
+		Y4MWriter::~Y4MWriter()
+		{
+			Close();
+		}
+
+		bool Y4MWriter::Open(const std::string& path, int width, int height, int fps)
+		{
+			Close();
+
+			m_isStdout = path == "-";
+			if (m_isStdout) {
+#ifdef _WIN32
+				_setmode(_fileno(stdout), _O_BINARY);
+#endif
+				m_file = stdout;
+			} else
+				m_file = fopen(path.c_str(), "wb");
+
+			if (m_file == nullptr)
+				return false;
+
+			m_width = width;
+			m_height = height;
+			m_nextFrame = 0;
+
+			fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+
+			return true;
+		}
+		void Y4MWriter::Close()
+		{
+			if (m_file == nullptr)
+				return;
+
+			if (m_isStdout)
+				fflush(m_file);
+			else
+				fclose(m_file);
+
+			m_file = nullptr;
+		}
+
+		void Y4MWriter::ConvertRGBA(const uint8_t* rgba, int width, int height, uint8_t* yuv)
+		{
+			int chromaWidth = (width + 1) / 2;
+			int chromaHeight = (height + 1) / 2;
+			uint8_t* planeY = yuv;
+			uint8_t* planeU = planeY + width * height;
+			uint8_t* planeV = planeU + chromaWidth * chromaHeight;
+			size_t stride = width * 4;
+
+#ifdef Y4M_USE_SSE2
+			const __m128i coeffY = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+			const __m128i coeffU = _mm_setr_epi16(-43, -85, 128, 0, -43, -85, 128, 0);
+			const __m128i coeffV = _mm_setr_epi16(128, -107, -21, 0, 128, -107, -21, 0);
+			const __m128i offset = _mm_set1_epi32(128);
+#endif
+
+			// luma
+			for (int y = 0; y < height; y++) {
+				const uint8_t* src = rgba + (height - 1 - y) * stride;
+				uint8_t* dst = planeY + y * width;
+				int x = 0;
+
+#ifdef Y4M_USE_SSE2
+				for (; x + 8 <= width; x += 8) {
+					__m128i a = dot4(_mm_loadu_si128((const __m128i*)(src + x * 4)), coeffY);
+					__m128i b = dot4(_mm_loadu_si128((const __m128i*)(src + x * 4 + 16)), coeffY);
+					_mm_storel_epi64((__m128i*)(dst + x), packBytes(a, b));
+				}
+#endif
+				for (; x < width; x++)
+					dst[x] = getY(src[x * 4 + 0], src[x * 4 + 1], src[x * 4 + 2]);
+			}
+
+			// chroma - average of each 2x2 block
+			for (int y = 0; y < chromaHeight; y++) {
+				const uint8_t* row0 = rgba + (height - 1 - y * 2) * stride;
+				const uint8_t* row1 = y * 2 + 1 < height ? row0 - stride : row0;
+				uint8_t* dstU = planeU + y * chromaWidth;
+				uint8_t* dstV = planeV + y * chromaWidth;
+				int x = 0;
+
+#ifdef Y4M_USE_SSE2
+				for (; x * 2 + 16 <= width; x += 8) {
+					__m128i pxA = average4(row0 + x * 8, row1 + x * 8);
+					__m128i pxB = average4(row0 + x * 8 + 32, row1 + x * 8 + 32);
+
+					__m128i u = packBytes(_mm_add_epi32(dot4(pxA, coeffU), offset), _mm_add_epi32(dot4(pxB, coeffU), offset));
+					__m128i v = packBytes(_mm_add_epi32(dot4(pxA, coeffV), offset), _mm_add_epi32(dot4(pxB, coeffV), offset));
+					_mm_storel_epi64((__m128i*)(dstU + x), u);
+					_mm_storel_epi64((__m128i*)(dstV + x), v);
+				}
+#endif
+				for (; x < chromaWidth; x++) {
+					int x0 = x * 2, x1 = x * 2 + 1 < width ? x * 2 + 1 : x * 2;
+					int rgb[3];
+					for (int c = 0; c < 3; c++)
+						rgb[c] = (row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) / 4;
+
+					dstU[x] = getU(rgb[0], rgb[1], rgb[2]);
+					dstV[x] = getV(rgb[0], rgb[1], rgb[2]);
+				}
+			}
+		}
+
+		void Y4MWriter::WriteFrame(int index, const uint8_t* yuv)
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_frameWritten.wait(lock, [&]() { return m_nextFrame == index; });
+
+			if (m_file != nullptr) {
+				fwrite("FRAME\n", 1, 6, m_file);
+				fwrite(yuv, 1, GetFrameSize(), m_file);
+			}
+
+			m_nextFrame++;
+			m_frameWritten.notify_all();
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+namespace ed {
+	namespace eng {
+		// streams 4:2:0 frames into a single YUV4MPEG2 file (or stdout when path is "-") so that
+		// sequences can be piped straight into an external encoder
+		class Y4MWriter {
+		public:
+			Y4MWriter();
+			~Y4MWriter();
+
+			bool Open(const std::string& path, int width, int height, int fps);
+			void Close();
+
+			inline bool IsOpen() { return m_file != nullptr; }
+			inline size_t GetFrameSize() { return GetFrameSize(m_width, m_height); }
+			static inline size_t GetFrameSize(int width, int height) { return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2); }
+
+			// convert bottom-up RGBA8 pixels (glGetTexImage layout) to top-down planar YUV 4:2:0 (full range BT.601)
+			static void ConvertRGBA(const uint8_t* rgba, int width, int height, uint8_t* yuv);
+
+			// frames can be converted on multiple threads - this waits until all frames before index have been written
+			void WriteFrame(int index, const uint8_t* yuv);
+
+		private:
+			FILE* m_file;
+			bool m_isStdout;
+			int m_width, m_height;
+
+			int m_nextFrame;
+			std::mutex m_lock;
+			std::condition_variable m_frameWritten;
+		};
+	}
+}
@@ -1,6 +1,8 @@
 #include <SDL2/SDL_messagebox.h>
 #include <SHADERed/GUIManager.h>
 #include <SHADERed/InterfaceManager.h>
+#include <SHADERed/Engine/BlockingQueue.h>
+#include <SHADERed/Engine/Y4MWriter.h>
 #include <SHADERed/Objects/CameraSnapshots.h>
 #include <SHADERed/Objects/Export/ExportCPP.h>
 #include <SHADERed/Objects/FunctionVariableManager.h>
@@ -8,6 +10,7 @@
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/Names.h>
 #include <SHADERed/Objects/Settings.h>
+#include <SHADERed/Objects/SoftwareRenderer.h>
 #include <SHADERed/Objects/SPIRVParser.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
@@ -126,6 +129,7 @@ namespace ed {
 		m_focusModeTemp = false;
 		m_cubemapPathPtr = nullptr;
 		m_cmdArguments = nullptr;
+		m_softwareRenderer = nullptr;
 
 		m_isBrowseOnlineOpened = false;
 
@@ -310,6 +314,7 @@ namespace ed {
 		delete m_objectPrev;
 		delete m_createUI;
 		delete m_settingsBkp;
+		delete m_softwareRenderer;
 
 		ImGui_ImplSDL2_Shutdown();
 		ImGui_ImplOpenGL3_Shutdown();
@@ -539,14 +544,17 @@ namespace ed {
 			if (!m_recompiledAll) {
 				std::vector<bool> needsUpdate = ((CodeEditorUI*)Get(ViewID::Code))->TrackedNeedsUpdate();
 				std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
+				std::vector<PipelineItem*> changed;
 				int ind = 0;
 				if (needsUpdate.size() >= passes.size()) {
 					for (PipelineItem*& pass : passes) {
 						if (needsUpdate[ind])
-							m_data->Renderer.Recompile(pass->Name);
+							changed.push_back(pass);
 						ind++;
 					}
 				}
+				if (!changed.empty())
+					m_data->Renderer.Recompile(changed);
 			}
 
 			((CodeEditorUI*)Get(ViewID::Code))->EmptyTrackedFiles();
@@ -798,9 +806,7 @@ namespace ed {
 				if (ImGui::MenuItem("Rebuild project", KeyboardShortcuts::Instance().GetString("Project.Rebuild").c_str())) {
 					((CodeEditorUI*)Get(ViewID::Code))->SaveAll();
 
-					std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-					for (PipelineItem*& pass : passes)
-						m_data->Renderer.Recompile(pass->Name);
+					m_data->Renderer.Recompile(m_data->Pipeline.GetList());
 				}
 				if (ImGui::MenuItem("Render", KeyboardShortcuts::Instance().GetString("Preview.SaveImage").c_str()))
 					m_savePreviewPopupOpened = true;
@@ -1420,9 +1426,7 @@ namespace ed {
 
 		if (ImGui::Button(UI_ICON_REFRESH)) { // REBUILD PROJECT
 			((CodeEditorUI*)Get(ViewID::Code))->SaveAll();
-			std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-			for (PipelineItem*& pass : passes)
-				m_data->Renderer.Recompile(pass->Name);
+			m_data->Renderer.Recompile(m_data->Pipeline.GetList());
 		}
 		m_tooltip("Rebuild");
 		ImGui::SameLine();
@@ -1954,9 +1958,7 @@ namespace ed {
 
 		((CodeEditorUI*)Get(ViewID::Code))->SaveAll();
 
-		std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-		for (PipelineItem*& pass : passes)
-			m_data->Renderer.Recompile(pass->Name);
+		m_data->Renderer.Recompile(m_data->Pipeline.GetList());
 
 		m_recompiledAll = true; 
 
@@ -2015,6 +2017,22 @@ namespace ed {
 			m_savePreviewSeq = options.RenderSequence;
 			m_savePreviewSeqDuration = options.RenderSequenceDuration;
 			m_savePreviewSeqFPS = options.RenderSequenceFPS;
+
+			if (options.RenderSoftware && m_softwareRenderer == nullptr)
+				m_softwareRenderer = new SoftwareRenderer(&m_data->Debugger, &m_data->Renderer, &m_data->Pipeline, &m_data->Objects, &m_data->Messages);
+		}
+	}
+	void GUIManager::m_renderPreviewPixels(int width, int height, unsigned char* pixels)
+	{
+		if (m_softwareRenderer != nullptr) {
+			m_softwareRenderer->Render(width, height);
+			memcpy(pixels, m_softwareRenderer->GetColorOutput(), width * height * 4);
+		} else {
+			m_data->Renderer.Render(width, height);
+
+			glBindTexture(GL_TEXTURE_2D, m_data->Renderer.GetTexture());
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+			glBindTexture(GL_TEXTURE_2D, 0);
 		}
 	}
 
@@ -2031,6 +2049,9 @@ namespace ed {
 
 		SystemVariableManager::Instance().SetSavingToFile(true);
 
+		// textures are decoded in the background - make sure that all of them are uploaded
+		m_data->Objects.FinishTextureLoads(true);
+
 		// normal render
 		if (!m_savePreviewSeq) {
 			if (actualSizeX > 0 && actualSizeY > 0) {
@@ -2041,10 +2062,6 @@ namespace ed {
 				SystemVariableManager::Instance().SetKeysWASD(m_savePreviewWASD[0], m_savePreviewWASD[1], m_savePreviewWASD[2], m_savePreviewWASD[3]);
 				SystemVariableManager::Instance().SetMousePosition(m_savePreviewMouse.x, m_savePreviewMouse.y);
 				SystemVariableManager::Instance().SetMouse(m_savePreviewMouse.x, m_savePreviewMouse.y, m_savePreviewMouse.z, m_savePreviewMouse.w);
-
-				m_data->Renderer.Render(actualSizeX, actualSizeY);
-
-				SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTime);
 			}
 
 			unsigned char* pixels = (unsigned char*)malloc(actualSizeX * actualSizeY * 4);
@@ -2055,10 +2072,11 @@ namespace ed {
 			else
 				outPixels = pixels;
 
-			GLuint tex = m_data->Renderer.GetTexture();
-			glBindTexture(GL_TEXTURE_2D, tex);
-			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-			glBindTexture(GL_TEXTURE_2D, 0);
+			if (actualSizeX > 0 && actualSizeY > 0) {
+				m_renderPreviewPixels(actualSizeX, actualSizeY, pixels);
+
+				SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTime);
+			}
 
 			// resize image
 			if (sizeMulti != 1) {
@@ -2068,7 +2086,15 @@ namespace ed {
 
 			std::string ext = m_previewSavePath.substr(m_previewSavePath.find_last_of('.') + 1);
 
-			if (ext == "jpg" || ext == "jpeg")
+			if (ext == "y4m" || m_previewSavePath == "-") {
+				eng::Y4MWriter video;
+				if (video.Open(m_previewSavePath, m_previewSaveSize.x, m_previewSaveSize.y, m_savePreviewSeqFPS)) {
+					uint8_t* yuv = (uint8_t*)malloc(video.GetFrameSize());
+					eng::Y4MWriter::ConvertRGBA(outPixels, m_previewSaveSize.x, m_previewSaveSize.y, yuv);
+					video.WriteFrame(0, yuv);
+					free(yuv);
+				}
+			} else if (ext == "jpg" || ext == "jpeg")
 				stbi_write_jpg(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels, 100);
 			else if (ext == "bmp")
 				stbi_write_bmp(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels);
@@ -2090,8 +2116,6 @@ namespace ed {
 
 				float curTime = 0.0f;
 
-				GLuint tex = m_data->Renderer.GetTexture();
-
 				size_t lastDot = m_previewSavePath.find_last_of('.');
 				std::string ext = lastDot == std::string::npos ? "png" : m_previewSavePath.substr(lastDot + 1);
 				std::string filename = m_previewSavePath;
@@ -2130,101 +2154,164 @@ namespace ed {
 				SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTimeDelta);
 				SystemVariableManager::Instance().SetTimeDelta(seqDelta);
 
+				// .y4m or "-" (stdout) -> stream all frames into a single file instead
+				bool isVideo = ext == "y4m" || m_previewSavePath == "-";
+				eng::Y4MWriter video;
+				if (isVideo && !video.Open(m_previewSavePath, m_previewSaveSize.x, m_previewSaveSize.y, m_savePreviewSeqFPS))
+					Logger::Get().Log("Failed to open " + m_previewSavePath + " for writing", true);
+
 				stbi_write_png_compression_level = 5; // set to lowest compression level
 
 				int tCount = std::thread::hardware_concurrency();
 				tCount = tCount == 0 ? 2 : tCount;
 
-				unsigned char** pixels = new unsigned char*[tCount];
-				unsigned char** outPixels = new unsigned char*[tCount];
-				int* curFrame = new int[tCount];
-				bool* needsUpdate = new bool[tCount];
-				std::thread** threadPool = new std::thread*[tCount];
-				std::atomic<bool> isOver = false;
+				const int pboCount = 3; // frame N is read back while N+1 and N+2 are being rendered
+				const size_t frameSize = actualSizeX * actualSizeY * 4;
+				int bufferCount = tCount + pboCount;
 
-				for (int i = 0; i < tCount; i++) {
-					curFrame[i] = 0;
-					needsUpdate[i] = true;
-					pixels[i] = (unsigned char*)malloc(actualSizeX * actualSizeY * 4);
+				typedef std::pair<int, unsigned char*> SequenceFrame; // frame index, pixels
+				eng::BlockingQueue<unsigned char*> freeBuffers(bufferCount);
+				eng::BlockingQueue<SequenceFrame> encodeQueue(bufferCount);
 
-					if (sizeMulti != 1)
-						outPixels[i] = (unsigned char*)malloc(m_previewSaveSize.x * m_previewSaveSize.y * 4);
-					else
-						outPixels[i] = nullptr;
+				std::vector<unsigned char*> pixels(bufferCount);
+				for (int i = 0; i < bufferCount; i++) {
+					pixels[i] = (unsigned char*)malloc(frameSize);
+					freeBuffers.Push(pixels[i]);
+				}
 
-					threadPool[i] = new std::thread([ext, filename, sizeMulti, actualSizeX, actualSizeY, &outPixels, &pixels, &needsUpdate, &curFrame, &isOver](int worker, int w, int h) {
+				std::vector<std::thread> encoders;
+				for (int i = 0; i < tCount; i++) {
+					encoders.push_back(std::thread([ext, filename, sizeMulti, actualSizeX, actualSizeY, isVideo, &video, &freeBuffers, &encodeQueue](int w, int h) {
 						char prevSavePath[SHADERED_MAX_PATH];
-						while (!isOver) {
-							if (needsUpdate[worker])
-								continue;
+						unsigned char* resized = nullptr;
+						if (sizeMulti != 1)
+							resized = (unsigned char*)malloc(w * h * 4);
+						uint8_t* yuv = nullptr;
+						if (isVideo)
+							yuv = (uint8_t*)malloc(eng::Y4MWriter::GetFrameSize(w, h));
+
+						SequenceFrame frame;
+						while (encodeQueue.Pop(frame)) {
+							unsigned char* outPixels = frame.second;
 
 							// resize image
 							if (sizeMulti != 1) {
-								stbir_resize_uint8(pixels[worker], actualSizeX, actualSizeY, actualSizeX * 4,
-									outPixels[worker], w, h, w * 4, 4);
-							} else
-								outPixels[worker] = pixels[worker];
+								stbir_resize_uint8(frame.second, actualSizeX, actualSizeY, actualSizeX * 4,
+									resized, w, h, w * 4, 4);
+								outPixels = resized;
+							}
 
-							sprintf(prevSavePath, filename.c_str(), curFrame[worker]);
+							if (isVideo) {
+								eng::Y4MWriter::ConvertRGBA(outPixels, w, h, yuv);
+								video.WriteFrame(frame.first, yuv);
+								freeBuffers.Push(frame.second);
+								continue;
+							}
+
+							sprintf(prevSavePath, filename.c_str(), frame.first);
 
 							if (ext == "jpg" || ext == "jpeg")
-								stbi_write_jpg(prevSavePath, w, h, 4, outPixels[worker], 100);
+								stbi_write_jpg(prevSavePath, w, h, 4, outPixels, 100);
 							else if (ext == "bmp")
-								stbi_write_bmp(prevSavePath, w, h, 4, outPixels[worker]);
+								stbi_write_bmp(prevSavePath, w, h, 4, outPixels);
 							else if (ext == "tga")
-								stbi_write_tga(prevSavePath, w, h, 4, outPixels[worker]);
+								stbi_write_tga(prevSavePath, w, h, 4, outPixels);
 							else
-								stbi_write_png(prevSavePath, w, h, 4, outPixels[worker], w * 4);
+								stbi_write_png(prevSavePath, w, h, 4, outPixels, w * 4);
 
-							needsUpdate[worker] = true;
+							freeBuffers.Push(frame.second);
 						}
+
+						free(resized);
+						free(yuv);
 					},
-						i, m_previewSaveSize.x, m_previewSaveSize.y);
+						m_previewSaveSize.x, m_previewSaveSize.y));
 				}
 
-				int globalFrame = 0;
-				while (curTime < m_savePreviewSeqDuration) {
-					int hasWork = -1;
-					for (int i = 0; i < tCount; i++)
-						if (needsUpdate[i]) {
-							hasWork = i;
-							break;
-						}
+				// ring of pixel pack buffers - glGetTexImage into a PBO returns immediately and the
+				// data is only mapped once the fence says that the GPU is done with the frame
+				GLuint pbos[pboCount] = { 0 };
+				GLsync fences[pboCount] = { 0 };
+				int pboFrame[pboCount] = { 0 };
+				bool usePBO = m_softwareRenderer == nullptr;
+				if (usePBO) {
+					glGenBuffers(pboCount, pbos);
+					for (int i = 0; i < pboCount; i++) {
+						glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+						glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+					}
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				}
 
-					if (hasWork == -1)
-						continue;
+				auto readbackPBO = [&](int slot) {
+					if (fences[slot] == 0)
+						return;
+
+					glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+					glDeleteSync(fences[slot]);
+					fences[slot] = 0;
+
+					unsigned char* buffer = nullptr;
+					freeBuffers.Pop(buffer);
 
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+					void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+					if (mapped != nullptr) {
+						memcpy(buffer, mapped, frameSize);
+						glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+					}
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+					encodeQueue.Push(std::make_pair(pboFrame[slot], buffer));
+				};
+
+				GLuint tex = m_data->Renderer.GetTexture();
+				int globalFrame = 0;
+				while (curTime < m_savePreviewSeqDuration) {
 					SystemVariableManager::Instance().CopyState();
 					SystemVariableManager::Instance().SetFrameIndex(m_savePreviewFrameIndex + globalFrame);
 
-					m_data->Renderer.Render(actualSizeX, actualSizeY);
-
-					glBindTexture(GL_TEXTURE_2D, tex);
-					glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels[hasWork]);
-					glBindTexture(GL_TEXTURE_2D, 0);
+					if (usePBO) {
+						int slot = globalFrame % pboCount;
+						readbackPBO(slot);
+
+						m_data->Renderer.Render(actualSizeX, actualSizeY);
+
+						glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+						glBindTexture(GL_TEXTURE_2D, tex);
+						glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+						glBindTexture(GL_TEXTURE_2D, 0);
+						glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+						fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+						pboFrame[slot] = globalFrame;
+					} else {
+						unsigned char* buffer = nullptr;
+						freeBuffers.Pop(buffer);
+						m_renderPreviewPixels(actualSizeX, actualSizeY, buffer);
+						encodeQueue.Push(std::make_pair(globalFrame, buffer));
+					}
 
 					SystemVariableManager::Instance().AdvanceTimer(seqDelta);
 
 					curTime += seqDelta;
-					curFrame[hasWork] = globalFrame;
-					needsUpdate[hasWork] = false;
 					globalFrame++;
 				}
-				isOver = true;
 
-				for (int i = 0; i < tCount; i++) {
-					if (threadPool[i]->joinable())
-						threadPool[i]->join();
-					free(pixels[i]);
-					if (sizeMulti != 1)
-						free(outPixels[i]);
-					delete threadPool[i];
+				// flush the frames that are still in flight (oldest first)
+				if (usePBO) {
+					for (int i = 0; i < pboCount; i++)
+						readbackPBO((globalFrame + i) % pboCount);
+					glDeleteBuffers(pboCount, pbos);
 				}
-				delete[] pixels;
-				delete[] outPixels;
-				delete[] curFrame;
-				delete[] needsUpdate;
-				delete[] threadPool;
+
+				encodeQueue.Close();
+				for (auto& encoder : encoders)
+					encoder.join();
+				video.Close();
+
+				for (int i = 0; i < bufferCount; i++)
+					free(pixels[i]);
 
 				stbi_write_png_compression_level = 8; // set back to default compression level
 			}
@@ -3042,9 +3129,7 @@ namespace ed {
 		KeyboardShortcuts::Instance().SetCallback("Project.Rebuild", [=]() {
 			((CodeEditorUI*)Get(ViewID::Code))->SaveAll();
 
-			std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-			for (PipelineItem*& pass : passes)
-				m_data->Renderer.Recompile(pass->Name);
+			m_data->Renderer.Recompile(m_data->Pipeline.GetList());
 		});
 		KeyboardShortcuts::Instance().SetCallback("Project.Save", [=]() {
 			Save();
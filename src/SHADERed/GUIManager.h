@@ -19,6 +19,7 @@ class ImFont;
 
 namespace ed {
 	class InterfaceManager;
+	class SoftwareRenderer;
 	class CreateItemUI;
 	class UIView;
 	class Settings;
@@ -117,6 +118,9 @@ namespace ed {
 		ImFont* m_iconFontLarge;
 
 		CommandLineOptionParser* m_cmdArguments;
+		SoftwareRenderer* m_softwareRenderer; // only created with --rendersoftware
+
+		void m_renderPreviewPixels(int width, int height, unsigned char* pixels);
 
 		std::vector<std::string> m_recentProjects;
 
@@ -7,30 +7,6 @@
 #include <glm/gtc/type_ptr.hpp>
 
 namespace ed {
-	uint8_t* getRawPixel(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* ret = &data[(x + y * width) * 4];
-
-		if (glGetTextureSubImage) {
-			ret = &data[0];
-			glGetTextureSubImage(rt, 0, x, y, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, 4 * sizeof(uint8_t), data);
-		} else {
-			glBindTexture(GL_TEXTURE_2D, rt);
-			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
-		return ret;
-	}
-	glm::vec4 getPixelColor(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* pxData = getRawPixel(rt, data, x, y, width);
-		return glm::vec4(pxData[0] / 255.0f, pxData[1] / 255.0f, pxData[2] / 255.0f, pxData[3] / 255.0f);
-	}
-	uint32_t getPixelID(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* pxData = getRawPixel(rt, data, x, y, width);
-		return ((uint32_t)pxData[0] << 0) | ((uint32_t)pxData[1] << 8) | ((uint32_t)pxData[2] << 16) | ((uint32_t)pxData[3] << 24);
-	}
 	void copyFloatData(eng::Model::Mesh::Vertex& out, GLfloat* bufData)
 	{
 		out.Position = glm::vec3(bufData[0], bufData[1], bufData[2]);
@@ -43,7 +19,7 @@ namespace ed {
 
 	InterfaceManager::InterfaceManager(GUIManager* gui)
 			: Renderer(&Pipeline, &Objects, &Parser, &Messages, &Plugins, &Debugger)
-			, Pipeline(&Parser, &Plugins)
+			, Pipeline(&Parser, &Plugins, &Renderer)
 			, Objects(&Parser, &Renderer)
 			, Parser(&Pipeline, &Objects, &Renderer, &Plugins, &Messages, &Debugger, gui)
 			, Debugger(&Objects, &Renderer, &Messages)
@@ -51,6 +27,7 @@ namespace ed {
 			, DAP(&Debugger, gui, &Run)
 	{
 		m_ui = gui;
+		m_debugClickPending = false;
 	}
 	InterfaceManager::~InterfaceManager()
 	{
@@ -61,64 +38,68 @@ namespace ed {
 	{
 		DAP.StopDebugging();
 		Debugger.ClearPixelList();
+		m_debugClickPending = false;
 
 		if (!m_canDebug())
 			return;
 
-		// info
+		// textures whose pixel we need: the window and every render texture
 		const std::vector<ObjectManagerItem*>& objs = Objects.GetObjects();
-		glm::ivec2 previewSize = Renderer.GetLastRenderSize();
-		glm::ivec2 maxRTSize = previewSize;
-		GLuint previewTexture = Renderer.GetTexture();
-
-		int x = r.x * previewSize.x;
-		int y = r.y * previewSize.y;
-
-		// results
-		std::unordered_map<GLuint, glm::vec4> pixelColors;
-		std::unordered_map<GLuint, std::pair<PipelineItem*, PipelineItem*>> pipelineItems;
-
-		// get max RT size
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]);
-				if (rtSize.x > maxRTSize.x)
-					maxRTSize.x = rtSize.x;
-				if (rtSize.y > maxRTSize.y)
-					maxRTSize.y = rtSize.y;
-			}
+		m_debugClickTextures.clear();
+		m_debugClickTextures.push_back(Renderer.GetTexture());
+		for (int i = 0; i < objs.size(); i++)
+			if (objs[i]->RT != nullptr)
+				m_debugClickTextures.push_back(objs[i]->Texture);
+
+		// all reads go to one buffer: colors first, then object IDs
+		int texCount = m_debugClickTextures.size();
+		m_pixelReadback.Begin(texCount * 2);
+
+		// pixel colors
+		for (int i = 0; i < texCount; i++) {
+			glm::ivec2 rtSize = m_getTextureSize(m_debugClickTextures[i]);
+			m_pixelReadback.Read(m_debugClickTextures[i], r.x * rtSize.x, r.y * rtSize.y);
 		}
 
-		uint8_t* mainPixelData = new uint8_t[maxRTSize.x * maxRTSize.y * 4]; // copy gpu data to cpu
-		
-		// window pixel color
-		pixelColors[previewTexture] = getPixelColor(previewTexture, mainPixelData, x, y, previewSize.x);
-
-		// rt pixel colors
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->Type == ObjectType::RenderTexture) {
-				GLuint tex = objs[i]->Texture;
-				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]);
+		// render with object IDs - only the few pixels around the click are needed
+		Renderer.SetScissor(true, r);
+		Renderer.Render(true);
 
-				pixelColors[tex] = getPixelColor(tex, mainPixelData, r.x * rtSize.x, r.y * rtSize.y, rtSize.x);
-			}
+		// pipeline items
+		for (int i = 0; i < texCount; i++) {
+			glm::ivec2 rtSize = m_getTextureSize(m_debugClickTextures[i]);
+			m_pixelReadback.Read(m_debugClickTextures[i], r.x * rtSize.x, r.y * rtSize.y);
 		}
 
-		// render with object IDs
-		Renderer.Render(true);
+		// return old info
+		Renderer.Render();
+		Renderer.SetScissor(false);
 
-		// window pipeline item
-		pipelineItems[previewTexture] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & getPixelID(previewTexture, mainPixelData, x, y, previewSize.x));
+		// results are processed in Update() once the GPU is done
+		m_pixelReadback.End();
+		m_debugClickPos = r;
+		m_debugClickPending = true;
+	}
+	void InterfaceManager::m_finishDebugClick()
+	{
+		glm::vec2 r = m_debugClickPos;
+		glm::ivec2 previewSize = Renderer.GetLastRenderSize();
+		GLuint previewTexture = Renderer.GetTexture();
+		int texCount = m_debugClickTextures.size();
+		int x = 0, y = 0;
 
-		// rt pipeline item
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				GLuint tex = objs[i]->Texture;
-				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]);
+		// results
+		std::unordered_map<GLuint, glm::vec4> pixelColors;
+		std::unordered_map<GLuint, std::pair<PipelineItem*, PipelineItem*>> pipelineItems;
+		for (int i = 0; i < texCount; i++) {
+			GLuint tex = m_debugClickTextures[i];
+			if (tex != previewTexture && Objects.GetByTextureID(tex) == nullptr)
+				continue; // removed in the meantime
 
-				pipelineItems[tex] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & getPixelID(tex, mainPixelData, r.x * rtSize.x, r.y * rtSize.y, rtSize.x));
-			}
+			pixelColors[tex] = m_pixelReadback.GetColor(i);
+			pipelineItems[tex] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & m_pixelReadback.GetID(texCount + i));
 		}
+		bool fetched = false;
 
 		// add PixelInformation objects
 		for (const auto& k : pipelineItems) {
@@ -205,27 +186,38 @@ namespace ed {
 				pxInfo.TessellationShaderUsed = ((pipe::ShaderPass*)pxInfo.Pass->Data)->TSUsed;
 			}
 
-			if (Settings::Instance().Debug.AutoFetch)
+			if (Settings::Instance().Debug.AutoFetch) {
 				FetchPixel(pxInfo);
+				fetched = true;
+			}
 			Debugger.AddPixel(pxInfo);
 		}
 
-		// return old info
-		Renderer.Render();
+		// FetchPixel() stops rendering at the pixel's pass
+		if (fetched) {
+			Renderer.SetScissor(true, r);
+			Renderer.Render();
+			Renderer.SetScissor(false);
+		}
 	}
 	void InterfaceManager::FetchPixel(PixelInformation& pixel)
 	{
+		// picking only needs the pixels around the selected one
+		Renderer.SetScissor(true, pixel.RelativeCoordinate);
+
 		int vertexGroupID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
 		int vertexID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, vertexGroupID);
 
 		int instanceGroupID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
 		int instanceID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, instanceGroupID);
 
+		Renderer.SetScissor(false);
+
 		pixel.InstanceID = instanceID;
 		pixel.VertexID = vertexID;
 		m_fetchVertices(pixel);
 
-		// return old info
+		// return old info - not scissored, the debugger reads whole render textures of the earlier passes
 		Renderer.Render(false, pixel.Pass); // render everything up to the pixel.Pass object
 
 		// run vertex shader
@@ -345,12 +337,14 @@ namespace ed {
 			pipe::Model* mdl = ((pipe::Model*)pixel.Object->Data);
 
 			int curOffset = 0;
-			for (const auto& mesh : mdl->Data->Meshes) {
+			for (auto& mesh : mdl->Data->Meshes) {
 				if (pixel.VertexID >= curOffset + mesh.Indices.size()) {
 					curOffset += mesh.Indices.size();
 					continue;
 				}
 
+				mesh.RestoreVertices();
+
 				pixel.Vertex[0] = mesh.Vertices[mesh.Indices[pixel.VertexID + 0]];
 				pixel.Vertex[1] = mesh.Vertices[mesh.Indices[pixel.VertexID + 1]];
 				pixel.Vertex[2] = mesh.Vertices[mesh.Indices[pixel.VertexID + 2]];
@@ -437,6 +431,19 @@ namespace ed {
 	}
 	void InterfaceManager::Update(float delta)
 	{
+		Objects.FinishTextureLoads();
+
+		if (m_debugClickPending && m_pixelReadback.IsReady()) {
+			m_debugClickPending = false;
+			m_finishDebugClick();
+		}
+	}
+	glm::ivec2 InterfaceManager::m_getTextureSize(GLuint tex)
+	{
+		ObjectManagerItem* rtItem = Objects.GetByTextureID(tex);
+		if (rtItem != nullptr && rtItem->RT != nullptr)
+			return Objects.GetRenderTextureSize(rtItem);
+		return Renderer.GetLastRenderSize();
 	}
 	bool InterfaceManager::m_canDebug()
 	{
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL2/SDL_events.h>
+#include <SHADERed/Engine/PixelReadback.h>
 #include <SHADERed/Objects/DebugInformation.h>
 #include <SHADERed/Objects/DebugAdapterProtocol.h>
 #include <SHADERed/Objects/MessageStack.h>
@@ -22,7 +23,7 @@ namespace ed {
 		void OnEvent(const SDL_Event& e);
 		void Update(float delta);
 
-		void DebugClick(glm::vec2 r);
+		void DebugClick(glm::vec2 r); // pixels show up in the debugger a few frames later (see Update())
 		void FetchPixel(PixelInformation& pixel);
 
 		bool Run;
@@ -43,5 +44,13 @@ namespace ed {
 
 		void m_fetchVertices(PixelInformation& pixel);
 		bool m_canDebug();
+
+		// pixel colors & object IDs requested by DebugClick()
+		eng::PixelReadback m_pixelReadback;
+		bool m_debugClickPending;
+		glm::vec2 m_debugClickPos;
+		std::vector<GLuint> m_debugClickTextures;
+		void m_finishDebugClick();
+		glm::ivec2 m_getTextureSize(GLuint tex);
 	};
 }
\ No newline at end of file
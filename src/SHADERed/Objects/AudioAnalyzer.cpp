@@ -2,6 +2,12 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_USE_SSE2
+#endif
 
 const float ed::AudioAnalyzer::Smooth[] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 const float ed::AudioAnalyzer::Gravity = 0.0006f;
@@ -17,6 +23,21 @@ namespace ed {
 		m_sensitivity = 1.0;
 		m_isSetup = 0;
 		m_setup(48000);
+
+		// FFT plan
+		int bits = 0;
+		while ((1 << bits) < SampleCount)
+			bits++;
+		for (int i = 0; i < SampleCount; i++) {
+			int rev = 0;
+			for (int b = 0; b < bits; b++)
+				rev |= ((i >> b) & 1) << (bits - 1 - b);
+			m_bitReverse[i] = rev;
+		}
+		for (int i = 0; i < SampleCount / 2; i++) {
+			m_twiddleRe[i] = cos(-2 * M_PI * i / SampleCount);
+			m_twiddleIm[i] = sin(-2 * M_PI * i / SampleCount);
+		}
 	}
 
 	AudioAnalyzer::~AudioAnalyzer()
@@ -51,28 +72,20 @@ namespace ed {
 	double* AudioAnalyzer::FFT(const short* samples)
 	{
 		// Spliting channels
-		std::valarray<std::complex<double>> fftIn(SampleCount);
-		for (int i = 0; i < SampleCount * 2; i += 2)
-			fftIn[i / 2] = (samples[i] + samples[i + 1]) / 2; // TODO: Add stereo option
+		for (int i = 0; i < SampleCount; i++) {
+			int j = m_bitReverse[i];
+			m_re[j] = (samples[i * 2] + samples[i * 2 + 1]) / 2; // TODO: Add stereo option
+			m_im[j] = 0.0f;
+		}
 
-		// Run fftw
-		m_fftAlgorithm(fftIn);
+		// Run fft
+		m_fftAlgorithm();
 
-		// Separate fftw output
-		m_seperateFreqBands(&fftIn[0], BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity, BufferOutSize);
+		// Separate fft output
+		m_seperateFreqBands(BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity);
 
 		/* Processing */
-		// Waves
-		for (int i = 0; i < BufferOutSize; i++) {
-			m_fftOut[i] *= 0.8;
-			for (int j = i - 1; j >= 0; j--) {
-				if (m_fftOut[i] - (i - j) * (i - j) / 1000.0 > m_fftOut[j])
-					m_fftOut[j] = m_fftOut[i] - (i - j) * (i - j) / 1000.0;
-			}
-			for (int j = i + 1; j < BufferOutSize; j++)
-				if (m_fftOut[i] - (i - j) * (i - j) / 1000.0 > m_fftOut[j])
-					m_fftOut[j] = m_fftOut[i] - (i - j) * (i - j) / 1000.0;
-		}
+		m_waves();
 
 		// Gravity
 		for (int i = 0; i < BufferOutSize; i++) {
@@ -112,43 +125,115 @@ namespace ed {
 
 		return &m_fftOut[0];
 	}
-	void AudioAnalyzer::m_fftAlgorithm(std::valarray<std::complex<double>>& input)
+	void AudioAnalyzer::m_fftAlgorithm()
 	{
-		const int len = input.size();
-		if (len <= 1) return;
+		// iterative radix-2 FFT, input is already in bit reversed order. The first two
+		// stages only use +-1 and -i as twiddle factors so they are done as one radix-4 pass
+		for (int i = 0; i < SampleCount; i += 4) {
+			float r0 = m_re[i] + m_re[i + 1], i0 = m_im[i] + m_im[i + 1];
+			float r1 = m_re[i] - m_re[i + 1], i1 = m_im[i] - m_im[i + 1];
+			float r2 = m_re[i + 2] + m_re[i + 3], i2 = m_im[i + 2] + m_im[i + 3];
+			float r3 = m_re[i + 2] - m_re[i + 3], i3 = m_im[i + 2] - m_im[i + 3];
+
+			m_re[i] = r0 + r2;
+			m_im[i] = i0 + i2;
+			m_re[i + 2] = r0 - r2;
+			m_im[i + 2] = i0 - i2;
+			m_re[i + 1] = r1 + i3; // r1 - i * (r3 + i * i3)
+			m_im[i + 1] = i1 - r3;
+			m_re[i + 3] = r1 - i3;
+			m_im[i + 3] = i1 + r3;
+		}
+
+		for (int len = 8; len <= SampleCount; len *= 2) {
+			int half = len / 2;
+			int step = SampleCount / len;
 
-		std::valarray<std::complex<double>> even = input[std::slice(0, len / 2, 2)];
-		std::valarray<std::complex<double>> odd = input[std::slice(1, len / 2, 2)];
+			for (int i = 0; i < SampleCount; i += len) {
+				for (int k = 0; k < half; k++) {
+					float wr = m_twiddleRe[k * step], wi = m_twiddleIm[k * step];
+					int e = i + k, o = i + k + half;
 
-		m_fftAlgorithm(even);
-		m_fftAlgorithm(odd);
+					float tr = wr * m_re[o] - wi * m_im[o];
+					float ti = wr * m_im[o] + wi * m_re[o];
 
-		for (int i = 0; i < len / 2; i++) {
-			std::complex<double> temp = std::polar(1.0, (double)-2 * M_PI * i / len) * odd[i];
-			input[i] = even[i] + temp;
-			input[i + len / 2] = even[i] - temp;
+					m_re[o] = m_re[e] - tr;
+					m_im[o] = m_im[e] - ti;
+					m_re[e] += tr;
+					m_im[e] += ti;
+				}
+			}
 		}
 	}
-	void AudioAnalyzer::m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples)
+	void AudioAnalyzer::m_seperateFreqBands(int n, int* lcf, int* hcf, float* k, double sensitivity)
 	{
-		double* peak = new double[n];
-		double* y = new double[in_samples];
-		double temp;
+		// magnitudes of the bins that the bands can use
+#ifdef AUDIO_USE_SSE2
+		static_assert(BufferOutSize % 4 == 0, "BufferOutSize must be a multiple of 4");
+		for (int j = 0; j < BufferOutSize; j += 4) {
+			__m128 re = _mm_load_ps(&m_re[j]);
+			__m128 im = _mm_load_ps(&m_im[j]);
+			_mm_store_ps(&m_magnitude[j], _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+		}
+#else
+		for (int j = 0; j < BufferOutSize; j++)
+			m_magnitude[j] = sqrtf(m_re[j] * m_re[j] + m_im[j] * m_im[j]);
+#endif
 
 		for (int i = 0; i < n; i++) {
-			peak[i] = 0;
+			double peak = 0;
+			for (int j = lcf[i]; j <= hcf[i]; j++)
+				peak += m_magnitude[j];
 
-			for (int j = lcf[i]; j <= hcf[i]; j++) {
-				y[j] = sqrt(in[j].real() * in[j].real() + in[j].imag() * in[j].imag());
-				peak[i] += y[j];
-			}
-
-			peak[i] = peak[i] / (hcf[i] - lcf[i] + 1);
-			temp = peak[i] * sensitivity * k[i] / 1000000;
-			m_fftOut[i] = temp / 100.0;
+			peak = peak / (hcf[i] - lcf[i] + 1);
+			m_fftOut[i] = peak * sensitivity * k[i] / 1000000 / 100.0;
+		}
+	}
+	void AudioAnalyzer::m_waves()
+	{
+		/*
+			every bar is first multiplied by 0.8 and then pulls up every other bar j to at least
+			bar - (i - j)^2 / 1000. Doing that bar by bar is O(n^2), but the bars on the left are
+			only ever pulled up by already scaled bars, so both directions can be done as a running
+			maximum of parabolas: max(w_k - (i - k)^2 / c) == max(2ik/c + w_k - k^2/c) - i^2/c, which
+			is a maximum of lines with increasing slopes queried at increasing i (convex hull trick)
+		*/
+		const double c = 1000.0;
+		double slope[BufferOutSize], offset[BufferOutSize];
+		int front = 0, back = 0;
+
+		auto useless = [&](int l1, int l2, double m3, double b3) -> bool {
+			// is line l2 never above both l1 and the new line?
+			return (offset[l1] - b3) * (slope[l2] - slope[l1]) <= (offset[l1] - offset[l2]) * (m3 - slope[l1]);
+		};
+		auto add = [&](double m, double b) {
+			while (back - front >= 2 && useless(back - 2, back - 1, m, b))
+				back--;
+			slope[back] = m;
+			offset[back] = b;
+			back++;
+		};
+		auto query = [&](double x) -> double {
+			while (back - front >= 2 && slope[front + 1] * x + offset[front + 1] >= slope[front] * x + offset[front])
+				front++;
+			return slope[front] * x + offset[front];
+		};
+
+		// left to right: scale the bar after it was pulled up by the bars before it
+		for (int i = 0; i < BufferOutSize; i++) {
+			if (back > front)
+				m_fftOut[i] = std::max<double>(m_fftOut[i], query(i) - i * i / c);
+			m_fftOut[i] *= 0.8;
+			add(2.0 * i / c, m_fftOut[i] - i * i / c);
 		}
 
-		delete[] peak;
-		delete[] y;
+		// right to left: pull up the bars by the (already final) scaled bars after them
+		front = back = 0;
+		for (int i = BufferOutSize - 1; i >= 0; i--) {
+			double w = m_fftOut[i];
+			if (back > front)
+				m_fftOut[i] = std::max<double>(m_fftOut[i], query(-i) - i * i / c);
+			add(-2.0 * i / c, w - i * i / c);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,7 +1,5 @@
 #pragma once
-#include <complex>
-#include <valarray>
-#include <vector>
+#include <stdint.h>
 
 namespace ed {
 	class AudioAnalyzer {
@@ -21,8 +19,9 @@ namespace ed {
 		double* FFT(const short* samples);
 
 	private:
-		void m_fftAlgorithm(std::valarray<std::complex<double>>& x);
-		void m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples);
+		void m_fftAlgorithm();
+		void m_seperateFreqBands(int n, int* lcf, int* hcf, float* k, double sensitivity);
+		void m_waves();
 
 		int m_isSetup;
 		void m_setup(int rate);
@@ -37,5 +36,14 @@ namespace ed {
 
 		double m_fftOut[SampleCount];
 		double m_sensitivity;
+
+		// FFT plan - bit reversal permutation and exp(-2*pi*i*k/SampleCount)
+		uint16_t m_bitReverse[SampleCount];
+		float m_twiddleRe[SampleCount / 2], m_twiddleIm[SampleCount / 2];
+
+		// FFT work buffers
+		alignas(16) float m_re[SampleCount];
+		alignas(16) float m_im[SampleCount];
+		alignas(16) float m_magnitude[BufferOutSize];
 	};
 }
\ No newline at end of file
@@ -1,12 +1,19 @@
 #include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Engine/GeometryFactory.h>
 #include <SHADERed/Objects/AudioShaderStream.h>
+#include <SHADERed/Objects/Profiler.h>
+#include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 
 #define SHADER_STREAM_PCM_FRAME_CHUNK_SIZE 1024
+#define SHADER_STREAM_CPU_BUFFER_CHUNKS 4 // ring buffer size (in chunks) when the samples are generated on the CPU
+#define SHADER_STREAM_CPU_SLICE_SIZE 64	  // samples processed by one VM at a time
+#define SHADER_STREAM_CPU_LANES 4		  // max number of threads that generate samples
 
 void audioShaderCallbackFixed(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
 {
@@ -32,6 +39,31 @@ void audioShaderCallback(ma_device* pDevice, void* pOutput, const void* pInput,
 	ma_uint32 pcmFramesProcessed = 0;
 	ma_uint8* pRunningOutput = (ma_uint8*)pOutput;
 
+	// samples are produced by the audio stream's worker thread - only consume them here
+	if (player->IsRenderedOnCPU()) {
+		ma_uint32 frameSize = ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels);
+
+		while (pcmFramesProcessed < frameCount) {
+			ma_uint32 framesToRead = std::min<ma_uint32>(frameCount - pcmFramesProcessed, ma_pcm_rb_available_read(player->GetRingBuffer()));
+			if (framesToRead == 0)
+				break;
+
+			void* pReadBuffer;
+			ma_pcm_rb_acquire_read(player->GetRingBuffer(), &framesToRead, &pReadBuffer);
+			memcpy(pRunningOutput, pReadBuffer, framesToRead * frameSize);
+			ma_pcm_rb_commit_read(player->GetRingBuffer(), framesToRead, pReadBuffer);
+
+			pRunningOutput += framesToRead * frameSize;
+			pcmFramesProcessed += framesToRead;
+		}
+
+		// the worker didn't keep up - play silence instead of stale data
+		if (pcmFramesProcessed < frameCount)
+			memset(pRunningOutput, 0, (frameCount - pcmFramesProcessed) * frameSize);
+
+		return;
+	}
+
 	/*
     The first thing to do is check if there's enough data available in the ring buffer. If so we can read from it. Otherwise we need to keep filling
     the ring buffer until there's enough, making sure we only fill the ring buffer in chunks of PCM_FRAME_CHUNK_SIZE.
@@ -85,7 +117,16 @@ namespace ed {
 		NeedsUpdate = false;
 		CurrentTime = 0.0f;
 
-		ma_pcm_rb_init(ma_format_s16, 2, SHADER_STREAM_PCM_FRAME_CHUNK_SIZE, NULL, NULL, &m_rb);
+		m_playing = false;
+		m_cpu = false;
+		m_workerRunning = false;
+		m_lanePool = nullptr;
+		m_vmContext = nullptr;
+		m_vmGLSL = nullptr;
+		m_vmShader = nullptr;
+		m_vmMain = m_vmTimeInput = m_vmOutput = 0;
+
+		ma_pcm_rb_init(ma_format_s16, 2, SHADER_STREAM_PCM_FRAME_CHUNK_SIZE * SHADER_STREAM_CPU_BUFFER_CHUNKS, NULL, NULL, &m_rb);
 		
 		m_deviceConfig = ma_device_config_init(ma_device_type_playback);
 		m_deviceConfig.playback.format = ma_format_s16;
@@ -99,8 +140,16 @@ namespace ed {
 	}
 	AudioShaderStream::~AudioShaderStream()
 	{
+		m_stopWorker();
 		m_clean();
 
+		m_cleanCPU();
+		delete m_lanePool;
+		if (m_vmContext != nullptr) {
+			free(m_vmGLSL);
+			spvm_context_deinitialize(m_vmContext);
+		}
+
 		gl::FreeSimpleFramebuffer(m_fbo, m_rt, m_depth);
 		glDeleteVertexArrays(1, &m_fsRectVAO);
 		glDeleteBuffers(1, &m_fsRectVBO);
@@ -182,10 +231,27 @@ namespace ed {
 		m_fbo = gl::CreateSimpleFramebuffer(1024, 1, m_rt, m_depth, GL_RGBA32F);
 
 		m_svarCurTimeLoc = glGetUniformLocation(m_shader, "sedCurrentTime");
+
+		// the device has to be stopped too, its callback changes behavior when switching backends
+		bool wasPlaying = m_playing;
+		if (wasPlaying)
+			Stop();
+
+		m_cleanCPU();
+		if (Settings::Instance().Preview.AudioShaderCPU) {
+			m_cpu = m_compileCPU(project, str, macros, isHLSL);
+			if (!m_cpu)
+				m_cleanCPU();
+			if (!m_cpu && m_msgs != nullptr)
+				m_msgs->Add(MessageStack::Type::Warning, m_msgs->CurrentItem, "Audio shader can't be executed on the CPU (it uses uniforms, textures or buffers) - rendering it on the GPU");
+		}
+
+		if (wasPlaying)
+			Start();
 	}
 	void AudioShaderStream::RenderAudio()
 	{
-		if (!NeedsUpdate)
+		if (!NeedsUpdate || m_cpu)
 			return;
 
 		std::lock_guard<std::mutex> guard(Mutex);
@@ -202,9 +268,12 @@ namespace ed {
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glBindTexture(GL_TEXTURE_2D, m_rt);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, m_pixels);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		{
+			ProfileScope readbackScope("Audio readback", true);
+			glBindTexture(GL_TEXTURE_2D, m_rt);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, m_pixels);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
 
 		for (int s = 0; s < 1024; s++) {
 			int off = s * 4;
@@ -216,12 +285,32 @@ namespace ed {
 	}
 	void AudioShaderStream::Start()
 	{
-		if (ma_device_start(&m_device) != MA_SUCCESS)
+		if (m_playing)
+			return;
+
+		if (m_cpu)
+			m_startWorker();
+
+		if (ma_device_start(&m_device) != MA_SUCCESS) {
+			m_stopWorker();
 			m_clean();
+			return;
+		}
+
+		m_playing = true;
 	}
 	void AudioShaderStream::Stop()
 	{
-		if (ma_device_stop(&m_device) != MA_SUCCESS)
+		if (!m_playing)
+			return;
+
+		m_playing = false;
+
+		// the worker writes to m_rb -> it has to be stopped before the ring buffer can be freed
+		bool stopped = ma_device_stop(&m_device) == MA_SUCCESS;
+		m_stopWorker();
+
+		if (!stopped)
 			m_clean();
 	}
 	void AudioShaderStream::m_clean()
@@ -229,4 +318,163 @@ namespace ed {
 		ma_device_uninit(&m_device);
 		ma_pcm_rb_uninit(&m_rb);
 	}
-}
\ No newline at end of file
+
+	bool AudioShaderStream::m_compileCPU(ProjectParser* project, const std::string& str, std::vector<ed::ShaderMacro>& macros, bool isHLSL)
+	{
+		// time comes in through an input variable so that the shader doesn't need any uniforms
+		std::string source = str;
+		if (isHLSL) {
+			source += R"(
+				float4 main(float sedSampleTime : TEXCOORD0) : SV_TARGET {
+					float2 v = mainSound(sedSampleTime);
+					return float4(v.x, v.y, 0, 0);
+				}
+			)";
+		} else {
+			source += R"(
+				in float sedSampleTime;
+				out vec4 fragColor;
+				void main() {
+					vec2 v = mainSound(sedSampleTime);
+					fragColor = vec4(v.x, v.y, 0, 0);
+				}
+			)";
+		}
+
+		// errors were already reported when compiling the GPU version
+		m_spv.clear();
+		if (!ShaderCompiler::CompileSourceToSPIRV(m_spv, isHLSL ? ShaderLanguage::HLSL : ShaderLanguage::GLSL, "audio.shader", source, ShaderStage::Pixel, "main", macros, nullptr, project) || m_spv.empty())
+			return false;
+
+		if (m_vmContext == nullptr) {
+			m_vmContext = spvm_context_initialize();
+			m_vmGLSL = spvm_build_glsl450_ext();
+		}
+
+		m_vmShader = spvm_program_create(m_vmContext, (spvm_source)m_spv.data(), m_spv.size());
+
+		spvm_state_t vm = spvm_state_create(m_vmShader);
+		spvm_state_set_extension(vm, "GLSL.std.450", m_vmGLSL);
+		m_vmLanes.push_back(vm);
+
+		m_vmMain = spvm_state_get_result_location(vm, "main");
+		m_vmTimeInput = m_vmOutput = 0;
+
+		for (spvm_word i = 0; i < m_vmShader->bound; i++) {
+			spvm_result_t slot = &vm->results[i];
+			if (slot->pointer == 0 || slot->member_count == 0)
+				continue;
+
+			spvm_result_t pointer = &vm->results[slot->pointer];
+			if (pointer->value_type != spvm_value_type_pointer)
+				continue;
+
+			bool isBuiltin = false;
+			for (spvm_word j = 0; j < slot->decoration_count; j++)
+				if (slot->decorations[j].type == SpvDecorationBuiltIn)
+					isBuiltin = true;
+
+			if (pointer->storage_class == SpvStorageClassInput && !isBuiltin)
+				m_vmTimeInput = i;
+			else if (pointer->storage_class == SpvStorageClassOutput && slot->member_count >= 2)
+				m_vmOutput = i;
+			else if (pointer->storage_class == SpvStorageClassUniform || pointer->storage_class == SpvStorageClassUniformConstant || pointer->storage_class == SpvStorageClassStorageBuffer || pointer->storage_class == SpvStorageClassPushConstant)
+				return false; // values of these are only known on the GL thread
+		}
+
+		if (m_vmMain == 0 || m_vmTimeInput == 0 || m_vmOutput == 0)
+			return false;
+
+		// hardware_concurrency() can return 0 - clamp before subtracting the calling thread
+		if (m_lanePool == nullptr) {
+			size_t coreCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+			m_lanePool = new eng::ThreadPool(std::max<size_t>(1, std::min<size_t>(SHADER_STREAM_CPU_LANES, coreCount) - 1));
+		}
+
+		for (size_t i = 1; i < m_lanePool->GetThreadCount() + 1; i++) {
+			spvm_state_t lane = spvm_state_create(m_vmShader);
+			spvm_state_set_extension(lane, "GLSL.std.450", m_vmGLSL);
+			m_vmLanes.push_back(lane);
+		}
+
+		return true;
+	}
+	void AudioShaderStream::m_cleanCPU()
+	{
+		m_cpu = false;
+
+		for (spvm_state_t lane : m_vmLanes)
+			spvm_state_delete(lane);
+		m_vmLanes.clear();
+
+		if (m_vmShader != nullptr) {
+			spvm_program_delete(m_vmShader);
+			m_vmShader = nullptr;
+		}
+	}
+	void AudioShaderStream::m_startWorker()
+	{
+		if (m_workerRunning)
+			return;
+
+		// device is stopped at this point so nobody else is using the ring buffer
+		ma_pcm_rb_reset(&m_rb);
+
+		m_workerRunning = true;
+		m_workerThread = std::thread(&AudioShaderStream::m_worker, this);
+	}
+	void AudioShaderStream::m_stopWorker()
+	{
+		m_workerRunning = false;
+		if (m_workerThread.joinable())
+			m_workerThread.join();
+	}
+	void AudioShaderStream::m_worker()
+	{
+		while (m_workerRunning) {
+			ma_uint32 frameCount = std::min<ma_uint32>(ma_pcm_rb_available_write(&m_rb), SHADER_STREAM_PCM_FRAME_CHUNK_SIZE);
+			if (frameCount < SHADER_STREAM_CPU_SLICE_SIZE) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			void* pWriteBuffer;
+			if (ma_pcm_rb_acquire_write(&m_rb, &frameCount, &pWriteBuffer) != MA_SUCCESS || frameCount == 0)
+				continue;
+
+			float time = 0.0f;
+			{
+				std::lock_guard<std::mutex> guard(Mutex);
+				time = CurrentTime;
+			}
+
+			m_renderCPU((short*)pWriteBuffer, frameCount, time);
+			ma_pcm_rb_commit_write(&m_rb, frameCount, pWriteBuffer);
+
+			{
+				std::lock_guard<std::mutex> guard(Mutex);
+				CurrentTime += frameCount / 44100.0f;
+			}
+		}
+	}
+	void AudioShaderStream::m_renderCPU(short* out, ma_uint32 frameCount, double time)
+	{
+		// split the samples into slices that are processed in parallel, each thread has its own VM
+		size_t sliceCount = (frameCount + SHADER_STREAM_CPU_SLICE_SIZE - 1) / SHADER_STREAM_CPU_SLICE_SIZE;
+		m_lanePool->ParallelFor(sliceCount, [&](size_t slice, size_t lane) {
+			spvm_state_t vm = m_vmLanes[lane];
+			spvm_result_t input = &vm->results[m_vmTimeInput];
+			spvm_result_t output = &vm->results[m_vmOutput];
+
+			ma_uint32 sEnd = std::min<ma_uint32>(frameCount, (slice + 1) * SHADER_STREAM_CPU_SLICE_SIZE);
+			for (ma_uint32 s = slice * SHADER_STREAM_CPU_SLICE_SIZE; s < sEnd; s++) {
+				spvm_state_prepare(vm, m_vmMain);
+				input->members[0].value.f = time + (s + 0.5) / 44100.0; // same as gl_FragCoord.x on the GPU
+				spvm_state_call_function(vm);
+
+				out[s * 2 + 0] = std::max<float>(-1.0f, std::min<float>(1.0f, output->members[0].value.f)) * INT16_MAX;
+				out[s * 2 + 1] = std::max<float>(-1.0f, std::min<float>(1.0f, output->members[1].value.f)) * INT16_MAX;
+			}
+		}, m_vmLanes.size());
+	}
+}
@@ -1,10 +1,12 @@
 #pragma once
+#include <SHADERed/Engine/ThreadPool.h>
 #include <SHADERed/Objects/MessageStack.h>
 #include <SHADERed/Objects/ProjectParser.h>
 #include <SHADERed/Objects/ShaderMacro.h>
 
 #include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 #include <mutex>
 
@@ -17,6 +19,12 @@
 
 #include <misc/miniaudio.h>
 
+extern "C" {
+	#include <spvm/program.h>
+	#include <spvm/state.h>
+	#include <spvm/ext/GLSL450.h>
+}
+
 namespace ed {
 	class AudioShaderStream {
 	public:
@@ -33,6 +41,9 @@ namespace ed {
 		inline short* GetAudioBuffer() { return m_audio; }
 		inline ma_pcm_rb* GetRingBuffer() { return &m_rb; }
 
+		// samples are generated by running the shader's SPIR-V on a separate thread instead of rendering them on the GPU
+		inline bool IsRenderedOnCPU() { return m_cpu; }
+
 		float CurrentTime;
 		std::mutex Mutex;
 		std::atomic<bool> NeedsUpdate;
@@ -40,6 +51,13 @@ namespace ed {
 	private:
 		void m_clean();
 
+		bool m_compileCPU(ProjectParser* project, const std::string& str, std::vector<ed::ShaderMacro>& macros, bool isHLSL);
+		void m_cleanCPU();
+		void m_startWorker();
+		void m_stopWorker();
+		void m_worker();
+		void m_renderCPU(short* out, ma_uint32 frameCount, double time);
+
 		GLuint m_fboBuffers;
 		GLuint m_fsRectVAO, m_fsRectVBO;
 		GLuint m_fbo, m_rt, m_depth;
@@ -51,5 +69,18 @@ namespace ed {
 		ma_device_config m_deviceConfig;
 		ma_device m_device;
 		ma_pcm_rb m_rb;
+		bool m_playing;
+
+		// CPU backend
+		std::atomic<bool> m_cpu;
+		std::atomic<bool> m_workerRunning;
+		std::thread m_workerThread;
+		eng::ThreadPool* m_lanePool;
+		spvm_context_t m_vmContext;
+		spvm_ext_opcode_func* m_vmGLSL;
+		spvm_program_t m_vmShader;
+		std::vector<spvm_state_t> m_vmLanes; // one VM per thread that generates samples
+		std::vector<unsigned int> m_spv;
+		spvm_word m_vmMain, m_vmTimeInput, m_vmOutput;
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <SHADERed/Objects/CommandLineOptionParser.h>
+#include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/WebAPI.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
 #include <string.h>
@@ -34,6 +35,7 @@ namespace ed {
 
 		Render = false;
 		RenderSequence = false;
+		RenderSoftware = false;
 		RenderWidth = 1920;
 		RenderHeight = 1080;
 		RenderSupersampling = 1;
@@ -95,7 +97,11 @@ namespace ed {
 				Render = true;
 
 				if (i + 1 < argc) {
-					RenderPath = (cmdDir / argv[i + 1]).generic_string();
+					if (strcmp(argv[i + 1], "-") == 0) {
+						RenderPath = "-"; // stdout
+						ed::Logger::Get().PipeToStderr = true; // log lines would end up in the video
+					} else
+						RenderPath = (cmdDir / argv[i + 1]).generic_string();
 					i++;
 				}
 			}
@@ -104,6 +110,11 @@ namespace ed {
 				Render = true;
 				RenderSequence = true;
 			}
+			// --rendersoftware, -rsw
+			else if (strcmp(argv[i], "--rendersoftware") == 0 || strcmp(argv[i], "-rsw") == 0) {
+				Render = true;
+				RenderSoftware = true;
+			}
 			// --renderwidth, -rw [width]
 			else if (strcmp(argv[i], "--renderwidth") == 0 || strcmp(argv[i], "-rw") == 0) {
 				int width = 0;
@@ -306,7 +317,7 @@ namespace ed {
 					{ "--fullscreen | -fs", "launch SHADERed in fullscreen mode" },
 					{ "--maxmimized | -max", "maximize SHADERed's window" },
 					{ "--performance | -p", "launch SHADERed in performance mode" },
-					{ "--render | -r <file>", "render to a file" },
+					{ "--render | -r <file>", "render to a file (.y4m or - streams a sequence into one file/stdout)" },
 					{ "--renderwidth | -rw <width>", "set the output image width" },
 					{ "--renderheight | -rh <height>", "set the output image height" },
 					{ "--rendersample | -rsmp <samples>", "set the rendering supersample (1, 2, 4 or 8)" },
@@ -315,6 +326,7 @@ namespace ed {
 					{ "--rendersequence | -rseq", "render a sequence" },
 					{ "--renderseqfps | -rseqfps <index>", "set sequence FPS" },
 					{ "--renderseqduration | -rseqdur <time>", "set sequence duration" },
+					{ "--rendersoftware | -rsw", "rasterize and shade on the CPU instead of the GPU" },
 
 					{ "--compile | -c <file>", "compile a shader file" },
 					{ "--language | -cl <language>", "compiler input language" },
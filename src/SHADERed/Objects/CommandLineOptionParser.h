@@ -23,7 +23,7 @@ namespace ed {
 		std::string ConvertPath;
 
 		std::string RenderPath;
-		bool Render, RenderSequence;
+		bool Render, RenderSequence, RenderSoftware;
 		int RenderWidth, RenderHeight, RenderSupersampling, RenderFrameIndex, RenderSequenceFPS;
 		float RenderTime, RenderSequenceDuration;
 
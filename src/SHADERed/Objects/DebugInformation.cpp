@@ -1,9 +1,20 @@
 #include <SHADERed/Objects/DebugInformation.h>
+#include <SHADERed/Engine/Hash.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 #include <SHADERed/Objects/Logger.h>
 
+#include <algorithm>
+#include <cfloat>
 #include <iomanip>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DEBUG_USE_SSE2
+#endif
+
+#define DEBUG_INTERPOLATION_BATCH 64 // pixel shader input scalars interpolated in one go
+#define DEBUG_PROGRAM_CACHE_SIZE 16
+
 #define GET_VALUE_WITH_CHECK_FLOAT(val, c) (val == nullptr ? 0.0f : val->members[c].value.f)
 #define GET_VALUE2_WITH_CHECK_FLOAT(val, c, r) (val == nullptr ? 0.0f : val->members[c].members[r].value.f)
 #define GET_VALUE_WITH_CHECK_DOUBLE(val, c) (val == nullptr ? 0.0 : val->members[c].value.d)
@@ -347,6 +358,7 @@ namespace ed {
 		m_msgs = msgs;
 		m_workgroup = nullptr;
 		m_updatedGeometryOutput = false;
+		m_programCacheTick = 0;
 
 		m_vmContext = spvm_context_initialize();
 		m_vmGLSL = spvm_build_glsl450_ext();
@@ -358,6 +370,8 @@ namespace ed {
 		ClearPixelList();
 
 		m_resetVM();
+		m_clearImageCache(true);
+		m_clearProgramCache();
 
 		free(m_vmGLSL);
 		spvm_context_deinitialize(m_vmContext);
@@ -367,11 +381,14 @@ namespace ed {
 	{
 		ed::Logger::Get().Log("Resetting the debugger");
 
+		m_interpolation.HasInputs = false;
+
 		for (spvm_image_t img : m_images) {
 			free(img->data);
 			free(img);
 		}
 		m_images.clear();
+		m_clearImageCache(false);
 
 		// clear shared memory
 		for (SharedMemoryEntry& entry : SharedMemory)
@@ -402,10 +419,7 @@ namespace ed {
 			spvm_state_delete(m_vm);
 			m_vm = nullptr;
 		}
-		if (m_shader) {
-			spvm_program_delete(m_shader);
-			m_shader = nullptr;
-		}
+		m_shader = nullptr; // stays in m_programCache
 
 		// delete old immediate program & state
 		if (m_vmImmediate) {
@@ -420,14 +434,50 @@ namespace ed {
 		// reset undefined behavior info
 		m_ubLastType = m_ubLastLine = m_ubCount = 0;
 	}
-	void DebugInformation::m_setupVM(std::vector<unsigned int>& spv)
+	spvm_program_t DebugInformation::m_getProgram(const std::vector<unsigned int>& spv)
 	{
+		uint64_t hash = eng::Hash(spv.data(), spv.size() * sizeof(unsigned int));
+
+		m_programCacheTick++;
+
+		for (CachedProgram& entry : m_programCache)
+			if (entry.Hash == hash && entry.SPIRV == spv) {
+				entry.LastUsed = m_programCacheTick;
+				return entry.Program;
+			}
+
 		ed::Logger::Get().Log("Parsing the SPIR-V and setting up the debugger");
 
+		// remove the least recently used program - m_resetVM() was already called so no state uses it
+		if (m_programCache.size() >= DEBUG_PROGRAM_CACHE_SIZE) {
+			auto oldest = std::min_element(m_programCache.begin(), m_programCache.end(), [](const CachedProgram& a, const CachedProgram& b) {
+				return a.LastUsed < b.LastUsed;
+			});
+			spvm_program_delete(oldest->Program);
+			m_programCache.erase(oldest);
+		}
+
+		CachedProgram entry;
+		entry.Hash = hash;
+		entry.SPIRV = spv;
+		entry.LastUsed = m_programCacheTick;
+		entry.Program = spvm_program_create(m_vmContext, (spvm_source)entry.SPIRV.data(), entry.SPIRV.size());
+		m_programCache.push_back(std::move(entry)); // moving the vector keeps its data pointer
+
+		return m_programCache.back().Program;
+	}
+	void DebugInformation::m_clearProgramCache()
+	{
+		for (CachedProgram& entry : m_programCache)
+			spvm_program_delete(entry.Program);
+		m_programCache.clear();
+	}
+	void DebugInformation::m_setupVM(std::vector<unsigned int>& spv)
+	{
 		m_spv = spv;
 		
 		// create program & state
-		m_shader = spvm_program_create(m_vmContext, (spvm_source)m_spv.data(), m_spv.size());
+		m_shader = m_getProgram(m_spv);
 		m_shader->user_data = this;
 		m_shader->allocate_workgroup_memory = allocateWorkgroupMemory;
 		m_shader->write_workgroup_memory = writeWorkgroupMemory;
@@ -603,6 +653,81 @@ namespace ed {
 		}
 
 	}
+	spvm_image_t DebugInformation::m_getTextureImage(GLuint textureID, int dim, const glm::ivec3& size, bool writable)
+	{
+		uint32_t generation = m_objs->GetTextureGeneration(textureID);
+
+		spvm_image_t img = nullptr;
+		auto cached = m_imageCache.find(textureID);
+		if (generation != 0 && cached != m_imageCache.end() && cached->second.Generation == generation && cached->second.Dim == dim && cached->second.Size == size)
+			img = cached->second.Image;
+		else {
+			float* imgData = (float*)malloc(sizeof(float) * size.x * size.y * size.z * 4);
+
+			// get the data from the GPU
+			if (dim == SpvDimCube) {
+				glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+				for (int i = 0; i < 6; i++)
+					glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, GL_FLOAT, imgData + size.x * size.y * 4 * i);
+				glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			} else if (dim == SpvDim3D) {
+				glBindTexture(GL_TEXTURE_3D, textureID);
+				glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, imgData);
+				glBindTexture(GL_TEXTURE_3D, 0);
+			} else {
+				glBindTexture(GL_TEXTURE_2D, textureID);
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, imgData);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+
+			img = (spvm_image_t)malloc(sizeof(spvm_image));
+			spvm_image_create(img, imgData, size.x, size.y, size.z);
+			img->user_data = (void*)textureID;
+			free(imgData);
+
+			// textures that aren't tracked by the ObjectManager can't be cached
+			if (generation == 0) {
+				m_images.push_back(img);
+				return img;
+			}
+
+			// the old copy might still be used by this VM - it will be freed in m_resetVM()
+			if (cached != m_imageCache.end())
+				m_images.push_back(cached->second.Image);
+
+			CachedImage& entry = m_imageCache[textureID];
+			entry.Image = img;
+			entry.Generation = generation;
+			entry.Dim = dim;
+			entry.Size = size;
+		}
+
+		// the shader can write to storage images - give it its own copy
+		if (writable) {
+			spvm_image_t copy = (spvm_image_t)malloc(sizeof(spvm_image));
+			spvm_image_create(copy, img->data, size.x, size.y, size.z);
+			copy->user_data = img->user_data;
+			m_images.push_back(copy);
+
+			return copy;
+		}
+
+		return img;
+	}
+	void DebugInformation::m_clearImageCache(bool all)
+	{
+		for (auto it = m_imageCache.begin(); it != m_imageCache.end();) {
+			// keep the textures that weren't rewritten since they were downloaded
+			if (!all && m_objs->GetTextureGeneration(it->first) == it->second.Generation) {
+				++it;
+				continue;
+			}
+
+			free(it->second.Image->data);
+			free(it->second.Image);
+			it = m_imageCache.erase(it);
+		}
+	}
 	void DebugInformation::m_copyUniforms(PipelineItem* owner, PipelineItem* item, PixelInformation* px)
 	{
 		bool pluginUsesCustomTextures = false;
@@ -676,7 +801,7 @@ namespace ed {
 
 				if (geoData->Type == pipe::GeometryItem::Rectangle) {
 					glm::vec3 scaleRect(geoData->Scale.x * SystemVariableManager::Instance().GetViewportSize().x, geoData->Scale.y * SystemVariableManager::Instance().GetViewportSize().y, 1.0f);
-					glm::vec3 posRect((geoData->Position.x + 0.5f) * m_renderer->GetLastRenderSize().x, (geoData->Position.y + 0.5f) * m_renderer->GetLastRenderSize().y, -1000.0f);
+					glm::vec3 posRect((geoData->Position.x + 0.5f) * SystemVariableManager::Instance().GetViewportSize().x, (geoData->Position.y + 0.5f) * SystemVariableManager::Instance().GetViewportSize().y, -1000.0f);
 					SystemVariableManager::Instance().SetGeometryTransform(item, scaleRect, geoData->Rotation, posRect);
 				} else
 					SystemVariableManager::Instance().SetGeometryTransform(item, geoData->Scale, geoData->Rotation, geoData->Position);
@@ -988,15 +1113,15 @@ namespace ed {
 							if (slot->members == nullptr) // if slot->members == nullptr it means that it's a pointer/function argument
 								continue;
 
-							spvm_image_t img = (spvm_image_t)malloc(sizeof(spvm_image));
-							
 							if (type_info->image_info == NULL)
 								type_info = &m_vm->results[type_info->pointer];
 							
 							glm::ivec3 imgSize(1, 1, 1);
-							float* imgData = nullptr;
-							GLuint pluginCustomTexture = 0;
+							spvm_image_t img = nullptr;
 							if (pluginUsesCustomTextures) {
+								float* imgData = nullptr;
+								GLuint pluginCustomTexture = 0;
+
 								// cubemaps
 								if (type_info->image_info->dim == SpvDimCube) {
 									pipe::PluginItemData* plData = (pipe::PluginItemData*)owner->Data;
@@ -1042,58 +1167,26 @@ namespace ed {
 									glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, imgData);
 									glBindTexture(GL_TEXTURE_2D, 0);
 								}
-							} else {
-								// cubemaps
-								if (type_info->image_info->dim == SpvDimCube) {
-									ObjectManagerItem* itemData = m_objs->GetByTextureID(textureID);
 
-									// get texture size
-									glm::ivec2 size(1, 1);
-									if (itemData != nullptr) {
-										if (itemData->RT != nullptr)
-											size = m_objs->GetRenderTextureSize(itemData);
-										else if (itemData->Image != nullptr)
-											size = itemData->Image->Size;
-										else if (itemData->Sound != nullptr)
-											size = glm::ivec2(512, 2);
-										else
-											size = itemData->TextureSize;
-									}
-									imgSize.x = size.x;
-									imgSize.y = size.y;
-									imgSize.z = 6;
+								// we don't know when plugins modify their textures - don't cache these
+								img = (spvm_image_t)malloc(sizeof(spvm_image));
+								spvm_image_create(img, imgData, imgSize.x, imgSize.y, imgSize.z);
+								free(imgData);
 
-									imgData = (float*)malloc(sizeof(float) * size.x * size.y * 6 * 4); // 6 faces
+								img->user_data = (void*)pluginCustomTexture;
+								m_images.push_back(img);
+							} else {
+								ObjectManagerItem* itemData = m_objs->GetByTextureID(textureID);
 
-									// get the data from the GPU
-									glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-									for (int i = 0; i < 6; i++)
-										glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, GL_FLOAT, imgData + size.x * size.y * 4 * i);
-									glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-								}
-								// 3d textures
-								else if (type_info->image_info->dim == SpvDim3D) {
-									// get texture size
-									ObjectManagerItem* itemData = m_objs->GetByTextureID(textureID);
-									
+								// get texture size
+								if (type_info->image_info->dim == SpvDim3D) {
 									if (itemData != nullptr) {
 										if (itemData->Image3D != nullptr)
 											imgSize = itemData->Image3D->Size;
 										else if (itemData->Type == ed::ObjectType::Texture3D)
 											imgSize = glm::ivec3(itemData->TextureSize.x, itemData->TextureSize.y, itemData->Depth);
 									}
-
-									imgData = (float*)malloc(sizeof(float) * imgSize.x * imgSize.y * imgSize.z * 4);
-
-									// get the data from the GPU
-									glBindTexture(GL_TEXTURE_3D, textureID);
-									glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, imgData);
-									glBindTexture(GL_TEXTURE_3D, 0);
-								}
-								// 2d textures
-								else {
-									// get texture size
-									ObjectManagerItem* itemData = m_objs->GetByTextureID(textureID);
+								} else {
 									glm::ivec2 size(1, 1);
 									if (itemData != nullptr) {
 										if (itemData->RT != nullptr)
@@ -1105,30 +1198,13 @@ namespace ed {
 										else
 											size = itemData->TextureSize;
 									}
-									imgSize.x = size.x;
-									imgSize.y = size.y;
-
-									imgData = (float*)malloc(sizeof(float) * size.x * size.y * 4);
-
-									// get the data from the GPU
-									glBindTexture(GL_TEXTURE_2D, textureID);
-									glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, imgData);
-									glBindTexture(GL_TEXTURE_2D, 0);
+									imgSize = glm::ivec3(size.x, size.y, type_info->image_info->dim == SpvDimCube ? 6 : 1);
 								}
-							}
 
-							if (imgData != nullptr) {
-								spvm_image_create(img, imgData, imgSize.x, imgSize.y, imgSize.z);
-								free(imgData);
+								img = m_getTextureImage(textureID, type_info->image_info->dim, imgSize, !isSampled);
 							}
 
-							if (pluginUsesCustomTextures)
-								img->user_data = (void*)pluginCustomTexture;
-							else
-								img->user_data = (void*)textureID;
-
 							slot->members[0].image_data = img;
-							m_images.push_back(img);
 							sampler2Dloc++;
 						}
 					}
@@ -1789,66 +1865,128 @@ namespace ed {
 				}
 			}
 		}
+
+		// PrepareInterpolation() was called before the VM existed
+		if (m_interpolation.Pixel == px)
+			m_buildInterpolation(m_vm, *px, m_interpolation);
 	}
 	float DebugInformation::SetPixelShaderInput(PixelInformation& pixel)
 	{
 		m_pixel = &pixel;
 		m_ubLastType = m_ubLastLine = m_ubCount = 0;
 
-		glm::vec3 weights = m_processWeight(glm::ivec2(0, 0));
-		m_interpolateValues(m_vm, weights);
+		return SetPixelShaderInput(m_vm, pixel, pixel.Coordinate);
+	}
+	float DebugInformation::SetPixelShaderInput(spvm_state_t state, const PixelInformation& pixel, const glm::ivec2& coord)
+	{
+		// use the data from PrepareInterpolation() if it was called for this pixel
+		Interpolation localInterp;
+		const Interpolation* interp = &m_interpolation;
+		if (m_interpolation.Pixel != &pixel || !m_interpolation.HasInputs) {
+			m_buildInterpolation(state, pixel, localInterp);
+			interp = &localInterp;
+		}
 
-		float depth = weights.x * pixel.FinalPosition[0].z + weights.y * pixel.FinalPosition[1].z + weights.z * pixel.FinalPosition[2].z;
+		glm::vec3 weights = m_interpolationWeights(pixel, coord);
+		m_applyInterpolation(state, *interp, weights);
 		
-		if (m_vm->derivative_used && !m_vm->_derivative_is_group_member) {
-			spvm_byte isOddX = ((int)pixel.Coordinate.x) % 2 != 0;
-			spvm_byte isOddY = ((int)pixel.Coordinate.y) % 2 != 0;
-			float modX = 1, modY = 1;
+		if (state->derivative_used && !state->_derivative_is_group_member) {
+			spvm_byte isOddX = coord.x % 2 != 0;
+			spvm_byte isOddY = coord.y % 2 != 0;
+			int modX = 1, modY = 1;
 
 			// setup frag_coord
 			if (isOddX) modX = -1;
 			if (isOddY) modY = -1;
 			
-			if (m_vm->derivative_group_x) {
-				weights = m_processWeight(glm::ivec2(modX, 0));
-				m_interpolateValues(m_vm->derivative_group_x, weights);
-			}
-			if (m_vm->derivative_group_y) {
-				weights = m_processWeight(glm::ivec2(0, modY));
-				m_interpolateValues(m_vm->derivative_group_y, weights);
-			}
-			if (m_vm->derivative_group_d) {
-				weights = m_processWeight(glm::ivec2(modX, modY));
-				m_interpolateValues(m_vm->derivative_group_d, weights);
-			}
+			// derivative group members run the same program -> same slots
+			if (state->derivative_group_x)
+				m_applyInterpolation(state->derivative_group_x, *interp, m_interpolationWeights(pixel, coord + glm::ivec2(modX, 0)));
+			if (state->derivative_group_y)
+				m_applyInterpolation(state->derivative_group_y, *interp, m_interpolationWeights(pixel, coord + glm::ivec2(0, modY)));
+			if (state->derivative_group_d)
+				m_applyInterpolation(state->derivative_group_d, *interp, m_interpolationWeights(pixel, coord + glm::ivec2(modX, modY)));
 		}
 
-		return depth / (weights.x + weights.y + weights.z);
+		return m_getDepth(pixel, weights);
 	}
-	glm::vec3 DebugInformation::m_processWeight(glm::ivec2 offset)
+	float DebugInformation::GetPixelDepth(const PixelInformation& pixel, const glm::ivec2& coord)
 	{
-		// !!! m_pixel must be set !!!
+		return m_getDepth(pixel, m_interpolationWeights(pixel, coord));
+	}
+	float DebugInformation::GetMinPixelDepth(const PixelInformation& pixel, const glm::ivec2& start, const glm::ivec2& end)
+	{
+		// depth = dot(weights, z) / sum(weights) where both parts are affine -> as long as the divisor stays
+		// positive, the smallest value is in one of the corners
+		const glm::ivec2 corners[4] = { start, glm::ivec2(end.x, start.y), glm::ivec2(start.x, end.y), end };
+
+		float ret = FLT_MAX;
+		for (const glm::ivec2& corner : corners) {
+			glm::vec3 weights = m_interpolationWeights(pixel, corner);
+			if (weights.x + weights.y + weights.z <= 0.0f)
+				return -FLT_MAX;
+			ret = std::min<float>(ret, m_getDepth(pixel, weights));
+		}
 
-		glm::vec2 pxPosition = glm::vec2(m_pixel->Coordinate + offset) / glm::vec2(m_pixel->RenderTextureSize - 1);
+		return ret;
+	}
+	glm::vec3 DebugInformation::m_interpolationWeights(const PixelInformation& pixel, const glm::ivec2& coord)
+	{
+		if (m_interpolation.Pixel == &pixel)
+			return m_interpolation.WeightX * (float)coord.x + m_interpolation.WeightY * (float)coord.y + m_interpolation.WeightC;
+		return m_processWeight(pixel, coord);
+	}
+	float DebugInformation::m_getDepth(const PixelInformation& pixel, const glm::vec3& weights)
+	{
+		float depth = weights.x * pixel.FinalPosition[0].z + weights.y * pixel.FinalPosition[1].z + weights.z * pixel.FinalPosition[2].z;
+		return depth / (weights.x + weights.y + weights.z);
+	}
+	glm::vec3 DebugInformation::m_processWeight(const PixelInformation& pixel, const glm::ivec2& coord)
+	{
+		glm::vec2 pxPosition = glm::vec2(coord) / glm::vec2(pixel.RenderTextureSize - 1);
 
 		// weigths
-		glm::vec2 scrnPos1 = m_getScreenCoord(m_pixel->FinalPosition[0]);
-		glm::vec2 scrnPos2 = m_getScreenCoord(m_pixel->FinalPosition[1]);
-		glm::vec2 scrnPos3 = m_getScreenCoord(m_pixel->FinalPosition[2]);
+		glm::vec2 scrnPos1 = m_getScreenCoord(pixel.FinalPosition[0]);
+		glm::vec2 scrnPos2 = m_getScreenCoord(pixel.FinalPosition[1]);
+		glm::vec2 scrnPos3 = m_getScreenCoord(pixel.FinalPosition[2]);
 		glm::vec3 weights = m_getWeights(scrnPos1, scrnPos2, scrnPos3, pxPosition);
-		weights *= glm::vec3(m_pixel->FinalPosition[0].w == 0.0f ? 0.0f : (1.0f / m_pixel->FinalPosition[0].w), m_pixel->FinalPosition[1].w == 0.0f ? 0.0f : (1.0f / m_pixel->FinalPosition[1].w), m_pixel->FinalPosition[2].w == 0.0f ? 0.0f : (1.0f / m_pixel->FinalPosition[2].w));
+		weights *= glm::vec3(pixel.FinalPosition[0].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[0].w), pixel.FinalPosition[1].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[1].w), pixel.FinalPosition[2].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[2].w));
 	
 		return weights;
 	}
-	void DebugInformation::m_interpolateValues(spvm_state_t state, glm::vec3 weights)
+	void DebugInformation::PrepareInterpolation(const PixelInformation& pixel)
 	{
-		// !!! m_pixel must be set !!!
+		m_interpolation.Pixel = nullptr;
+		m_interpolation.HasInputs = false;
+
+		// otherwise PreparePixelShader() will match the inputs
+		if (m_vm != nullptr && m_stage == ShaderStage::Pixel)
+			m_buildInterpolation(m_vm, pixel, m_interpolation);
+
+		// weights are an affine function of the pixel position -> find its coefficients once per triangle
+		glm::vec2 a = m_getScreenCoord(pixel.FinalPosition[0]);
+		glm::vec2 ab = m_getScreenCoord(pixel.FinalPosition[1]) - a;
+		glm::vec2 ac = m_getScreenCoord(pixel.FinalPosition[2]) - a;
+		glm::vec2 pxScale = 1.0f / glm::vec2(pixel.RenderTextureSize - 1);
+		float factor = 1 / (ab.x * ac.y - ab.y * ac.x);
 
-		float weightSum = weights.x + weights.y + weights.z;
+		glm::vec3 s(ac.y * pxScale.x * factor, -ac.x * pxScale.y * factor, (ac.x * a.y - ac.y * a.x) * factor);
+		glm::vec3 t(-ab.y * pxScale.x * factor, ab.x * pxScale.y * factor, (ab.y * a.x - ab.x * a.y) * factor);
+		glm::vec3 invW(pixel.FinalPosition[0].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[0].w), pixel.FinalPosition[1].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[1].w), pixel.FinalPosition[2].w == 0.0f ? 0.0f : (1.0f / pixel.FinalPosition[2].w));
 
-		auto* mainStageOutput = &m_pixel->VertexShaderOutput[0];
-		if (m_pixel->GeometryShaderUsed && m_pixel->GeometrySelectedPrimitive != -1 && m_pixel->GeometrySelectedVertex != -1)
-			mainStageOutput = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex];
+		m_interpolation.WeightX = glm::vec3(-s.x - t.x, s.x, t.x) * invW;
+		m_interpolation.WeightY = glm::vec3(-s.y - t.y, s.y, t.y) * invW;
+		m_interpolation.WeightC = glm::vec3(1.0f - s.z - t.z, s.z, t.z) * invW;
+		m_interpolation.Pixel = &pixel;
+	}
+	void DebugInformation::m_buildInterpolation(spvm_state_t state, const PixelInformation& pixel, Interpolation& out)
+	{
+		out.Floats.clear();
+		out.Others.clear();
+
+		const auto* mainStageOutput = &pixel.VertexShaderOutput[0];
+		if (pixel.GeometryShaderUsed && pixel.GeometrySelectedPrimitive != -1 && pixel.GeometrySelectedVertex != -1)
+			mainStageOutput = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex];
 
 		// match the ps input with vs output
 		for (int i = 0; i < state->owner->bound; i++) {
@@ -1888,23 +2026,23 @@ namespace ed {
 
 				// copy and interpolate values
 				if (outputIndex >= 0) {
-					auto* outputPtr0 = &m_pixel->VertexShaderOutput[0];
-					auto* outputPtr1 = &m_pixel->VertexShaderOutput[1];
-					auto* outputPtr2 = &m_pixel->VertexShaderOutput[2];
+					const auto* outputPtr0 = &pixel.VertexShaderOutput[0];
+					const auto* outputPtr1 = &pixel.VertexShaderOutput[1];
+					const auto* outputPtr2 = &pixel.VertexShaderOutput[2];
 
-					if (m_pixel->GeometryShaderUsed && m_pixel->GeometrySelectedPrimitive != -1 && m_pixel->GeometrySelectedVertex != -1) {
-						if (m_pixel->GeometryOutputType == GeometryShaderOutput::Points) {
-							outputPtr0 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex];
+					if (pixel.GeometryShaderUsed && pixel.GeometrySelectedPrimitive != -1 && pixel.GeometrySelectedVertex != -1) {
+						if (pixel.GeometryOutputType == GeometryShaderOutput::Points) {
+							outputPtr0 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex];
 							outputPtr1 = nullptr;
 							outputPtr2 = nullptr;
-						} else if (m_pixel->GeometryOutputType == GeometryShaderOutput::LineStrip) {
-							outputPtr0 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex - 1];
-							outputPtr1 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex];
+						} else if (pixel.GeometryOutputType == GeometryShaderOutput::LineStrip) {
+							outputPtr0 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex - 1];
+							outputPtr1 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex];
 							outputPtr2 = nullptr;
-						} else if (m_pixel->GeometryOutputType == GeometryShaderOutput::TriangleStrip) {
-							outputPtr0 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex - 2];
-							outputPtr1 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex - 1];
-							outputPtr2 = &m_pixel->GeometryOutput[m_pixel->GeometrySelectedPrimitive].Output[m_pixel->GeometrySelectedVertex];
+						} else if (pixel.GeometryOutputType == GeometryShaderOutput::TriangleStrip) {
+							outputPtr0 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex - 2];
+							outputPtr1 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex - 1];
+							outputPtr2 = &pixel.GeometryOutput[pixel.GeometrySelectedPrimitive].Output[pixel.GeometrySelectedVertex];
 						}
 					}
 
@@ -1922,23 +2060,34 @@ namespace ed {
 						vbcount = memType->value_bitcount;
 					}
 
-					// apply values
+					InterpolatedValue val;
+					val.Slot = i;
+					val.IsDouble = elType == spvm_value_type_float && vbcount > 32;
+					val.IsInteger = elType != spvm_value_type_float;
+
+					// list the values
 					for (int c = 0; c < slot->member_count; c++) {
-						if (slot->members[c].member_count == 0) {
-							if (elType == spvm_value_type_float && vbcount > 32)
-								slot->members[c].value.d = (GET_VALUE_WITH_CHECK_DOUBLE(value0, c) * weights.x + GET_VALUE_WITH_CHECK_DOUBLE(value1, c) * weights.y + GET_VALUE_WITH_CHECK_DOUBLE(value2, c) * weights.z) / weightSum;
-							else if (elType == spvm_value_type_float)
-								slot->members[c].value.f = (GET_VALUE_WITH_CHECK_FLOAT(value0, c) * weights.x + GET_VALUE_WITH_CHECK_FLOAT(value1, c) * weights.y + GET_VALUE_WITH_CHECK_FLOAT(value2, c) * weights.z) / weightSum;
-							else
-								slot->members[c].value.s = (GET_VALUE_WITH_CHECK_INT(value0, c) * weights.x + GET_VALUE_WITH_CHECK_INT(value1, c) * weights.y + GET_VALUE_WITH_CHECK_INT(value2, c) * weights.z) / weightSum;
-						} else {
-							for (int r = 0; r < slot->members[c].member_count; c++) {
-								if (elType == spvm_value_type_float && vbcount > 32)
-									slot->members[c].members[r].value.d = (GET_VALUE2_WITH_CHECK_DOUBLE(value0, c, r) * weights.x + GET_VALUE2_WITH_CHECK_DOUBLE(value1, c, r) * weights.y + GET_VALUE2_WITH_CHECK_DOUBLE(value2, c, r) * weights.z) / weightSum;
-								else if (elType == spvm_value_type_float)
-									slot->members[c].members[r].value.f = (GET_VALUE2_WITH_CHECK_FLOAT(value0, c, r) * weights.x + GET_VALUE2_WITH_CHECK_FLOAT(value1, c, r) * weights.y + GET_VALUE2_WITH_CHECK_FLOAT(value2, c, r) * weights.z) / weightSum;
-								else
-									slot->members[c].members[r].value.s = (GET_VALUE2_WITH_CHECK_INT(value0, c, r) * weights.x + GET_VALUE2_WITH_CHECK_INT(value1, c, r) * weights.y + GET_VALUE2_WITH_CHECK_INT(value2, c, r) * weights.z) / weightSum;
+						val.Member = c;
+
+						int rowCount = slot->members[c].member_count;
+						for (int r = (rowCount == 0) ? -1 : 0; r < rowCount; r++) {
+							val.Row = r;
+
+							if (val.IsDouble) {
+								val.Value[0] = r == -1 ? GET_VALUE_WITH_CHECK_DOUBLE(value0, c) : GET_VALUE2_WITH_CHECK_DOUBLE(value0, c, r);
+								val.Value[1] = r == -1 ? GET_VALUE_WITH_CHECK_DOUBLE(value1, c) : GET_VALUE2_WITH_CHECK_DOUBLE(value1, c, r);
+								val.Value[2] = r == -1 ? GET_VALUE_WITH_CHECK_DOUBLE(value2, c) : GET_VALUE2_WITH_CHECK_DOUBLE(value2, c, r);
+								out.Others.push_back(val);
+							} else if (val.IsInteger) {
+								val.Value[0] = r == -1 ? GET_VALUE_WITH_CHECK_INT(value0, c) : GET_VALUE2_WITH_CHECK_INT(value0, c, r);
+								val.Value[1] = r == -1 ? GET_VALUE_WITH_CHECK_INT(value1, c) : GET_VALUE2_WITH_CHECK_INT(value1, c, r);
+								val.Value[2] = r == -1 ? GET_VALUE_WITH_CHECK_INT(value2, c) : GET_VALUE2_WITH_CHECK_INT(value2, c, r);
+								out.Others.push_back(val);
+							} else {
+								val.Value[0] = r == -1 ? GET_VALUE_WITH_CHECK_FLOAT(value0, c) : GET_VALUE2_WITH_CHECK_FLOAT(value0, c, r);
+								val.Value[1] = r == -1 ? GET_VALUE_WITH_CHECK_FLOAT(value1, c) : GET_VALUE2_WITH_CHECK_FLOAT(value1, c, r);
+								val.Value[2] = r == -1 ? GET_VALUE_WITH_CHECK_FLOAT(value2, c) : GET_VALUE2_WITH_CHECK_FLOAT(value2, c, r);
+								out.Floats.push_back(val);
 							}
 						}
 					}
@@ -1946,40 +2095,98 @@ namespace ed {
 			}
 		}
 
+		// float values as three arrays (one per vertex) so that they can be loaded 4 at a time
+		out.FloatStride = (out.Floats.size() + 3) & ~3;
+		out.FloatValues.assign(out.FloatStride * 3, 0.0f);
+		for (size_t i = 0; i < out.Floats.size(); i++)
+			for (int v = 0; v < 3; v++)
+				out.FloatValues[v * out.FloatStride + i] = (float)out.Floats[i].Value[v];
+		out.HasInputs = true;
+	}
+	void DebugInformation::m_applyInterpolation(spvm_state_t state, const Interpolation& interp, const glm::vec3& weights)
+	{
+		float weightSum = weights.x + weights.y + weights.z;
+
+		// 32 bit floats
+		alignas(16) float result[DEBUG_INTERPOLATION_BATCH];
+		size_t count = interp.Floats.size();
+		for (size_t start = 0; start < count; start += DEBUG_INTERPOLATION_BATCH) {
+			size_t batch = std::min<size_t>(count - start, DEBUG_INTERPOLATION_BATCH);
+			const float* v0 = &interp.FloatValues[start];
+			const float* v1 = v0 + interp.FloatStride;
+			const float* v2 = v1 + interp.FloatStride;
+
+#ifdef DEBUG_USE_SSE2
+			__m128 w0 = _mm_set1_ps(weights.x);
+			__m128 w1 = _mm_set1_ps(weights.y);
+			__m128 w2 = _mm_set1_ps(weights.z);
+			__m128 wSum = _mm_set1_ps(weightSum);
+			for (size_t i = 0; i < batch; i += 4) { // arrays are padded to a multiple of 4
+				__m128 val = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v0 + i), w0), _mm_mul_ps(_mm_loadu_ps(v1 + i), w1)), _mm_mul_ps(_mm_loadu_ps(v2 + i), w2));
+				_mm_store_ps(result + i, _mm_div_ps(val, wSum));
+			}
+#else
+			for (size_t i = 0; i < batch; i++)
+				result[i] = (v0[i] * weights.x + v1[i] * weights.y + v2[i] * weights.z) / weightSum;
+#endif
+
+			for (size_t i = 0; i < batch; i++) {
+				const InterpolatedValue& val = interp.Floats[start + i];
+				spvm_member_t member = &state->results[val.Slot].members[val.Member];
+				if (val.Row != -1)
+					member = &member->members[val.Row];
+				member->value.f = result[i];
+			}
+		}
+
+		// doubles & integers
+		for (const InterpolatedValue& val : interp.Others) {
+			spvm_member_t member = &state->results[val.Slot].members[val.Member];
+			if (val.Row != -1)
+				member = &member->members[val.Row];
+
+			if (val.IsDouble)
+				member->value.d = (val.Value[0] * weights.x + val.Value[1] * weights.y + val.Value[2] * weights.z) / weightSum;
+			else
+				member->value.s = ((float)val.Value[0] * weights.x + (float)val.Value[1] * weights.y + (float)val.Value[2] * weights.z) / weightSum;
+		}
 	}
 	glm::vec4 DebugInformation::ExecutePixelShader(int x, int y, int loc)
 	{
-		if (m_vm == nullptr)
+		return ExecutePixelShader(m_vm, x, y, loc);
+	}
+	glm::vec4 DebugInformation::ExecutePixelShader(spvm_state_t state, int x, int y, int loc)
+	{
+		if (state == nullptr)
 			return glm::vec4(0.0f);
 
 		spvm_word fnMain = GetEntryPoint(m_stage);
 		if (fnMain == 0) {
-			fnMain = spvm_state_get_result_location(m_vm, "main");
+			fnMain = spvm_state_get_result_location(state, "main");
 			if (fnMain == 0)
 				return glm::vec4(0.0f);
 		}
 
-		spvm_state_prepare(m_vm, fnMain);
-		spvm_state_set_frag_coord(m_vm, x + 0.5f, y + 0.5f, 1.0f, 1.0f); // TODO: z and w components
-		spvm_state_call_function(m_vm);
+		spvm_state_prepare(state, fnMain);
+		spvm_state_set_frag_coord(state, x + 0.5f, y + 0.5f, 1.0f, 1.0f); // TODO: z and w components
+		spvm_state_call_function(state);
 
-		return GetPixelShaderOutput(loc);
+		return GetPixelShaderOutput(state, loc);
 	}
 
 	glm::vec4 DebugInformation::GetPixelShaderOutput(int loc)
+	{
+		return GetPixelShaderOutput(m_vm, loc);
+	}
+	glm::vec4 DebugInformation::GetPixelShaderOutput(spvm_state_t state, int loc)
 	{
 		glm::vec4 ret(0.0f);
 
-		spvm_word mCount = 0;
-		spvm_member_t pointer = nullptr;
-
-		for (spvm_word i = 0; i < m_shader->bound; i++) {
-			spvm_result_t slot = &m_vm->results[i];
-			spvm_result_t type = nullptr, pointerType = nullptr;
-			if (slot->pointer) {
-				type = spvm_state_get_type_info(m_vm->results, &m_vm->results[slot->pointer]);
-				pointerType = &m_vm->results[slot->pointer];
-			}
+		for (spvm_word i = 0; i < state->owner->bound; i++) {
+			spvm_result_t slot = &state->results[i];
+			spvm_result_t pointerType = nullptr;
+			if (slot->pointer)
+				pointerType = &state->results[slot->pointer];
 
 			if (slot->member_count == 0 || pointerType == nullptr || pointerType->storage_class != SpvStorageClassOutput)
 				continue;
@@ -2004,6 +2211,81 @@ namespace ed {
 		return glm::clamp(ret, 0.0f, 1.0f);
 	}
 
+	spvm_state_t DebugInformation::CreatePixelShaderWorker()
+	{
+		if (m_vm == nullptr || m_stage != ShaderStage::Pixel)
+			return nullptr;
+
+		spvm_state_t worker = _spvm_state_create_base(m_shader, true, 0);
+		spvm_state_set_extension(worker, "GLSL.std.450", m_vmGLSL);
+
+		spvm_state_t workerGroup[4] = { worker, worker->derivative_group_x, worker->derivative_group_y, worker->derivative_group_d };
+
+		// uniforms have already been copied to m_vm - copy them to the worker and its derivative group members
+		for (spvm_word i = 0; i < m_shader->bound; i++) {
+			spvm_result_t slot = &m_vm->results[i];
+			if (slot->pointer == 0 || slot->members == nullptr)
+				continue;
+
+			spvm_result_t pointerInfo = &m_vm->results[slot->pointer];
+			if (pointerInfo->value_type != spvm_value_type_pointer)
+				continue;
+
+			spvm_result_t type_info = spvm_state_get_type_info(m_vm->results, pointerInfo);
+			bool isBufferBlock = false;
+			for (int j = 0; j < type_info->decoration_count; j++)
+				if (type_info->decorations[j].type == SpvDecorationBufferBlock) {
+					isBufferBlock = true;
+					break;
+				}
+
+			// buffers might have runtime arrays which were resized in m_copyUniforms -> share the memory instead of copying it
+			if (pointerInfo->storage_class == SpvStorageClassStorageBuffer || isBufferBlock) {
+				for (int j = 0; j < 4; j++) {
+					if (workerGroup[j] == nullptr)
+						continue;
+					m_workerOriginalValues.push_back(OriginalValue(workerGroup[j], i, workerGroup[j]->results[i].member_count, workerGroup[j]->results[i].members));
+					workerGroup[j]->results[i].member_count = slot->member_count;
+					workerGroup[j]->results[i].members = slot->members;
+				}
+			} else if (pointerInfo->storage_class == SpvStorageClassUniform || pointerInfo->storage_class == SpvStorageClassUniformConstant) {
+				for (int j = 0; j < 4; j++)
+					if (workerGroup[j] != nullptr)
+						spvm_member_memcpy(workerGroup[j]->results[i].members, slot->members, slot->member_count);
+			}
+		}
+
+		return worker;
+	}
+	void DebugInformation::DeletePixelShaderWorker(spvm_state_t worker)
+	{
+		if (worker == nullptr)
+			return;
+
+		spvm_state_t workerGroup[4] = { worker, worker->derivative_group_x, worker->derivative_group_y, worker->derivative_group_d };
+
+		// return the original memory so that we don't free m_vm's buffers
+		for (int i = 0; i < m_workerOriginalValues.size(); i++) {
+			const OriginalValue& originalData = m_workerOriginalValues[i];
+
+			bool isOwned = false;
+			for (int j = 0; j < 4; j++)
+				if (workerGroup[j] != nullptr && originalData.State == workerGroup[j]) {
+					isOwned = true;
+					break;
+				}
+
+			if (isOwned) {
+				originalData.State->results[originalData.Slot].members = originalData.Members;
+				originalData.State->results[originalData.Slot].member_count = originalData.MemberCount;
+				m_workerOriginalValues.erase(m_workerOriginalValues.begin() + i);
+				i--;
+			}
+		}
+
+		spvm_state_delete(worker);
+	}
+
 	void DebugInformation::PrepareGeometryShader(PipelineItem* owner, PipelineItem* item, PixelInformation* px)
 	{
 		m_stage = ShaderStage::Geometry;
@@ -2627,6 +2909,9 @@ namespace ed {
 
 	void DebugInformation::ClearPixelData(PixelInformation& px)
 	{
+		if (m_interpolation.Pixel == &px)
+			m_interpolation.Pixel = nullptr;
+
 		// vertex shader output
 		for (int i = 0; i < px.VertexCount; i++) {
 			for (auto& out : px.VertexShaderOutput[i]) {
@@ -48,6 +48,20 @@ namespace ed {
 		glm::vec4 ExecutePixelShader(int x, int y, int loc = 0);
 		glm::vec4 GetPixelShaderOutput(int loc = 0);
 
+		// pixel shader workers - copies of the prepared pixel shader VM that can be executed on other threads
+		// (they must be deleted before the next Prepare*Shader() call)
+		spvm_state_t CreatePixelShaderWorker();
+		void DeletePixelShaderWorker(spvm_state_t worker);
+		float SetPixelShaderInput(spvm_state_t state, const PixelInformation& pixel, const glm::ivec2& coord);
+
+		// precompute the input interpolation of pixel's triangle so that SetPixelShaderInput() doesn't have to match
+		// the inputs & outputs for every pixel - call it again after pixel.FinalPosition or the selected primitive change
+		void PrepareInterpolation(const PixelInformation& pixel);
+		float GetPixelDepth(const PixelInformation& pixel, const glm::ivec2& coord); // same value as SetPixelShaderInput() returns
+		float GetMinPixelDepth(const PixelInformation& pixel, const glm::ivec2& start, const glm::ivec2& end); // lower bound of GetPixelDepth() in a rectangle, -FLT_MAX if there's none
+		glm::vec4 ExecutePixelShader(spvm_state_t state, int x, int y, int loc = 0);
+		glm::vec4 GetPixelShaderOutput(spvm_state_t state, int loc = 0);
+
 		void PrepareGeometryShader(PipelineItem* pass, PipelineItem* item, PixelInformation* px = nullptr);
 		void SetGeometryShaderInput(PixelInformation& pixel);
 		void ExecuteGeometryShader();
@@ -166,10 +180,49 @@ namespace ed {
 		}
 		glm::vec3 m_getWeights(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 p);
 
-		glm::vec3 m_processWeight(glm::ivec2 offset);
-		void m_interpolateValues(spvm_state_t state, glm::vec3 weights);
+		glm::vec3 m_processWeight(const PixelInformation& pixel, const glm::ivec2& coord);
 
-		std::vector<spvm_image_t> m_images; // TODO: clear these + smart cache
+		// pixel shader inputs of a triangle, flattened to scalars
+		struct InterpolatedValue {
+			spvm_word Slot;
+			int Member, Row; // Row == -1 -> the member isn't a matrix column
+			bool IsDouble, IsInteger;
+			double Value[3];
+		};
+		struct Interpolation {
+			Interpolation()
+			{
+				Pixel = nullptr;
+				HasInputs = false;
+				FloatStride = 0;
+			}
+
+			const PixelInformation* Pixel;		 // only set when the weights below are valid
+			glm::vec3 WeightX, WeightY, WeightC; // weights(x, y) = WeightX * x + WeightY * y + WeightC, divided by w already
+			bool HasInputs;						 // values below match the current pixel shader VM
+			std::vector<InterpolatedValue> Floats;
+			std::vector<float> FloatValues; // Floats[].Value as three arrays (one per vertex), FloatStride apart
+			size_t FloatStride;
+			std::vector<InterpolatedValue> Others; // doubles & integers
+		};
+		Interpolation m_interpolation;
+		void m_buildInterpolation(spvm_state_t state, const PixelInformation& pixel, Interpolation& out);
+		void m_applyInterpolation(spvm_state_t state, const Interpolation& interp, const glm::vec3& weights);
+		glm::vec3 m_interpolationWeights(const PixelInformation& pixel, const glm::ivec2& coord);
+		float m_getDepth(const PixelInformation& pixel, const glm::vec3& weights);
+
+		std::vector<spvm_image_t> m_images; // owned by the current VM, freed in m_resetVM()
+
+		// texel data downloaded from the GPU - reused until ObjectManager reports that the texture was rewritten
+		struct CachedImage {
+			spvm_image_t Image;
+			uint32_t Generation;
+			int Dim;
+			glm::ivec3 Size;
+		};
+		std::unordered_map<GLuint, CachedImage> m_imageCache;
+		spvm_image_t m_getTextureImage(GLuint textureID, int dim, const glm::ivec3& size, bool writable);
+		void m_clearImageCache(bool all);
 
 		spvm_context_t m_vmContext;
 		spvm_ext_opcode_func* m_vmGLSL;
@@ -194,13 +247,27 @@ namespace ed {
 		int m_threadX, m_threadY, m_threadZ, m_numGroupsX, m_numGroupsY, m_numGroupsZ;
 		void m_setupWorkgroup();
 		std::vector<OriginalValue> m_originalValues;
+		std::vector<OriginalValue> m_workerOriginalValues;
 		void m_setThreadID(spvm_state_t state, int x, int y, int z, int numGroupsX, int numGroupsY, int numGroupsZ);
 		
 		void m_copyUniforms(PipelineItem* pass, PipelineItem* item, PixelInformation* px = nullptr);
 		void m_setupVM(std::vector<unsigned int>& spv);
 		void m_resetVM();
 		spvm_state_t m_vm;
-		spvm_program_t m_shader;
+		spvm_program_t m_shader; // owned by m_programCache
+
+		// decoded programs - frame analysis sets up a VM for every primitive and parsing
+		// the same SPIR-V again each time costs more than running the shader
+		struct CachedProgram {
+			uint64_t Hash;
+			std::vector<unsigned int> SPIRV; // the program points to this copy
+			spvm_program_t Program;
+			uint64_t LastUsed;
+		};
+		std::vector<CachedProgram> m_programCache;
+		uint64_t m_programCacheTick;
+		spvm_program_t m_getProgram(const std::vector<unsigned int>& spv);
+		void m_clearProgramCache();
 		spvm_analyzer m_analyzer;
 		std::vector<unsigned int> m_spv;
 
@@ -3,7 +3,10 @@
 #include <SHADERed/Objects/ShaderCompiler.h>
 #include <SHADERed/Objects/Names.h>
 #include <SHADERed/Objects/BinaryVectorReader.h>
+#include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Engine/GeometryFactory.h>
+#include <SHADERed/Engine/GLUtils.h>
+#include <SHADERed/Engine/Hash.h>
 
 #include <thread>
 #include <algorithm>
@@ -12,6 +15,11 @@
 #include <common/BinaryVectorWriter.h>
 #include <spvgentwo/Templates.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_USE_SSE2
+#endif
+
 namespace ed {
 	FrameAnalysis::EdgeEquation::EdgeEquation(const glm::ivec2& v0, const glm::ivec2& v1)
 	{
@@ -51,11 +59,19 @@ namespace ed {
 		m_ub = nullptr;
 		m_pass = nullptr;
 		m_bkpt = nullptr;
+		m_hiZ = nullptr;
+		m_threadPool = nullptr;
 
 		m_width = 0;
 		m_height = 0;
 		m_hasBreakpoints = false;
 		m_isRegion = false;
+		m_cullFace = true;
+		m_cullFaceType = GL_BACK;
+		m_frontFace = GL_CCW;
+		m_shadeQuads = false;
+		m_vertexShaderReady = false;
+		m_renderTextureIndex = 0;
 		m_instCountAvg = m_instCountAvgN = m_instCountMax = 0;
 		m_pixelCount = m_pixelsDiscarded = m_pixelsUB = m_pixelsFailedDepthTest = 0;
 		m_triangleCount = m_trianglesDiscarded = 0;
@@ -67,11 +83,230 @@ namespace ed {
 		m_msgs = msgs;
 
 		m_pixelHistoryLocation = glm::ivec2(-1, -1);
+
+		m_varShaderTick = 0;
+		m_varFBO = m_varColor = m_varDepth = m_varPBO = 0;
+		m_varSize = glm::ivec2(0, 0);
+		m_varFence = nullptr;
+		m_varComponents = 0;
 	}
 	FrameAnalysis::~FrameAnalysis()
 	{
 		m_cleanBreakpoints();
 		m_clean();
+
+		delete m_threadPool;
+
+		m_clearVariableShaders();
+		if (m_varFence != nullptr)
+			glDeleteSync(m_varFence);
+		if (m_varFBO != 0) {
+			glDeleteFramebuffers(1, &m_varFBO);
+			glDeleteTextures(1, &m_varColor);
+			glDeleteTextures(1, &m_varDepth);
+			glDeleteBuffers(1, &m_varPBO);
+		}
+	}
+
+	int FrameAnalysis::m_getThreadCount()
+	{
+		int threadCount = Settings::Instance().Debug.AnalysisThreads;
+		if (threadCount <= 0)
+			threadCount = std::thread::hardware_concurrency();
+		return std::max<int>(1, threadCount);
+	}
+	eng::ThreadPool* FrameAnalysis::m_getThreadPool(int threadCount)
+	{
+		// calling thread is also used as a worker
+		if (m_threadPool == nullptr || m_threadPool->GetThreadCount() != threadCount - 1) {
+			delete m_threadPool;
+			m_threadPool = new eng::ThreadPool(threadCount - 1);
+		}
+		return m_threadPool;
+	}
+	void FrameAnalysis::m_onWorkerUndefinedBehavior(struct spvm_state* state, spvm_word ubID)
+	{
+		RasterWorker* worker = (RasterWorker*)state->analyzer;
+		worker->UBLastType = ubID;
+		worker->UBLastLine = state->current_line;
+		worker->UBCount = std::min<spvm_word>(worker->UBCount + 1, 11);
+	}
+	static inline uint32_t getBitCount(uint64_t mask)
+	{
+		uint32_t ret = 0;
+		for (; mask != 0; mask &= mask - 1)
+			ret++;
+		return ret;
+	}
+	void FrameAnalysis::m_updateHiZ(int startX, int startY)
+	{
+		float farthest = -FLT_MAX;
+		for (int y = startY; y < std::min<int>(m_height, startY + RASTER_BLOCK_SIZE); y++)
+			for (int x = startX; x < std::min<int>(m_width, startX + RASTER_BLOCK_SIZE); x++)
+				farthest = std::max<float>(farthest, m_depth[y * m_width + x]);
+		m_hiZ[(startY / RASTER_BLOCK_SIZE) * m_hiZWidth + (startX / RASTER_BLOCK_SIZE)] = farthest;
+	}
+	uint64_t FrameAnalysis::m_getCoverageMask(int startX, int startY, const EdgeEquation& e1, const EdgeEquation& e2, const EdgeEquation& e3)
+	{
+		uint64_t mask = 0;
+
+#ifdef RASTER_USE_SSE2
+		static_assert(RASTER_BLOCK_SIZE == 8, "coverage mask is computed 2x4 pixels per row");
+
+		const EdgeEquation* edges[3] = { &e1, &e2, &e3 };
+		__m128 x0 = _mm_add_ps(_mm_set1_ps((float)startX), _mm_set_ps(3, 2, 1, 0));
+		__m128 x1 = _mm_add_ps(x0, _mm_set1_ps(4));
+		__m128 zero = _mm_setzero_ps();
+
+		for (int y = 0; y < RASTER_BLOCK_SIZE; y++) {
+			__m128 pass0 = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			__m128 pass1 = pass0;
+
+			for (const EdgeEquation* e : edges) {
+				// same operation order as EdgeEquation::Test()
+				__m128 a = _mm_set1_ps(e->a);
+				__m128 by = _mm_set1_ps(e->b * (float)(startY + y));
+				__m128 c = _mm_set1_ps(e->c);
+				__m128 tie = _mm_castsi128_ps(_mm_set1_epi32(e->tie ? -1 : 0));
+
+				__m128 v0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x0), by), c);
+				__m128 v1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x1), by), c);
+
+				pass0 = _mm_and_ps(pass0, _mm_or_ps(_mm_cmpgt_ps(v0, zero), _mm_and_ps(_mm_cmpeq_ps(v0, zero), tie)));
+				pass1 = _mm_and_ps(pass1, _mm_or_ps(_mm_cmpgt_ps(v1, zero), _mm_and_ps(_mm_cmpeq_ps(v1, zero), tie)));
+			}
+
+			uint64_t row = (uint64_t)_mm_movemask_ps(pass0) | ((uint64_t)_mm_movemask_ps(pass1) << 4);
+			mask |= row << (y * RASTER_BLOCK_SIZE);
+		}
+#else
+		for (int y = 0; y < RASTER_BLOCK_SIZE; y++)
+			for (int x = 0; x < RASTER_BLOCK_SIZE; x++)
+				if (e1.Test(startX + x, startY + y) && e2.Test(startX + x, startY + y) && e3.Test(startX + x, startY + y))
+					mask |= 1ull << (y * RASTER_BLOCK_SIZE + x);
+#endif
+
+		return mask;
+	}
+	void FrameAnalysis::m_renderBlockWorker(RasterWorker& worker, int startX, int startY, uint64_t mask)
+	{
+		spvm_state_t vm = worker.VM;
+
+		// run every 2x2 quad only once - derivative group members already are the other three pixels of the quad
+		if (m_shadeQuads && vm->derivative_used && vm->derivative_group_x && vm->derivative_group_y && vm->derivative_group_d) {
+			spvm_state_t quad[4] = { vm, vm->derivative_group_x, vm->derivative_group_y, vm->derivative_group_d };
+			const glm::ivec2 offset[4] = { glm::ivec2(0, 0), glm::ivec2(1, 0), glm::ivec2(0, 1), glm::ivec2(1, 1) };
+
+			for (int qy = 0; qy < RASTER_BLOCK_SIZE; qy += 2) {
+				for (int qx = 0; qx < RASTER_BLOCK_SIZE; qx += 2) {
+					int x = startX + qx, y = startY + qy; // even -> groups are at +1
+
+					// depth test before interpolating the inputs
+					float depth[4];
+					uint8_t visible = 0;
+					for (int i = 0; i < 4; i++) {
+						if (!(mask & (1ull << ((qy + offset[i].y) * RASTER_BLOCK_SIZE + qx + offset[i].x))))
+							continue;
+
+						glm::ivec2 pos(x + offset[i].x, y + offset[i].y);
+						depth[i] = m_debugger->GetPixelDepth(m_pixel, pos);
+						if (depth[i] > m_depth[pos.y * m_width + pos.x]) {
+							worker.PixelsFailedDepthTest++;
+							continue;
+						}
+						visible |= 1 << i;
+					}
+					if (visible == 0)
+						continue;
+
+					// prepare inputs & calculate
+					worker.UBLastType = worker.UBLastLine = worker.UBCount = 0;
+					m_debugger->SetPixelShaderInput(vm, m_pixel, glm::ivec2(x, y));
+					m_debugger->ExecutePixelShader(vm, x, y, m_pixel.RenderTextureIndex);
+
+					for (int i = 0; i < 4; i++) {
+						if (!(visible & (1 << i)))
+							continue;
+
+						// group members are only synced up to the last derivative instruction - run the rest
+						// of their code, otherwise their outputs are the ones from the previous quad
+						if (i != 0) {
+							while (quad[i]->code_current != nullptr)
+								spvm_state_step_into(quad[i]);
+						}
+
+						if (quad[i]->discarded) {
+							worker.PixelsDiscarded++;
+							continue;
+						}
+
+						// undefined behavior is only reported for the main state
+						glm::vec4 color = m_debugger->GetPixelShaderOutput(quad[i], m_pixel.RenderTextureIndex);
+						m_storePixel(&worker, x + offset[i].x, y + offset[i].y, depth[i], color, quad[i]->instruction_count, i == 0);
+					}
+				}
+			}
+		} else {
+			for (int bit = 0; mask != 0; bit++, mask >>= 1)
+				if (mask & 1)
+					m_shadePixel<false>(&worker, startX + (bit % RASTER_BLOCK_SIZE), startY + (bit / RASTER_BLOCK_SIZE));
+		}
+
+		m_updateHiZ(startX, startY);
+	}
+	void FrameAnalysis::m_storePixel(RasterWorker* worker, int x, int y, float depth, const glm::vec4& color, int instCount, bool trackUB)
+	{
+		// blocks don't overlap -> no other thread touches these pixels
+		m_color[y * m_width + x] = m_encodeColor(color);
+		m_depth[y * m_width + x] = depth;
+		m_instCount[y * m_width + x] = instCount;
+
+		// counters are per worker and merged in m_flushBatch()
+		if (worker) {
+			worker->PixelCount++;
+			worker->InstCountMax = std::max<int>(worker->InstCountMax, instCount);
+			worker->InstCountSum += instCount;
+			worker->InstCountN++;
+		} else {
+			m_pixelCount++;
+			m_instCountMax = std::max<int>(m_instCountMax, instCount);
+			m_instCountAvgN++;
+			m_instCountAvg = m_instCountAvg + (instCount - m_instCountAvg) / m_instCountAvgN;
+		}
+
+		// undefined behavior
+		if (trackUB) {
+			spvm_word ubType = worker ? worker->UBLastType : m_debugger->GetLastUndefinedBehaviorType();
+			spvm_word ubLine = worker ? worker->UBLastLine : m_debugger->GetLastUndefinedBehaviorLine();
+			spvm_word ubCount = worker ? worker->UBCount : m_debugger->GetUndefinedBehaviorCount();
+			m_ub[y * m_width + x] = (ubType & 0x000000FF) | ((ubCount << 8) & 0x00000F00) | ((ubLine << 12) & 0xFFFFF000);
+			if (worker)
+				worker->PixelsUB += (ubType > 0);
+			else
+				m_pixelsUB += (ubType > 0);
+		} else
+			m_ub[y * m_width + x] = 0;
+
+		// pixel history
+		if (m_pixelHistoryLocation == glm::ivec2(x, y)) {
+			std::lock_guard<std::mutex> lock(m_pixelHistoryLock);
+
+			bool exists = false;
+			for (const auto& pixel : m_debugger->GetPixelList())
+				if (pixel.Object == m_pixel.Object && pixel.VertexID == m_pixel.VertexID) {
+					exists = true;
+					break;
+				}
+
+			if (!exists) {
+				PixelInformation historyPixel = m_pixel;
+				historyPixel.Coordinate = glm::ivec2(x, y);
+				historyPixel.RelativeCoordinate = glm::vec2(x, y) / glm::vec2(m_pixel.RenderTextureSize);
+				historyPixel.DebuggerColor = historyPixel.Color = color;
+				historyPixel.History = true;
+				m_debugger->AddPixel(historyPixel);
+			}
+		}
 	}
 
 	std::vector<unsigned int>* FrameAnalysis::m_getPixelShaderSPV(const char* path)
@@ -115,87 +350,132 @@ namespace ed {
 				if (strcmp(m_breakpoint[i].VM->results[j].name, "GLSL.std.450") == 0)
 					m_breakpoint[i].VM->results[j].extension = m_debugger->GetGLSLExtension();
 
+		m_breakpoint[i].Immediate = spvm_state_get_result_location(m_breakpoint[i].VM, "$$_shadered_immediate");
+		m_breakpoint[i].BoundPass = nullptr;
+		m_breakpoint[i].Bindings.clear();
+
 		m_breakpoint[i].Cached = true;
 	}
-	spvm_result_t FrameAnalysis::m_executeBreakpoint(int index, spvm_result_t& returnType)
+	void FrameAnalysis::m_bindBreakpointVariable(int index, int var)
 	{
-		spvm_state_t vm = m_breakpoint[index].VM;
-		spvm_program_t program = m_breakpoint[index].Shader;
-		const std::vector<std::string>& varList = m_breakpoint[index].VariableList;
+		BreakpointData& bkpt = m_breakpoint[index];
+		VariableBinding& binding = bkpt.Bindings[var];
+		const std::string& name = bkpt.VariableList[var];
+		spvm_state_t vm = bkpt.VM;
+		spvm_state_t psVM = m_debugger->GetVM();
+
+		binding.Resolved = false;
+
+		size_t varValueCount = 0;
+		spvm_result_t varType = nullptr;
+		spvm_member_t varValue = m_debugger->GetVariable(name, varValueCount, varType);
+		if (varValue == nullptr)
+			return; // try again on the next hit
+
+		// a parameter's storage belongs to the caller, so it's only valid for this call
+		spvm_result_t named = spvm_state_get_local_result(psVM, psVM->current_function, (spvm_string)name.c_str());
+		binding.Cached = named == nullptr || named->type != spvm_result_type_function_parameter;
+		binding.Function = (named != nullptr && named->owner != nullptr) ? psVM->current_function : nullptr;
+
+		// find the slot that owns the value
+		for (spvm_word j = 0; j < psVM->owner->bound; j++) {
+			spvm_result_t res = &psVM->results[j];
+			if (res->members != nullptr && varValue >= res->members && varValue < res->members + res->member_count) {
+				binding.Source = j;
+				binding.SourceMember = (spvm_word)(varValue - res->members);
+				binding.Resolved = true;
+				break;
+			}
+		}
+		if (!binding.Resolved)
+			return;
 
-		// copy variable values
-		spvm_state_group_sync(vm);
-		for (int i = 0; i < varList.size(); i++) {
-			size_t varValueCount = 0;
-			spvm_result_t varType = nullptr;
-			spvm_member_t varValue = m_debugger->GetVariable(varList[i], varValueCount, varType);
+		binding.Count = varValueCount;
 
-			if (varValue == nullptr)
+		// variables in the condition VM
+		binding.Targets.clear();
+		for (spvm_word j = 0; j < bkpt.Shader->bound; j++) {
+			if (vm->results[j].name == nullptr)
 				continue;
 
-			spvm_result_t pointerToVariable[4] = { nullptr };
+			spvm_result_t res = &vm->results[j];
+			spvm_result_t resType = spvm_state_get_type_info(vm->results, &vm->results[res->pointer]);
+
+			// TODO: also check for the type, or there might be some crashes caused by two vars with different type (?) (mat4 and vec4 for example)
+
+			if (res->member_count == varValueCount && resType->value_type == varType->value_type && res->members != nullptr && strcmp(name.c_str(), res->name) == 0)
+				binding.Targets.push_back(j);
+		}
 
-			for (int j = 0; j < program->bound; j++) {
+		// function parameters (which are pointers) -> make them point to the variable, only has to be done once
+		if (!binding.Targets.empty()) {
+			spvm_word target = binding.Targets.back();
+			for (spvm_word j = 0; j < bkpt.Shader->bound; j++) {
 				if (vm->results[j].name == nullptr)
 					continue;
 
 				spvm_result_t res = &vm->results[j];
-				spvm_result_t resType = spvm_state_get_type_info(vm->results, &vm->results[res->pointer]);
-
-				// TODO: also check for the type, or there might be some crashes caused by two vars with different type (?) (mat4 and vec4 for example)
-
-				if (res->member_count == varValueCount && resType->value_type == varType->value_type && res->members != nullptr && strcmp(varList[i].c_str(), res->name) == 0) {
-					spvm_member_memcpy(res->members, varValue, varValueCount);
-
-					pointerToVariable[0] = res;
+				if (res->member_count == varValueCount && res->members == nullptr && strcmp(name.c_str(), res->name) == 0) {
+					res->members = vm->results[target].members;
 
 					if (vm->derivative_used) {
-						if (vm->derivative_group_x) {
-							spvm_member_memcpy(vm->derivative_group_x->results[j].members, m_debugger->GetVariableFromState(m_debugger->GetVM()->derivative_group_x, varList[i], varValueCount), varValueCount);
-							pointerToVariable[1] = &vm->derivative_group_x->results[j];
-						}
-						if (vm->derivative_group_y) {
-							spvm_member_memcpy(vm->derivative_group_y->results[j].members, m_debugger->GetVariableFromState(m_debugger->GetVM()->derivative_group_y, varList[i], varValueCount), varValueCount);
-							pointerToVariable[2] = &vm->derivative_group_y->results[j];
-						}
-						if (vm->derivative_group_d) {
-							spvm_member_memcpy(vm->derivative_group_d->results[j].members, m_debugger->GetVariableFromState(m_debugger->GetVM()->derivative_group_d, varList[i], varValueCount), varValueCount);
-							pointerToVariable[3] = &vm->derivative_group_d->results[j];
-						}
+						if (vm->derivative_group_x) vm->derivative_group_x->results[j].members = vm->derivative_group_x->results[target].members;
+						if (vm->derivative_group_y) vm->derivative_group_y->results[j].members = vm->derivative_group_y->results[target].members;
+						if (vm->derivative_group_d) vm->derivative_group_d->results[j].members = vm->derivative_group_d->results[target].members;
 					}
 				}
 			}
+		}
+	}
+	spvm_result_t FrameAnalysis::m_executeBreakpoint(int index, spvm_result_t& returnType)
+	{
+		BreakpointData& bkpt = m_breakpoint[index];
+		spvm_state_t vm = bkpt.VM;
+		spvm_state_t psVM = m_debugger->GetVM();
+
+		// the slots only depend on the pixel shader
+		if (bkpt.BoundPass != m_pass) {
+			bkpt.BoundPass = m_pass;
+			bkpt.Bindings.clear();
+			bkpt.Bindings.resize(bkpt.VariableList.size());
+			for (VariableBinding& binding : bkpt.Bindings) {
+				binding.Resolved = false;
+				binding.Cached = false;
+				binding.Function = nullptr;
+			}
+		}
 
-			// function parameters (which are pointers)
-			if (pointerToVariable[0] != nullptr) {
-				for (int j = 0; j < program->bound; j++) {
-					if (vm->results[j].name == nullptr)
-						continue;
-
-					spvm_result_t res = &vm->results[j];
-
-					// TODO: also check for the type, or there might be some crashes caused by two vars with different type (?) (mat4 and vec4 for example)
+		// copy variable values
+		spvm_state_group_sync(vm);
+		for (int i = 0; i < bkpt.Bindings.size(); i++) {
+			VariableBinding& binding = bkpt.Bindings[i];
+			bool stale = !binding.Cached || (binding.Function != nullptr && binding.Function != psVM->current_function);
+			if (!binding.Resolved || stale) {
+				m_bindBreakpointVariable(index, i);
+				if (!binding.Resolved)
+					continue;
+			}
 
-					if (res->member_count == varValueCount && res->members == nullptr && strcmp(varList[i].c_str(), res->name) == 0) {
-						res->members = pointerToVariable[0]->members;
+			for (spvm_word target : binding.Targets) {
+				spvm_member_memcpy(vm->results[target].members, psVM->results[binding.Source].members + binding.SourceMember, binding.Count);
 
-						if (vm->derivative_used) {
-							if (vm->derivative_group_x) vm->derivative_group_x->results[j].members = pointerToVariable[1]->members;
-							if (vm->derivative_group_y) vm->derivative_group_y->results[j].members = pointerToVariable[2]->members;
-							if (vm->derivative_group_d) vm->derivative_group_d->results[j].members = pointerToVariable[3]->members;
-						}
-					}
+				if (vm->derivative_used) {
+					if (vm->derivative_group_x && psVM->derivative_group_x)
+						spvm_member_memcpy(vm->derivative_group_x->results[target].members, psVM->derivative_group_x->results[binding.Source].members + binding.SourceMember, binding.Count);
+					if (vm->derivative_group_y && psVM->derivative_group_y)
+						spvm_member_memcpy(vm->derivative_group_y->results[target].members, psVM->derivative_group_y->results[binding.Source].members + binding.SourceMember, binding.Count);
+					if (vm->derivative_group_d && psVM->derivative_group_d)
+						spvm_member_memcpy(vm->derivative_group_d->results[target].members, psVM->derivative_group_d->results[binding.Source].members + binding.SourceMember, binding.Count);
 				}
 			}
 		}
 
 		// execute $$_shadered_immediate
-		spvm_word fnImmediate = spvm_state_get_result_location(vm, "$$_shadered_immediate");
-		spvm_state_prepare(vm, fnImmediate);
+		spvm_state_prepare(vm, bkpt.Immediate);
 		spvm_state_call_function(vm);
 
 		// get type and return value
-		spvm_result_t val = &vm->results[m_breakpoint[index].ResultID];
+		spvm_result_t val = &vm->results[bkpt.ResultID];
 		returnType = spvm_state_get_type_info(vm->results, &vm->results[val->pointer]);
 		return val;
 	}
@@ -209,6 +489,7 @@ namespace ed {
 		}
 
 		m_breakpoint.clear();
+		m_breakpointLines.clear();
 		m_hasBreakpoints = false;
 	}
 
@@ -238,6 +519,11 @@ namespace ed {
 			free(m_bkpt);
 			m_bkpt = nullptr;
 		}
+
+		if (m_hiZ != nullptr) {
+			free(m_hiZ);
+			m_hiZ = nullptr;
+		}
 	}
 	void FrameAnalysis::m_copyVBOData(eng::Model::Mesh::Vertex& vertex, GLfloat* vbo, int stride)
 	{
@@ -270,21 +556,27 @@ namespace ed {
 		while (vm->code_current != nullptr) {
 			spvm_state_step_into(vm);
 			if (vm->current_line != prevLine) {
-				for (uint8_t i = 0; i < m_breakpoint.size(); i++) {
-					if (m_breakpoint[i].Breakpoint->Line == vm->current_line) {
-						if (m_breakpoint[i].Breakpoint->IsConditional && (res & (1 << i)) == 0) { // only run conditional breakpoint if needed
-							if (!m_breakpoint[i].Cached) {
-								m_cacheBreakpoint(i);
-								m_breakpoint[i].Cached = true;
-							}
-							
-							spvm_result_t resultType = nullptr;
-							spvm_result_t result = m_executeBreakpoint(i, resultType);
-							if (result && resultType->value_type == spvm_value_type_bool && result->member_count == 1)
-								res |= (result->members[0].value.b << i);
-						} else
-							res |= (1 << i);
-					}
+				uint8_t lineBkpts = (vm->current_line < m_breakpointLines.size()) ? m_breakpointLines[vm->current_line] : 0;
+				lineBkpts &= ~res; // these already hit
+
+				for (uint8_t i = 0; lineBkpts != 0; i++, lineBkpts >>= 1) {
+					if ((lineBkpts & 1) == 0)
+						continue;
+
+					if (m_breakpoint[i].Breakpoint->IsConditional) { // only run conditional breakpoint if needed
+						if (!m_breakpoint[i].Cached) {
+							m_cacheBreakpoint(i);
+							m_breakpoint[i].Cached = true;
+						}
+						if (m_breakpoint[i].VM == nullptr) // condition failed to compile
+							continue;
+
+						spvm_result_t resultType = nullptr;
+						spvm_result_t result = m_executeBreakpoint(i, resultType);
+						if (result && resultType->value_type == spvm_value_type_bool && result->member_count == 1)
+							res |= (result->members[0].value.b << i);
+					} else
+						res |= (1 << i);
 				}
 				prevLine = vm->current_line;
 			}
@@ -313,6 +605,11 @@ namespace ed {
 				m_depth[y * width + x] = FLT_MAX;
 			}
 
+		m_hiZWidth = (width + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+		m_hiZ = (float*)malloc(m_hiZWidth * ((height + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE) * sizeof(float));
+		for (size_t i = 0; i < m_hiZWidth * ((height + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE); i++)
+			m_hiZ[i] = FLT_MAX;
+
 		m_width = width;
 		m_height = height;
 
@@ -364,13 +661,31 @@ namespace ed {
 
 			m_breakpoint[i].VM = nullptr;
 			m_breakpoint[i].Shader = nullptr;
+			m_breakpoint[i].BoundPass = nullptr;
 		}
 		m_hasBreakpoints = m_breakpoint.size() > 0;
+
+		// the results are stored in 8 bits
+		m_breakpointLines.clear();
+		for (int i = 0; i < std::min<int>(m_breakpoint.size(), 8); i++) {
+			int line = m_breakpoint[i].Breakpoint->Line;
+			if (line < 0)
+				continue;
+			if (line >= m_breakpointLines.size())
+				m_breakpointLines.resize(line + 1, 0);
+			m_breakpointLines[line] |= 1 << i;
+		}
 	}
 
 	void FrameAnalysis::RenderPass(PipelineItem* pass)
 	{
 		m_pass = pass;
+		m_vertexShaderReady = false;
+
+		// same as DefaultState::Bind()
+		m_cullFace = true;
+		m_cullFaceType = GL_BACK;
+		m_frontFace = GL_CCW;
 
 		if (pass->Type == PipelineItem::ItemType::ShaderPass) {
 			pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
@@ -379,8 +694,15 @@ namespace ed {
 			m_pixel.TessellationShaderUsed = data->TSUsed;
 
 			for (PipelineItem* item : data->Items) {
+				// render state
+				if (item->Type == PipelineItem::ItemType::RenderState) {
+					pipe::RenderState* state = (pipe::RenderState*)item->Data;
+					m_cullFace = state->CullFace;
+					m_cullFaceType = state->CullFaceType;
+					m_frontFace = state->FrontFace;
+				}
 				// built-in geometry
-				if (item->Type == PipelineItem::ItemType::Geometry) {
+				else if (item->Type == PipelineItem::ItemType::Geometry) {
 					pipe::GeometryItem* geom = (pipe::GeometryItem*)item->Data;
 					const int vCount = ed::eng::GeometryFactory::VertexCount[geom->Type];
 					const int vStride = geom->Type == pipe::GeometryItem::GeometryType::ScreenQuadNDC ? 4 : 18;
@@ -408,6 +730,8 @@ namespace ed {
 					// get vertex data on the cpu
 					if (mdl->Data) {
 						for (auto& mesh : mdl->Data->Meshes) {
+							mesh.RestoreVertices();
+
 							// loop through all vertices
 							for (unsigned int p = 0; p < mesh.Indices.size(); p += 3) {
 								m_pixel.Vertex[0] = mesh.Vertices[mesh.Indices[p + 0]];
@@ -466,6 +790,10 @@ namespace ed {
 
 					free(bufPtr);
 				} 
+
+				// uniforms are per item -> the pixel shader VM can't be shared with the next one
+				m_flushBatch(item);
+				m_vertexShaderReady = false;
 			}
 		}
 	}
@@ -477,13 +805,16 @@ namespace ed {
 		m_pixel.InTopology = topology;
 		m_pixel.OutTopology = topology;
 		m_pixel.InstanceID = 0;
-		m_pixel.RenderTextureSize = m_renderer->GetLastRenderSize();
-		m_pixel.RenderTextureIndex = 0;
+		m_pixel.RenderTextureSize = glm::ivec2(m_width, m_height);
+		m_pixel.RenderTextureIndex = m_renderTextureIndex;
 		m_pixel.VertexID = vertexStart;
 		m_pixel.Fetched = false;
 
-		// run the vertex shader
-		m_debugger->PrepareVertexShader(m_pass, item, &m_pixel);
+		// run the vertex shader - its VM is kept for the following primitives until the batch is rasterized
+		if (!m_vertexShaderReady) {
+			m_debugger->PrepareVertexShader(m_pass, item, &m_pixel);
+			m_vertexShaderReady = !m_pixel.GeometryShaderUsed;
+		}
 		for (unsigned int v = 0; v < vertexCount; v++) {
 			m_debugger->SetVertexShaderInput(m_pixel, v);
 			m_pixel.VertexShaderPosition[v] = m_debugger->ExecuteVertexShader();
@@ -491,9 +822,10 @@ namespace ed {
 		}
 		memcpy(m_pixel.FinalPosition, m_pixel.VertexShaderPosition, sizeof(glm::vec4) * 3);
 
-		// render the triangle
+		// queue the triangle
+		m_batchPixels.push_back(m_pixel);
 		if (!m_pixel.GeometryShaderUsed)
-			RenderTriangle(item);
+			m_queueTriangle(-1, -1);
 		else {
 			// run the geometry shader first
 			m_debugger->PrepareGeometryShader(m_pixel.Pass, m_pixel.Object);
@@ -520,14 +852,106 @@ namespace ed {
 						m_pixel.FinalPosition[1] = prim->Position[v - d2];
 						m_pixel.FinalPosition[2] = prim->Position[v];
 
-						RenderTriangle(item);
+						m_queueTriangle(p, v);
 					}
 				}
 			}
+
+			// geometry shader was run after the copy
+			m_batchPixels.back().GeometryOutput = m_pixel.GeometryOutput;
+			m_batchPixels.back().GeometryOutputType = m_pixel.GeometryOutputType;
 		}
 
-		// cleanup
-		m_debugger->ClearPixelData(m_pixel);
+		// the shader outputs now belong to m_batchPixels.back()
+		for (int v = 0; v < vertexCount; v++)
+			m_pixel.VertexShaderOutput[v].clear();
+		m_pixel.GeometryOutput.clear();
+
+		if (m_batch.size() >= FRAME_ANALYSIS_TRIANGLE_BATCH) {
+			m_flushBatch(item);
+			m_vertexShaderReady = false;
+		}
+	}
+	void FrameAnalysis::m_queueTriangle(int geometryPrimitive, int geometryVertex)
+	{
+		RasterTriangle tri;
+		tri.Pixel = m_batchPixels.size() - 1;
+		memcpy(tri.Position, m_pixel.FinalPosition, sizeof(glm::vec4) * 3);
+		tri.GeometryPrimitive = geometryPrimitive;
+		tri.GeometryVertex = geometryVertex;
+		m_batch.push_back(tri);
+	}
+	void FrameAnalysis::m_flushBatch(PipelineItem* item)
+	{
+		if (m_batch.empty()) {
+			for (PixelInformation& pixel : m_batchPixels)
+				m_debugger->ClearPixelData(pixel);
+			m_batchPixels.clear();
+			return;
+		}
+
+		// init the renderer
+		m_debugger->PreparePixelShader(m_pass, item, &m_batchPixels[0]);
+
+		// breakpoint VMs read the variables from the debugger's VM -> can't be run on multiple threads
+		int threadCount = m_hasBreakpoints ? 1 : m_getThreadCount();
+		m_shadeQuads = Settings::Instance().Debug.AnalysisQuads && !m_hasBreakpoints;
+		if (threadCount > 1 || m_shadeQuads) {
+			m_workers.resize(threadCount);
+			for (RasterWorker& worker : m_workers) {
+				memset(&worker, 0, sizeof(RasterWorker));
+				worker.Analyzer.on_undefined_behavior = m_onWorkerUndefinedBehavior;
+				worker.VM = m_debugger->CreatePixelShaderWorker();
+				if (worker.VM != nullptr)
+					worker.VM->analyzer = &worker.Analyzer;
+			}
+
+			// shade everything with the debugger's VM instead if any of the workers couldn't be created
+			bool failed = std::any_of(m_workers.begin(), m_workers.end(), [](const RasterWorker& worker) { return worker.VM == nullptr; });
+			if (failed) {
+				for (RasterWorker& worker : m_workers)
+					m_debugger->DeletePixelShaderWorker(worker.VM);
+				m_workers.clear();
+			}
+		}
+
+		// triangles of the same primitive are next to each other
+		size_t t = 0;
+		for (size_t i = 0; i < m_batchPixels.size(); i++) {
+			std::swap(m_pixel, m_batchPixels[i]);
+
+			for (; t < m_batch.size() && m_batch[t].Pixel == i; t++) {
+				const RasterTriangle& tri = m_batch[t];
+				memcpy(m_pixel.FinalPosition, tri.Position, sizeof(glm::vec4) * 3);
+				m_pixel.GeometrySelectedPrimitive = tri.GeometryPrimitive;
+				m_pixel.GeometrySelectedVertex = tri.GeometryVertex;
+
+				RenderTriangle(item);
+			}
+
+			m_debugger->ClearPixelData(m_pixel);
+		}
+
+		// merge the results
+		for (RasterWorker& worker : m_workers) {
+			m_pixelCount += worker.PixelCount;
+			m_pixelsDiscarded += worker.PixelsDiscarded;
+			m_pixelsUB += worker.PixelsUB;
+			m_pixelsFailedDepthTest += worker.PixelsFailedDepthTest;
+
+			m_instCountMax = std::max<int>(m_instCountMax, worker.InstCountMax);
+			if (worker.InstCountN > 0) {
+				int newCount = m_instCountAvgN + worker.InstCountN;
+				m_instCountAvg = (int)(((int64_t)m_instCountAvg * m_instCountAvgN + (int64_t)worker.InstCountSum) / newCount);
+				m_instCountAvgN = newCount;
+			}
+
+			m_debugger->DeletePixelShaderWorker(worker.VM);
+		}
+		m_workers.clear();
+
+		m_batch.clear();
+		m_batchPixels.clear();
 	}
 	void FrameAnalysis::RenderTriangle(PipelineItem* item)
 	{
@@ -549,13 +973,21 @@ namespace ed {
 		EdgeEquation edge2(vert[1], vert[2]);
 		EdgeEquation edge3(vert[2], vert[0]);
 
-		// check if backfacing
+		// face culling
 		m_triangleCount++;
-		if (edge1.c + edge2.c + edge3.c < 0.0f) {
+		bool isFront = (edge1.c + edge2.c + edge3.c >= 0.0f) == (m_frontFace == GL_CCW);
+		if (m_cullFace && (m_cullFaceType == GL_FRONT_AND_BACK || isFront == (m_cullFaceType == GL_FRONT))) {
 			m_trianglesDiscarded++;
 			return;
 		}
 
+		// flip the edges of the clockwise triangles so that the inside is still positive
+		if (edge1.c + edge2.c + edge3.c < 0.0f) {
+			edge1 = EdgeEquation(vert[0], vert[2]);
+			edge2 = EdgeEquation(vert[2], vert[1]);
+			edge3 = EdgeEquation(vert[1], vert[0]);
+		}
+
 		// clip to region limits
 		if (m_isRegion) {
 			minX = std::max<int>(minX, m_regionX);
@@ -564,35 +996,82 @@ namespace ed {
 			maxY = std::min<int>(maxY, m_regionEndY);
 		}
 
+		// triangle is outside of the viewport/region
+		if (minX > maxX || minY > maxY)
+			return;
+
+		// pixels outside of the viewport/region
+		int clipX = minX, clipY = minY, clipEndX = maxX, clipEndY = maxY;
+		auto getBoundsMask = [&](int x, int y) -> uint64_t {
+			uint64_t ret = 0;
+			for (int by = std::max<int>(y, clipY); by <= std::min<int>(y + RASTER_BLOCK_STEP, clipEndY); by++)
+				for (int bx = std::max<int>(x, clipX); bx <= std::min<int>(x + RASTER_BLOCK_STEP, clipEndX); bx++)
+					ret |= 1ull << ((by - y) * RASTER_BLOCK_SIZE + (bx - x));
+			return ret;
+		};
+
 		// round to block size
 		minX &= ~(RASTER_BLOCK_SIZE - 1);
 		maxX &= ~(RASTER_BLOCK_SIZE - 1);
 		minY &= ~(RASTER_BLOCK_SIZE - 1);
 		maxY &= ~(RASTER_BLOCK_SIZE - 1);
 
-		// init the renderer
-		// TODO: tested with threads, it was 3-4 times faster though there were some artifacts which appeared only *sometimes*... it's really slow rn :(
-		m_debugger->PreparePixelShader(m_pass, item, &m_pixel);
-		m_debugger->ToggleAnalyzer(true); // turn on the analyzer
+		// weights are needed for the depth tests
+		m_debugger->PrepareInterpolation(m_pixel);
+
+		// hierarchical test: reject blocks that are completely outside one of the edges, accept the fully
+		// covered ones and only test individual pixels of blocks on the triangle's edges
+		// inspired by github.com/trenki2/SoftwareRenderer
+		std::vector<RasterBlock> blocks;
+		const EdgeEquation* edges[3] = { &edge1, &edge2, &edge3 };
 		for (int x = minX; x <= maxX; x += RASTER_BLOCK_SIZE) {
 			for (int y = minY; y <= maxY; y += RASTER_BLOCK_SIZE) {
-				// check if block is inside the triangle
-				// inspired by github.com/trenki2/SoftwareRenderer
-				bool btmLeft1 = edge1.Test(x, y), btmLeft2 = edge2.Test(x, y), btmLeft3 = edge3.Test(x, y), btmLeft = btmLeft1 && btmLeft2 && btmLeft3;
-				bool btmRight1 = edge1.Test(x + RASTER_BLOCK_STEP, y), btmRight2 = edge2.Test(x + RASTER_BLOCK_STEP, y), btmRight3 = edge3.Test(x + RASTER_BLOCK_STEP, y), btmRight = btmRight1 && btmRight2 && btmRight3;
-				bool topLeft1 = edge1.Test(x, y + RASTER_BLOCK_STEP), topLeft2 = edge2.Test(x, y + RASTER_BLOCK_STEP), topLeft3 = edge3.Test(x, y + RASTER_BLOCK_STEP), topLeft = topLeft1 && topLeft2 && topLeft3;
-				bool topRight1 = edge1.Test(x + RASTER_BLOCK_STEP, y + RASTER_BLOCK_STEP), topRight2 = edge2.Test(x + RASTER_BLOCK_STEP, y + RASTER_BLOCK_STEP), topRight3 = edge3.Test(x + RASTER_BLOCK_STEP, y + RASTER_BLOCK_STEP), topRight = topRight1 && topRight2 && topRight3;
+				bool outside = false, inside = true;
+				for (const EdgeEquation* e : edges) {
+					int result = e->Test(x, y) + e->Test(x + RASTER_BLOCK_STEP, y) + e->Test(x, y + RASTER_BLOCK_STEP) + e->Test(x + RASTER_BLOCK_STEP, y + RASTER_BLOCK_STEP);
+					outside |= result == 0;
+					inside &= result == 4;
+				}
+				if (outside)
+					continue;
+
+				uint64_t mask = inside ? ~0ull : m_getCoverageMask(x, y, edge1, edge2, edge3);
+				mask &= getBoundsMask(x, y);
+				if (mask == 0)
+					continue;
 
-				int result = btmLeft + btmRight + topLeft + topRight;
+				// hi-z: skip the block if the triangle is behind every pixel already in it
+				float farthest = m_hiZ[(y / RASTER_BLOCK_SIZE) * m_hiZWidth + (x / RASTER_BLOCK_SIZE)];
+				float nearest = m_debugger->GetMinPixelDepth(m_pixel, glm::ivec2(x, y), glm::ivec2(x + RASTER_BLOCK_STEP, y + RASTER_BLOCK_STEP));
+				if (nearest > farthest + std::max<float>(1.0f, std::abs(farthest)) * 1e-5f) {
+					m_pixelsFailedDepthTest += getBitCount(mask);
+					continue;
+				}
+
+				blocks.push_back({ x, y, mask });
+			}
+		}
+
+		// nothing to shade
+		if (blocks.empty())
+			return;
 
-				// TODO: check if triangle and and rectangle don't intersect - skip the m_renderBlock
+		if (!m_workers.empty()) {
+			int threadCount = std::min<int>(m_workers.size(), blocks.size());
+			m_getThreadPool(m_workers.size())->ParallelFor(blocks.size(), [&](size_t index, size_t workerIndex) {
+				const RasterBlock& block = blocks[index];
+				m_renderBlockWorker(m_workers[workerIndex], block.X, block.Y, block.Mask);
+			}, threadCount);
+		} else {
+			m_debugger->ToggleAnalyzer(true); // turn on the analyzer
+			for (const RasterBlock& block : blocks) {
 				if (m_hasBreakpoints)
-					m_renderBlock<true>(m_debugger, x, y, result == 4, edge1, edge2, edge3);
+					m_renderBlock<true>(block.X, block.Y, block.Mask);
 				else
-					m_renderBlock<false>(m_debugger, x, y, result == 4, edge1, edge2, edge3);
+					m_renderBlock<false>(block.X, block.Y, block.Mask);
 			}
+			m_debugger->ToggleAnalyzer(false); // turn off the analyzer
 		}
-		m_debugger->ToggleAnalyzer(false); // turn off the analyzer
 	}
 
 	float* FrameAnalysis::AllocateHeatmap()
@@ -746,15 +1225,69 @@ namespace ed {
 			bb->opFunctionEnd();
 		}
 	}
-	float* FrameAnalysis::AllocateVariableValueMap(PipelineItem* pass, const std::string& variableName, unsigned int line, uint8_t& components)
+	FrameAnalysis::VariableShader* FrameAnalysis::m_getVariableShader(PipelineItem* pass, const std::string& variableName, unsigned int line)
 	{
-		if (pass == nullptr || variableName.size() == 0 || line == 0 || pass->Type != PipelineItem::ItemType::ShaderPass)
+		const RenderEngine::CachedItem* record = nullptr;
+		for (const auto& rec : m_renderer->GetCachedItems())
+			if (rec.Item == pass) {
+				record = &rec;
+				break;
+			}
+		if (record == nullptr || record->Shader == 0)
+			return nullptr;
+
+		pipe::ShaderPass* passData = (pipe::ShaderPass*)pass->Data;
+		uint64_t hash = eng::Hash(passData->PSSPV.data(), passData->PSSPV.size() * sizeof(unsigned int));
+
+		m_varShaderTick++;
+
+		for (int i = 0; i < m_varShaders.size(); i++) {
+			VariableShader& entry = m_varShaders[i];
+			if (entry.Pass != pass || entry.Line != line || entry.Variable != variableName)
+				continue;
+
+			// pass was recompiled since
+			if (entry.Hash != hash || entry.Sources.VS != record->Sources.VS || entry.Sources.GS != record->Sources.GS || entry.Sources.TCS != record->Sources.TCS || entry.Sources.TES != record->Sources.TES) {
+				glDeleteProgram(entry.Program);
+				m_varShaders.erase(m_varShaders.begin() + i);
+				break;
+			}
+
+			entry.LastUsed = m_varShaderTick;
+			return &entry;
+		}
+
+		uint8_t components = 0;
+		GLuint program = m_buildVariableShader(pass, record->Sources, variableName, line, components);
+		if (program == 0)
 			return nullptr;
 
+		// remove the least recently used program
+		if (m_varShaders.size() >= FRAME_ANALYSIS_VARIABLE_CACHE_SIZE) {
+			auto oldest = std::min_element(m_varShaders.begin(), m_varShaders.end(), [](const VariableShader& a, const VariableShader& b) {
+				return a.LastUsed < b.LastUsed;
+			});
+			glDeleteProgram(oldest->Program);
+			m_varShaders.erase(oldest);
+		}
+
+		VariableShader entry;
+		entry.Pass = pass;
+		entry.Variable = variableName;
+		entry.Line = line;
+		entry.Hash = hash;
+		entry.Sources = record->Sources;
+		entry.Program = program;
+		entry.Components = components;
+		entry.LastUsed = m_varShaderTick;
+		m_varShaders.push_back(entry);
+
+		return &m_varShaders.back();
+	}
+	GLuint FrameAnalysis::m_buildVariableShader(PipelineItem* pass, const RenderEngine::ShaderPack& sources, const std::string& variableName, unsigned int line, uint8_t& components)
+	{
 		pipe::ShaderPass* passData = ((pipe::ShaderPass*)pass->Data);
 		std::vector<unsigned int> oldSPV = passData->PSSPV;
-		if (oldSPV.size() <= 1)
-			return nullptr;
 
 		spvgentwo::HeapAllocator* allocator = new spvgentwo::HeapAllocator();
 		spvgentwo::Grammar* grammar = new spvgentwo::Grammar(allocator);
@@ -813,24 +1346,167 @@ namespace ed {
 		delete allocator;
 
 		if (failed)
-			return nullptr;
+			return 0;
 
 		std::string newGLSL = ed::ShaderCompiler::ConvertToGLSL(newSPV, ed::ShaderLanguage::GLSL, ed::ShaderStage::Pixel, passData->TSUsed, passData->GSUsed, nullptr, false);
-		
-		// input the new shader
-		m_renderer->RecompileFromSource(pass->Name, "", newGLSL);
-		m_renderer->Render();
 
-		GLuint rendTex = m_renderer->GetTexture();
-		float* returnData = (float*)malloc(m_renderer->GetLastRenderSize().x * m_renderer->GetLastRenderSize().y * 4 * sizeof(float));
-		glBindTexture(GL_TEXTURE_2D, rendTex);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, returnData);
+		GLchar shaderMessage[1024] = { 0 };
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, newGLSL.c_str());
+		if (!gl::CheckShaderCompilationStatus(ps, shaderMessage)) {
+			glDeleteShader(ps);
+			return 0;
+		}
+
+		// link with the stages the renderer already compiled
+		GLuint program = glCreateProgram();
+		glAttachShader(program, sources.VS);
+		glAttachShader(program, ps);
+		if (passData->GSUsed) glAttachShader(program, sources.GS);
+		if (passData->TSUsed) glAttachShader(program, sources.TCS);
+		if (passData->TSUsed) glAttachShader(program, sources.TES);
+		glLinkProgram(program);
+		glDeleteShader(ps); // program keeps it alive
+
+		GLint linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		// this ID might have belonged to an older (deleted) variable viewer program
+		passData->Variables.ForgetProgram(program);
+
+		return program;
+	}
+	void FrameAnalysis::m_clearVariableShaders()
+	{
+		for (VariableShader& entry : m_varShaders)
+			glDeleteProgram(entry.Program);
+		m_varShaders.clear();
+	}
+	void FrameAnalysis::m_updateVariableTarget(const glm::ivec2& size)
+	{
+		if (m_varFBO != 0 && m_varSize == size)
+			return;
+
+		if (m_varFBO == 0) {
+			glGenFramebuffers(1, &m_varFBO);
+			glGenTextures(1, &m_varColor);
+			glGenTextures(1, &m_varDepth);
+			glGenBuffers(1, &m_varPBO);
+		}
+
+		m_varSize = size;
+
+		// float target - the values aren't clamped to [0, 1]
+		glBindTexture(GL_TEXTURE_2D, m_varColor);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size.x, size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glBindTexture(GL_TEXTURE_2D, m_varDepth);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// return old shader
-		m_renderer->Recompile(pass->Name);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_varFBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_varColor, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_varDepth, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_varPBO);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size.x * size.y * 4 * sizeof(float), nullptr, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	bool FrameAnalysis::RequestVariableValueMap(PipelineItem* pass, const std::string& variableName, unsigned int line)
+	{
+		// drop the previous request
+		if (m_varFence != nullptr) {
+			glDeleteSync(m_varFence);
+			m_varFence = nullptr;
+		}
+
+		if (pass == nullptr || variableName.size() == 0 || line == 0 || pass->Type != PipelineItem::ItemType::ShaderPass)
+			return false;
+
+		pipe::ShaderPass* passData = ((pipe::ShaderPass*)pass->Data);
+		if (passData->PSSPV.size() <= 1 || !passData->Active)
+			return false;
+
+		VariableShader* varShader = m_getVariableShader(pass, variableName, line);
+		if (varShader == nullptr)
+			return false;
+
+		// same viewport as RenderEngine::Render() uses for this pass -> size of the last render texture
+		glm::ivec2 windowSize = m_renderer->GetLastRenderSize();
+		glm::ivec2 targetSize = windowSize;
+		for (int i = 0; i < passData->RTCount; i++) {
+			GLuint rt = passData->RenderTextures[i];
+			if (rt == m_renderer->GetTexture()) {
+				targetSize = windowSize;
+				continue;
+			}
+
+			ObjectManagerItem* rtItem = m_objects->GetByTextureID(rt);
+			if (rtItem != nullptr && rtItem->RT != nullptr)
+				targetSize = rtItem->RT->CalculateSize(windowSize.x, windowSize.y);
+		}
+
+		m_varComponents = varShader->Components;
+		m_updateVariableTarget(targetSize);
+
+		// render the passes up to (and including) this one, with the instrumented shader writing to our target
+		m_renderer->SetPassOverride(pass, varShader->Program, m_varFBO);
+		m_renderer->Render();
+		m_renderer->SetPassOverride(nullptr);
+
+		// the frame stopped at this pass - render it again so that the later passes & the window aren't left half done
 		m_renderer->Render();
 
+		// with a pack buffer bound, glReadPixels() returns right away - nothing else writes to m_varFBO
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_varFBO);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_varPBO);
+		glReadPixels(0, 0, m_varSize.x, m_varSize.y, GL_RGBA, GL_FLOAT, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		m_varFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush(); // make sure the fence reaches the GPU
+
+		return true;
+	}
+	bool FrameAnalysis::IsVariableValueMapReady()
+	{
+		if (m_varFence == nullptr)
+			return false;
+
+		return glClientWaitSync(m_varFence, 0, 0) != GL_TIMEOUT_EXPIRED;
+	}
+	float* FrameAnalysis::AllocateVariableValueMap(uint8_t& components)
+	{
+		if (!IsVariableValueMapReady())
+			return nullptr;
+
+		glDeleteSync(m_varFence);
+		m_varFence = nullptr;
+
+		size_t size = m_varSize.x * m_varSize.y * 4 * sizeof(float);
+		float* returnData = (float*)malloc(size);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_varPBO);
+		void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+		if (data != nullptr) {
+			memcpy(returnData, data, size);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		} else
+			memset(returnData, 0, size);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		components = m_varComponents;
+
 		return returnData;
 	}
 }
\ No newline at end of file
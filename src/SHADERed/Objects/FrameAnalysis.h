@@ -1,9 +1,16 @@
 #pragma once
 #include <SHADERed/Objects/PipelineItem.h>
 #include <SHADERed/Objects/DebugInformation.h>
+#include <SHADERed/Engine/ThreadPool.h>
+
+#include <mutex>
 
 #define RASTER_BLOCK_SIZE 8
 #define RASTER_BLOCK_STEP RASTER_BLOCK_SIZE - 1
+#define FRAME_ANALYSIS_VARIABLE_CACHE_SIZE 16 // instrumented programs kept for the variable viewer
+#define FRAME_ANALYSIS_TRIANGLE_BATCH 1024	  // triangles shaded with the same pixel shader VM & workers
+
+static_assert(RASTER_BLOCK_SIZE * RASTER_BLOCK_SIZE == 64, "block coverage is stored in a 64 bit mask");
 
 namespace ed {
 	class FrameAnalysis {
@@ -19,7 +26,10 @@ namespace ed {
 
 		void RenderPass(PipelineItem* pass);
 		void RenderPrimitive(PipelineItem* item, unsigned int vertexStart, uint8_t vertexCount, unsigned int topology);
-		void RenderTriangle(PipelineItem* item);
+		void RenderTriangle(PipelineItem* item); // pixel shader must already be prepared, see m_flushBatch()
+		inline void SetRenderTextureIndex(int index) { m_renderTextureIndex = index; } // pixel shader output location that is stored
+
+		inline float* GetDepthOutput() { return m_depth; } // FLT_MAX -> nothing was drawn to the pixel
 
 		inline uint32_t* GetColorOutput() { return m_color; }
 		inline glm::ivec2 GetOutputSize() { return glm::ivec2(m_width, m_height); }
@@ -45,7 +55,11 @@ namespace ed {
 		uint32_t* AllocateGlobalBreakpointsMap();
 		inline bool HasGlobalBreakpoints() { return m_hasBreakpoints; }
 
-		float* AllocateVariableValueMap(PipelineItem* pass, const std::string& variableName, unsigned int line, uint8_t& components);
+		// variable viewer - renders the pass with an instrumented pixel shader and reads the values back asynchronously
+		bool RequestVariableValueMap(PipelineItem* pass, const std::string& variableName, unsigned int line);
+		bool IsVariableValueMapReady(); // doesn't block
+		float* AllocateVariableValueMap(uint8_t& components); // nullptr if the request failed or isn't ready yet
+		inline glm::ivec2 GetVariableValueMapSize() { return m_varSize; } // size of the pass' render target
 
 	private:
 		class EdgeEquation {
@@ -57,19 +71,99 @@ namespace ed {
 
 			EdgeEquation(const glm::ivec2& v0, const glm::ivec2& v1);
 			
-			inline bool Test(int x, int y) {
+			inline bool Test(int x, int y) const {
 				return m_test(m_evaluate(x, y));
 			}
 
 		private:
-			inline float m_evaluate(int x, int y) {
+			inline float m_evaluate(int x, int y) const {
 				return a * x + b * y + c;
 			}
-			inline bool m_test(float v) {
+			inline bool m_test(float v) const {
 				return (v > 0 || v == 0 && tie);
 			}
 		};
 
+		// everything a thread needs to shade its own blocks - counters are merged once the batch is done
+		struct RasterWorker {
+			spvm_analyzer Analyzer; // must be the first member -> spvm_state::analyzer is cast back to RasterWorker
+			spvm_state_t VM;
+
+			uint32_t PixelCount, PixelsDiscarded, PixelsUB, PixelsFailedDepthTest;
+			int InstCountMax;
+			uint64_t InstCountSum;
+			int InstCountN;
+
+			spvm_word UBLastType, UBLastLine, UBCount;
+		};
+		static void m_onWorkerUndefinedBehavior(struct spvm_state* state, spvm_word ubID);
+
+		eng::ThreadPool* m_threadPool;
+		std::mutex m_pixelHistoryLock;
+		int m_getThreadCount();
+		eng::ThreadPool* m_getThreadPool(int threadCount);
+		void m_renderBlockWorker(RasterWorker& worker, int startX, int startY, uint64_t mask);
+		void m_storePixel(RasterWorker* worker, int x, int y, float depth, const glm::vec4& color, int instCount, bool trackUB); // trackUB == false -> m_ub isn't known for this pixel
+		bool m_shadeQuads; // Debug.AnalysisQuads
+
+		// vertex (and geometry) shader output is collected first and the triangles are rasterized in batches, so
+		// that the pixel shader VM and the workers are set up once per batch instead of once per triangle. The
+		// triangles of a batch are still rasterized one after another (with each triangle's blocks shaded in
+		// parallel) instead of being binned into screen tiles - DebugInformation keeps a single interpolation
+		// state, so only one triangle can be in flight at a time
+		struct RasterTriangle {
+			size_t Pixel; // index in m_batchPixels
+			glm::vec4 Position[3];
+			int GeometryPrimitive, GeometryVertex;
+		};
+		std::vector<PixelInformation> m_batchPixels; // these own the shader outputs of the batched primitives
+		std::vector<RasterTriangle> m_batch;
+		std::vector<RasterWorker> m_workers;
+		bool m_vertexShaderReady; // false -> debugger's VM was used for another stage since PrepareVertexShader()
+		void m_queueTriangle(int geometryPrimitive, int geometryVertex);
+		void m_flushBatch(PipelineItem* item);
+
+		// pixels of a block covered by the triangle, bit (y * RASTER_BLOCK_SIZE + x)
+		struct RasterBlock {
+			int X, Y;
+			uint64_t Mask;
+		};
+		uint64_t m_getCoverageMask(int startX, int startY, const EdgeEquation& e1, const EdgeEquation& e2, const EdgeEquation& e3);
+
+		// farthest depth of every block - lets RenderTriangle() skip the blocks that are hidden completely
+		float* m_hiZ;
+		size_t m_hiZWidth;
+		void m_updateHiZ(int startX, int startY);
+
+		// face culling of the current pass' render state
+		bool m_cullFace;
+		GLenum m_cullFaceType, m_frontFace;
+
+		// instrumented pixel shaders for the variable viewer - switching between the inspected variables
+		// shouldn't recompile anything
+		struct VariableShader {
+			PipelineItem* Pass;
+			std::string Variable;
+			unsigned int Line;
+			uint64_t Hash; // pixel shader's SPIR-V
+			RenderEngine::ShaderPack Sources; // other stages this program was linked with
+			GLuint Program;
+			uint8_t Components;
+			uint64_t LastUsed;
+		};
+		std::vector<VariableShader> m_varShaders;
+		uint64_t m_varShaderTick;
+		VariableShader* m_getVariableShader(PipelineItem* pass, const std::string& variableName, unsigned int line);
+		GLuint m_buildVariableShader(PipelineItem* pass, const RenderEngine::ShaderPack& sources, const std::string& variableName, unsigned int line, uint8_t& components);
+		void m_clearVariableShaders();
+
+		// variable viewer's render target & the pending readback
+		GLuint m_varFBO, m_varColor, m_varDepth, m_varPBO;
+		glm::ivec2 m_varSize;
+		GLsync m_varFence;
+		uint8_t m_varComponents;
+		void m_updateVariableTarget(const glm::ivec2& size);
+
 		DebugInformation* m_debugger;
 		RenderEngine* m_renderer;
 		PipelineManager* m_pipeline;
@@ -94,6 +188,17 @@ namespace ed {
 		uint32_t* m_ub;
 
 		bool m_hasBreakpoints;
+		// where the condition VM gets the value of a variable from - resolved once per shader pass for globals and
+		// locals, on every hit for function parameters (they point to whatever the current caller passed)
+		struct VariableBinding {
+			bool Resolved;
+			bool Cached;			// false -> resolve again on the next hit
+			spvm_result_t Function; // function that owns the local variable, nullptr for globals
+			spvm_word Source;		// slot in the pixel shader VM
+			spvm_word SourceMember; // != 0 for the members of anonymous buffers
+			size_t Count;
+			std::vector<spvm_word> Targets; // slots in the condition VM
+		};
 		struct BreakpointData {
 			const dbg::Breakpoint* Breakpoint;
 			glm::vec3 Color;
@@ -102,22 +207,29 @@ namespace ed {
 			// VM stuff
 			bool Cached;
 			int ResultID;
+			spvm_word Immediate; // $$_shadered_immediate function
 			std::vector<std::string> VariableList;
 			std::vector<unsigned int> SPIRV;
 
+			PipelineItem* BoundPass;
+			std::vector<VariableBinding> Bindings; // one for each item in VariableList
+
 			spvm_program_t Shader;
 			spvm_state_t VM;
 		};
 		std::vector<BreakpointData> m_breakpoint;
+		std::vector<uint8_t> m_breakpointLines; // line -> bits of the breakpoints on that line
 		uint8_t* m_bkpt;
 
 		std::vector<unsigned int>* m_getPixelShaderSPV(const char* path);
 		void m_cacheBreakpoint(int index);
+		void m_bindBreakpointVariable(int index, int var);
 		spvm_result_t m_executeBreakpoint(int index, spvm_result_t& retType);
 		void m_cleanBreakpoints();
 
 		PipelineItem* m_pass;
 		PixelInformation m_pixel;
+		int m_renderTextureIndex;
 
 		void m_variableViewerProcess(spvgentwo::Module* module, const spvgentwo::Function& func, const std::string& variableName, unsigned int line, spvgentwo::Instruction* outputInstruction, spvgentwo::Instruction*& inputInstruction, uint8_t& components);
 
@@ -131,69 +243,59 @@ namespace ed {
 
 		glm::vec4 m_executePixelShaderWithBreakpoints(int x, int y, uint8_t& res, int loc = 0);
 
+		// depth test, shading & storing of a single covered pixel. worker == nullptr -> the debugger's own VM is
+		// used (breakpoints, or the workers couldn't be created), otherwise the worker's VM and counters
 		template <bool hasBreakpoints>
-		void m_renderBlock(DebugInformation* renderer, size_t startX, size_t startY, bool skipChecks, EdgeEquation& e1, EdgeEquation& e2, EdgeEquation& e3)
+		void m_shadePixel(RasterWorker* worker, int x, int y)
 		{
-			for (size_t x = startX; x < std::min<size_t>(m_width, startX + RASTER_BLOCK_SIZE); x++) {
-				for (size_t y = startY; y < std::min<size_t>(m_height, startY + RASTER_BLOCK_SIZE); y++) {
-					if (skipChecks || (e1.Test(x, y) && e2.Test(x, y) && e3.Test(x, y))) {
-						m_pixel.Coordinate = glm::ivec2(x, y);
-						m_pixel.RelativeCoordinate = glm::vec2(x, y) / glm::vec2(m_pixel.RenderTextureSize);
-
-						// prepare inputs & calculate
-						float depth = renderer->SetPixelShaderInput(m_pixel);
-
-						if (depth <= m_depth[y * m_width + x]) { // TODO: OpExecutionMode DepthReplacing -> execute pixel shader, then go through depth test
-							if constexpr (!hasBreakpoints)
-								m_pixel.DebuggerColor = renderer->ExecutePixelShader(x, y, m_pixel.RenderTextureIndex);
-							else
-								m_pixel.DebuggerColor = m_executePixelShaderWithBreakpoints(x, y, m_bkpt[y * m_width + x], m_pixel.RenderTextureIndex);
-
-							if (renderer->GetVM()->discarded) {
-								m_pixelsDiscarded++;
-								continue;
-							}
-
-							// actual color and depth
-							m_color[y * m_width + x] = m_encodeColor(m_pixel.DebuggerColor);
-							m_depth[y * m_width + x] = depth;
-							m_pixelCount++;
-
-							// instruction count / heatmap stuff
-							int instCount = renderer->GetVM()->instruction_count;
-							m_instCount[y * m_width + x] = instCount;
-							m_instCountMax = std::max<int>(m_instCountMax, instCount);
-							m_instCountAvgN++;
-							m_instCountAvg = m_instCountAvg + (instCount - m_instCountAvg) / m_instCountAvgN;
-
-							// undefined behavior
-							spvm_word ubType = renderer->GetLastUndefinedBehaviorType();
-							spvm_word ubLine = renderer->GetLastUndefinedBehaviorLine();
-							spvm_word ubCount = renderer->GetUndefinedBehaviorCount();
-							m_ub[y * m_width + x] = (ubType & 0x000000FF) | ((ubCount << 8) & 0x00000F00) | ((ubLine << 12) & 0xFFFFF000);
-							m_pixelsUB += (ubType > 0);
-
-							// pixel history
-							if (m_pixelHistoryLocation == m_pixel.Coordinate) {
-								bool exists = false;
-								for (const auto& pixel : m_debugger->GetPixelList())
-									if (pixel.Object == m_pixel.Object && pixel.VertexID == m_pixel.VertexID) {
-										exists = true;
-										break;
-									}
-
-								if (!exists) {
-									m_pixel.Color = m_pixel.DebuggerColor;
-									m_pixel.History = true;
-									m_debugger->AddPixel(m_pixel);
-								}
-							}
-
-						} else
-							m_pixelsFailedDepthTest++;
-					}
-				}
+			// depth test before interpolating the inputs
+			float depth = m_debugger->GetPixelDepth(m_pixel, glm::ivec2(x, y));
+			if (depth > m_depth[y * m_width + x]) { // TODO: OpExecutionMode DepthReplacing -> execute pixel shader, then go through depth test
+				if (worker)
+					worker->PixelsFailedDepthTest++;
+				else
+					m_pixelsFailedDepthTest++;
+				return;
+			}
+
+			// prepare inputs & calculate
+			spvm_state_t vm = nullptr;
+			glm::vec4 color;
+			if (worker) {
+				vm = worker->VM;
+				worker->UBLastType = worker->UBLastLine = worker->UBCount = 0;
+				m_debugger->SetPixelShaderInput(vm, m_pixel, glm::ivec2(x, y));
+				color = m_debugger->ExecutePixelShader(vm, x, y, m_pixel.RenderTextureIndex);
+			} else {
+				vm = m_debugger->GetVM();
+				m_pixel.Coordinate = glm::ivec2(x, y);
+				m_pixel.RelativeCoordinate = glm::vec2(x, y) / glm::vec2(m_pixel.RenderTextureSize);
+				m_debugger->SetPixelShaderInput(m_pixel);
+
+				if constexpr (!hasBreakpoints)
+					color = m_debugger->ExecutePixelShader(x, y, m_pixel.RenderTextureIndex);
+				else
+					color = m_executePixelShaderWithBreakpoints(x, y, m_bkpt[y * m_width + x], m_pixel.RenderTextureIndex);
+			}
+
+			if (vm->discarded) {
+				if (worker)
+					worker->PixelsDiscarded++;
+				else
+					m_pixelsDiscarded++;
+				return;
 			}
+
+			m_storePixel(worker, x, y, depth, color, vm->instruction_count, true);
+		}
+		template <bool hasBreakpoints>
+		void m_renderBlock(size_t startX, size_t startY, uint64_t mask)
+		{
+			for (int bit = 0; mask != 0; bit++, mask >>= 1)
+				if (mask & 1)
+					m_shadePixel<hasBreakpoints>(nullptr, startX + (bit % RASTER_BLOCK_SIZE), startY + (bit / RASTER_BLOCK_SIZE));
+
+			m_updateHiZ(startX, startY);
 		}
 	};
 }
\ No newline at end of file
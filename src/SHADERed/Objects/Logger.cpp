@@ -12,6 +12,8 @@ namespace ed {
 		if (!Settings::Instance().General.Log)
 			return;
 
+		std::lock_guard<std::mutex> lock(m_lock);
+
 		time_t now = time(0);
 		tm* ltm = localtime(&now);
 
@@ -43,7 +45,7 @@ namespace ed {
 		data << msg;
 
 		if (Settings::Instance().General.PipeLogsToTerminal)
-			std::cout << data.str() << std::endl;
+			(PipeToStderr ? std::cerr : std::cout) << data.str() << std::endl;
 
 		if (Settings::Instance().General.StreamLogs) {
 			std::ofstream log(ed::Settings::Instance().ConvertPath("log.txt"), std::ios_base::app | std::ios_base::out);
@@ -60,6 +62,8 @@ namespace ed {
 		time_t now = time(0);
 		tm* ltm = localtime(&now);
 
+		std::lock_guard<std::mutex> lock(m_lock);
+
 		std::ofstream file(ed::Settings::Instance().ConvertPath("log.txt"));
 		file << "Log -> " << ltm->tm_mday << "." << ltm->tm_mon + 1 << "." << 1900 + ltm->tm_year << "\n";
 
@@ -1,15 +1,18 @@
 #pragma once
 #include <SHADERed/Objects/MessageStack.h>
+#include <mutex>
 #include <string>
 
 namespace ed {
 	class Logger {
 	public:
 		MessageStack* Stack;
+		bool PipeToStderr; // stdout carries other data (--render -) -> terminal logs are written to stderr
 
 		Logger()
 		{
 			Stack = nullptr;
+			PipeToStderr = false;
 		}
 
 		static Logger& Get()
@@ -23,5 +26,6 @@ namespace ed {
 
 	private:
 		std::vector<std::string> m_msgs;
+		std::mutex m_lock; // assets can be loaded on multiple threads
 	};
 }
\ No newline at end of file
@@ -23,6 +23,8 @@ namespace ed {
 	{
 		m_binds.clear();
 		memset(m_kbTexture, 0, sizeof(unsigned char) * 256 * 3);
+		m_loadPool = nullptr;
+		m_lastTexGeneration = 0;
 		
 		m_keyIDs = {
 			{ SDLK_BACKSPACE, 8 },
@@ -132,6 +134,14 @@ namespace ed {
 	ObjectManager::~ObjectManager()
 	{
 		Clear();
+		delete m_loadPool;
+	}
+
+	void flipTextureRows(const unsigned char* src, unsigned char* dst, int width, int height)
+	{
+		size_t stride = width * 4;
+		for (int y = 0; y < height; y++)
+			memcpy(dst + y * stride, src + (height - y - 1) * stride, stride);
 	}
 
 	void loadCubemapFace(GLuint face, const std::string& path, int& w, int& h)
@@ -192,6 +202,12 @@ namespace ed {
 	{
 		Logger::Get().Log("Clearing ObjectManager contents...");
 
+		for (PendingTexture* tex : m_pendingTextures) {
+			tex->Task.wait();
+			m_freePendingTexture(tex);
+		}
+		m_pendingTextures.clear();
+
 		for (int i = 0; i < m_items.size(); i++) {
 			if (m_items[i]->Plugin != nullptr) {
 				PluginObject* pobj = m_items[i]->Plugin;
@@ -203,6 +219,7 @@ namespace ed {
 
 		m_binds.clear();
 		m_uniformBinds.clear();
+		m_texGenerations.clear();
 		m_items.clear();
 	}
 	bool ObjectManager::CreateRenderTexture(const std::string& name)
@@ -232,6 +249,7 @@ namespace ed {
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		BumpTextureGeneration(item->Texture);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -269,23 +287,18 @@ namespace ed {
 		bool isDDS = (std::filesystem::path(file).extension().u8string() == ".dds");
 		std::string path = m_parser->GetProjectPath(file);
 
-		int width = 0, height = 0;
-		unsigned char* data = nullptr;
-		dds_image_t ddsImage = nullptr;
-
+		// only read the header here so that unsupported/corrupted files are rejected before the item is registered
+		bool isValid = false;
 		if (isDDS) {
-			ddsImage = dds_load_from_file(path.c_str());
-
-			data = ddsImage->pixels;
-			width = ddsImage->header.width;
-			height = ddsImage->header.height;
+			std::ifstream ddsFile(path, std::ios::binary);
+			char magic[4] = { 0 };
+			isValid = ddsFile.read(magic, 4) && memcmp(magic, "DDS ", 4) == 0;
 		} else {
-			int nrChannels = 0;
-			stbi_set_flip_vertically_on_load(1);
-			data = stbi_load(path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+			int width = 0, height = 0, nrChannels = 0;
+			isValid = stbi_info(path.c_str(), &width, &height, &nrChannels) && width > 0 && height > 0;
 		}
 
-		if (data == nullptr || width == 0 || height == 0 || (isDDS && ddsImage == nullptr)) {
+		if (!isValid) {
 			Logger::Get().Log("Failed to load a texture " + file + " from file", true);
 			return false;
 		}
@@ -295,50 +308,128 @@ namespace ed {
 		ObjectManagerItem* item = new ObjectManagerItem(file, ObjectType::Texture);
 		m_items.push_back(item);
 
-		// normal texture
-		glGenTextures(1, &item->Texture);
-		glBindTexture(GL_TEXTURE_2D, item->Texture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, item->Texture_MinFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, item->Texture_MagFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, item->Texture_WrapS);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, item->Texture_WrapT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// 1x1 placeholders - the real data is uploaded in FinishTextureLoads()
+		const unsigned char placeholder[4] = { 0, 0, 0, 255 };
+		GLuint* textures[2] = { &item->Texture, &item->FlippedTexture };
+		for (int i = 0; i < 2; i++) {
+			glGenTextures(1, textures[i]);
+			glBindTexture(GL_TEXTURE_2D, *textures[i]);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, item->Texture_MinFilter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, item->Texture_MagFilter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, item->Texture_WrapS);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, item->Texture_WrapT);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		}
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// flipped texture
-		unsigned char* flippedData = (unsigned char*)malloc(width * height * 4);
-
-		for (int x = 0; x < width; x++) {
-			for (int y = 0; y < height; y++) {
-				flippedData[(y * width + x) * 4 + 0] = data[((height - y - 1) * width + x) * 4 + 0];
-				flippedData[(y * width + x) * 4 + 1] = data[((height - y - 1) * width + x) * 4 + 1];
-				flippedData[(y * width + x) * 4 + 2] = data[((height - y - 1) * width + x) * 4 + 2];
-				flippedData[(y * width + x) * 4 + 3] = data[((height - y - 1) * width + x) * 4 + 3];
+		item->TextureSize = glm::ivec2(1, 1);
+
+		// decode + flip on a worker thread
+		PendingTexture* tex = new PendingTexture();
+		tex->Item = item;
+		tex->Data = nullptr;
+		tex->FlippedData = nullptr;
+		tex->DDS = nullptr;
+		tex->Width = tex->Height = 0;
+
+		if (m_loadPool == nullptr)
+			m_loadPool = new eng::ThreadPool();
+
+		tex->Task = m_loadPool->Submit([tex, path, isDDS]() {
+			if (isDDS) {
+				dds_image_t ddsImage = dds_load_from_file(path.c_str());
+				if (ddsImage != nullptr) {
+					tex->DDS = ddsImage;
+					tex->Data = ddsImage->pixels;
+					tex->Width = ddsImage->header.width;
+					tex->Height = ddsImage->header.height;
+				}
+			} else {
+				int nrChannels = 0;
+				stbi_set_flip_vertically_on_load_thread(1);
+				tex->Data = stbi_load(path.c_str(), &tex->Width, &tex->Height, &nrChannels, STBI_rgb_alpha);
+			}
+
+			if (tex->Data != nullptr && tex->Width > 0 && tex->Height > 0) {
+				tex->FlippedData = (unsigned char*)malloc(tex->Width * tex->Height * 4);
+				flipTextureRows(tex->Data, tex->FlippedData, tex->Width, tex->Height);
 			}
+		});
+
+		m_pendingTextures.push_back(tex);
+
+		return true;
+	}
+	void ObjectManager::FinishTextureLoads(bool wait)
+	{
+		for (int i = 0; i < m_pendingTextures.size(); i++) {
+			PendingTexture* tex = m_pendingTextures[i];
+
+			if (wait)
+				tex->Task.wait();
+			else if (tex->Task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			bool uploaded = m_uploadTexture(tex);
+			std::string name = tex->Item->Name;
+			m_freePendingTexture(tex);
+
+			m_pendingTextures.erase(m_pendingTextures.begin() + i);
+			i--;
+
+			// the header was fine but the data wasn't - don't keep the placeholder around
+			if (!uploaded)
+				Remove(name);
+		}
+	}
+	bool ObjectManager::m_uploadTexture(PendingTexture* tex)
+	{
+		ObjectManagerItem* item = tex->Item;
+
+		if (tex->FlippedData == nullptr) {
+			Logger::Get().Log("Failed to load a texture " + item->Name + " from file", true);
+			return false;
 		}
 
-		glGenTextures(1, &item->FlippedTexture);
+		// normal texture
+		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex->Width, tex->Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex->Data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		// flipped texture
 		glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, item->Texture_MinFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, item->Texture_MagFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, item->Texture_WrapS);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, item->Texture_WrapT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, flippedData);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex->Width, tex->Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex->FlippedData);
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		item->TextureSize = glm::ivec2(width, height);
+		BumpTextureGeneration(item->Texture);
+		BumpTextureGeneration(item->FlippedTexture);
 
-		free(flippedData);
-
-		if (isDDS)
-			dds_image_free(ddsImage);
-		else
-			stbi_image_free(data);
+		item->TextureSize = glm::ivec2(tex->Width, tex->Height);
 
 		return true;
 	}
+	void ObjectManager::m_cancelTextureLoad(ObjectManagerItem* item)
+	{
+		for (int i = 0; i < m_pendingTextures.size(); i++) {
+			if (m_pendingTextures[i]->Item == item) {
+				m_pendingTextures[i]->Task.wait();
+				m_freePendingTexture(m_pendingTextures[i]);
+				m_pendingTextures.erase(m_pendingTextures.begin() + i);
+				return;
+			}
+		}
+	}
+	void ObjectManager::m_freePendingTexture(PendingTexture* tex)
+	{
+		if (tex->DDS != nullptr)
+			dds_image_free((dds_image_t)tex->DDS);
+		else if (tex->Data != nullptr)
+			stbi_image_free(tex->Data);
+
+		free(tex->FlippedData);
+		delete tex;
+	}
 	bool ObjectManager::CreateTexture3D(const std::string& file)
 	{
 		Logger::Get().Log("Creating a 3D texture " + file + " ...");
@@ -371,6 +462,7 @@ namespace ed {
 		glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, ddsImage->header.width, ddsImage->header.height, ddsImage->header.depth, 0, GL_RGBA, GL_UNSIGNED_BYTE, ddsImage->pixels);
 		glGenerateMipmap(GL_TEXTURE_3D);
 		glBindTexture(GL_TEXTURE_3D, 0);
+		BumpTextureGeneration(item->Texture);
 
 		item->TextureSize = glm::ivec2(ddsImage->header.width, ddsImage->header.height);
 		item->Depth = ddsImage->header.depth;
@@ -430,6 +522,7 @@ namespace ed {
 
 		// clean up
 		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		BumpTextureGeneration(item->Texture);
 		item->TextureSize = glm::ivec2(width, height);
 
 		return true;
@@ -464,6 +557,7 @@ namespace ed {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		BumpTextureGeneration(item->Texture);
 
 		item->Sound->Start();
 		item->SoundMuted = false;
@@ -521,6 +615,7 @@ namespace ed {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		BumpTextureGeneration(item->Texture);
 
 		memset(iObj->DataPath, 0, sizeof(char) * SHADERED_MAX_PATH);
 		iObj->Size = size;
@@ -552,6 +647,7 @@ namespace ed {
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage3D(GL_TEXTURE_3D, 0, iObj->Format, size.x, size.y, size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_3D, 0);
+		BumpTextureGeneration(item->Texture);
 
 		return true;
 	}
@@ -604,6 +700,7 @@ namespace ed {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_kbTexture);
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		BumpTextureGeneration(item->Texture);
 
 		item->TextureSize = glm::ivec2(width, height);
 
@@ -805,7 +902,7 @@ namespace ed {
 				bool isDDS = (std::filesystem::path(path).extension().u8string() == ".dds");
 				if (!isDDS) {
 					int nrChannels = 0;
-					stbi_load(path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+					data = stbi_load(path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
 				} else {
 					ddsImage = dds_load_from_file(path.c_str());
 
@@ -818,6 +915,8 @@ namespace ed {
 				if (data == nullptr || (isDDS && ddsImage == nullptr) || (item->Type == ObjectType::Texture3D && depth == 0))
 					return false;
 
+				m_cancelTextureLoad(item);
+
 				if (m_items[i]->Name != newPath) {
 					m_items[i]->Name = newPath;
 					m_parser->ModifyProject();
@@ -838,14 +937,7 @@ namespace ed {
 
 					// flipped texture
 					unsigned char* flippedData = (unsigned char*)malloc(width * height * 4);
-					for (int x = 0; x < width; x++) {
-						for (int y = 0; y < height; y++) {
-							flippedData[(y * width + x) * 4 + 0] = data[((height - y - 1) * width + x) * 4 + 0];
-							flippedData[(y * width + x) * 4 + 1] = data[((height - y - 1) * width + x) * 4 + 1];
-							flippedData[(y * width + x) * 4 + 2] = data[((height - y - 1) * width + x) * 4 + 2];
-							flippedData[(y * width + x) * 4 + 3] = data[((height - y - 1) * width + x) * 4 + 3];
-						}
-					}
+					flipTextureRows(data, flippedData, width, height);
 					glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
 					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, flippedData);
 					glGenerateMipmap(GL_TEXTURE_2D);
@@ -854,6 +946,9 @@ namespace ed {
 					free(flippedData);
 				}
 
+				BumpTextureGeneration(item->Texture);
+				BumpTextureGeneration(item->FlippedTexture);
+
 				item->TextureSize = glm::ivec2(width, height);
 				item->Depth = depth;
 
@@ -978,12 +1073,14 @@ namespace ed {
 				glBindTexture(GL_TEXTURE_2D, it->Texture);
 				glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_FLOAT, m_audioTempTexData);
 				glBindTexture(GL_TEXTURE_2D, 0);
+				BumpTextureGeneration(it->Texture);
 			}
 			// update kb texture
 			else if (it->Type == ObjectType::KeyboardTexture) {
 				glBindTexture(GL_TEXTURE_2D, it->Texture);
 				glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, 256, 3, 0, GL_RED, GL_UNSIGNED_BYTE, m_kbTexture);
 				glBindTexture(GL_TEXTURE_2D, 0);
+				BumpTextureGeneration(it->Texture);
 				memset(&m_kbTexture[256], 0, sizeof(unsigned char) * 256);
 			}
 		}
@@ -993,6 +1090,7 @@ namespace ed {
 		m_parser->ModifyProject();
 
 		ed::ObjectManagerItem* item = Get(file);
+		m_cancelTextureLoad(item);
 
 		GLuint data = item->Texture;
 		if (item->Type == ObjectType::Buffer && item->Buffer != nullptr)
@@ -1022,6 +1120,9 @@ namespace ed {
 			pobj->Owner->Object_Remove(file.c_str(), pobj->Type, pobj->Data, pobj->ID);
 		}
 
+		m_texGenerations.erase(item->Texture);
+		m_texGenerations.erase(item->FlippedTexture);
+
 		delete item;
 		m_items.erase(m_items.begin() + index);
 	}
@@ -1142,6 +1243,8 @@ namespace ed {
 				break;
 			}
 
+		BumpTextureGeneration(imgTex);
+
 		if (tex != 0 && texSize.x != 0 && texSize.y != 0) {
 			int width = std::min<int>(img->Size.x, texSize.x);
 			int height = std::min<int>(img->Size.y, texSize.y);
@@ -1319,6 +1422,7 @@ namespace ed {
 
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		BumpTextureGeneration(item->Texture);
 
 		glBindTexture(GL_TEXTURE_2D, rtObj->DepthStencilBuffer);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
@@ -1342,6 +1446,7 @@ namespace ed {
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		BumpTextureGeneration(item->Texture);
 	}
 	void ObjectManager::ResizeImage3D(ObjectManagerItem* item, glm::ivec3 size)
 	{
@@ -1354,5 +1459,6 @@ namespace ed {
 		glBindTexture(GL_TEXTURE_3D, item->Texture);
 		glTexImage3D(GL_TEXTURE_3D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, iobj->Size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_3D, 0);
+		BumpTextureGeneration(item->Texture);
 	}
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <SHADERed/Objects/PipelineItem.h>
 #include <SHADERed/Objects/ProjectParser.h>
 #include <SHADERed/Objects/ObjectManagerItem.h>
+#include <SHADERed/Engine/ThreadPool.h>
 
 namespace ed {
 	class RenderEngine;
@@ -32,6 +33,10 @@ namespace ed {
 		void OnEvent(const SDL_Event& e);
 		void Update(float delta);
 
+		// upload textures that were decoded in the background (wait -> block until all of them are done)
+		void FinishTextureLoads(bool wait = false);
+		inline bool IsLoadingTextures() { return !m_pendingTextures.empty(); }
+
 		void Pause(bool pause);
 
 		void Remove(const std::string& file);
@@ -51,6 +56,18 @@ namespace ed {
 
 		bool ReloadTexture(ObjectManagerItem* item, const std::string& newPath);
 
+		// changes every time the contents of a texture are (re)written, 0 -> not tracked
+		inline uint32_t GetTextureGeneration(GLuint tex)
+		{
+			auto it = m_texGenerations.find(tex);
+			return it == m_texGenerations.end() ? 0 : it->second;
+		}
+		inline void BumpTextureGeneration(GLuint tex)
+		{
+			if (tex != 0)
+				m_texGenerations[tex] = ++m_lastTexGeneration;
+		}
+
 		void Clear();
 
 		inline std::vector<ObjectManagerItem*>& GetObjects() { return m_items; }
@@ -119,5 +136,24 @@ namespace ed {
 
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_binds;
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_uniformBinds;
+
+		std::unordered_map<GLuint, uint32_t> m_texGenerations;
+		uint32_t m_lastTexGeneration;
+
+		// textures are decoded & flipped on m_loadPool, item keeps a 1x1 placeholder until the upload
+		struct PendingTexture {
+			ObjectManagerItem* Item;
+			std::future<void> Task;
+
+			unsigned char* Data; // bottom row first
+			unsigned char* FlippedData; // top row first
+			void* DDS;
+			int Width, Height;
+		};
+		std::vector<PendingTexture*> m_pendingTextures;
+		eng::ThreadPool* m_loadPool;
+		bool m_uploadTexture(PendingTexture* tex);
+		void m_cancelTextureLoad(ObjectManagerItem* item);
+		void m_freePendingTexture(PendingTexture* tex);
 	};
 }
\ No newline at end of file
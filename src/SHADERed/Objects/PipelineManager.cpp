@@ -1,6 +1,7 @@
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/PipelineManager.h>
 #include <SHADERed/Objects/ProjectParser.h>
+#include <SHADERed/Objects/RenderEngine.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 #include <SHADERed/Options.h>
 
@@ -18,10 +19,11 @@ int strcmpcase(const char* s1, const char* s2)
 }
 
 namespace ed {
-	PipelineManager::PipelineManager(ProjectParser* project, PluginManager* plugins)
+	PipelineManager::PipelineManager(ProjectParser* project, PluginManager* plugins, RenderEngine* renderer)
 	{
 		m_project = project;
 		m_plugins = plugins;
+		m_renderer = renderer;
 	}
 	PipelineManager::~PipelineManager()
 	{
@@ -148,6 +150,8 @@ namespace ed {
 			m_items.push_back(pitem);
 			strcpy(pitem->Name, name);
 
+			m_renderer->OnItemAdded(pitem);
+
 			m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemAdded, (void*)name, nullptr);
 
 			return true;
@@ -169,6 +173,8 @@ namespace ed {
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::ShaderPass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_renderer->OnItemAdded(m_items.back());
+
 		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemAdded, (void*)name, nullptr);
 
 		return true;
@@ -187,6 +193,8 @@ namespace ed {
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::ComputePass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_renderer->OnItemAdded(m_items.back());
+
 		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemAdded, (void*)name, nullptr);
 
 		return true;
@@ -205,6 +213,8 @@ namespace ed {
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::AudioPass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_renderer->OnItemAdded(m_items.back());
+
 		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemAdded, (void*)name, nullptr);
 
 		return true;
@@ -217,6 +227,8 @@ namespace ed {
 
 		for (int i = 0; i < m_items.size(); i++) {
 			if (strcmp(m_items[i]->Name, name) == 0) {
+				m_renderer->OnItemRemoved(m_items[i]);
+
 				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
 					glDeleteFramebuffers(1, &data->FBO);
@@ -326,6 +338,15 @@ namespace ed {
 
 		m_project->ModifyProject();
 	}
+	void PipelineManager::Swap(std::vector<PipelineItem*>& list, int index1, int index2)
+	{
+		std::swap(list[index1], list[index2]);
+
+		m_project->ModifyProject();
+
+		if (&list == &m_items)
+			m_renderer->OnItemsSwapped(list[index1], list[index2]);
+	}
 	bool PipelineManager::Has(const char* name)
 	{
 		for (int i = 0; i < m_items.size(); i++) {
@@ -6,10 +6,11 @@
 
 namespace ed {
 	class ProjectParser;
+	class RenderEngine;
 
 	class PipelineManager {
 	public:
-		PipelineManager(ProjectParser* project, PluginManager* plugins);
+		PipelineManager(ProjectParser* project, PluginManager* plugins, RenderEngine* renderer);
 		~PipelineManager();
 
 		void Clear();
@@ -23,7 +24,10 @@ namespace ed {
 		bool Has(const char* name);
 		PipelineItem* Get(const char* name);
 		char* GetItemOwner(const char* name);
-		inline std::vector<PipelineItem*>& GetList() { return m_items; }
+		inline std::vector<PipelineItem*>& GetList() { return m_items; } // use Swap() to reorder the items
+
+		// swap two items in GetList() or in some item's child list
+		void Swap(std::vector<PipelineItem*>& list, int index1, int index2);
 
 		void New(bool openTemplate = true);
 
@@ -32,6 +36,7 @@ namespace ed {
 	private:
 		PluginManager* m_plugins;
 		ProjectParser* m_project;
+		RenderEngine* m_renderer;
 		std::vector<PipelineItem*> m_items;
 	};
 }
\ No newline at end of file
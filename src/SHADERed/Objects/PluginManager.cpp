@@ -461,7 +461,7 @@ namespace ed {
 			msgs->ClearGroup(group);
 		};
 		plugin->Log = [](const char* msg, bool error, const char* file, int line) {
-			printf("%s\n", msg);
+			fprintf(ed::Logger::Get().PipeToStderr ? stderr : stdout, "%s\n", msg);
 			//ed::Logger::Get().Log(msg, error, file, line);
 		};
 		plugin->GetObjectCount = [](void* objects) -> int {
@@ -610,6 +610,7 @@ namespace ed {
 			if (lwr == "autofetch") return seti.Debug.AutoFetch;
 			if (lwr == "primitiveoutline") return seti.Debug.PrimitiveOutline;
 			if (lwr == "pixeloutline") return seti.Debug.PixelOutline;
+			if (lwr == "analysisquads") return seti.Debug.AnalysisQuads;
 
 			/* PREVIEW */
 			if (lwr == "pausedonstartup") return seti.Preview.PausedOnStartup;
@@ -622,6 +623,7 @@ namespace ed {
 			if (lwr == "statusbar") return seti.Preview.StatusBar;
 			if (lwr == "applyfpslimittoapp") return seti.Preview.ApplyFPSLimitToApp;
 			if (lwr == "lostfocuslimitfps") return seti.Preview.LostFocusLimitFPS;
+			if (lwr == "audioshadercpu") return seti.Preview.AudioShaderCPU;
 
 			/* PROJECT */
 			if (lwr == "fpcamera") return seti.Project.FPCamera;
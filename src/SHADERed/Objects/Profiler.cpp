@@ -0,0 +1,263 @@
+#include <SHADERed/Objects/Profiler.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace ed {
+	static thread_local uint32_t threadIndex = 0;
+	static thread_local int scopeDepth = 0;
+
+	static std::string escapeJSON(const std::string& str)
+	{
+		std::string ret;
+		ret.reserve(str.size());
+		for (char c : str) {
+			if (c == '"' || c == '\\') {
+				ret += '\\';
+				ret += c;
+			} else if ((unsigned char)c < 0x20)
+				ret += ' ';
+			else
+				ret += c;
+		}
+		return ret;
+	}
+
+	Profiler::Profiler()
+	{
+		m_enabled = false;
+		m_recording = false;
+		m_gpuDepth = 0;
+		m_frameIndex = 0;
+		m_threadCount = 0;
+		m_epoch = std::chrono::steady_clock::now();
+		m_current.GPUOffset = 0;
+	}
+	void Profiler::BeginFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		m_current = Capture();
+		m_current.Data.Index = m_frameIndex++;
+		m_current.Data.Start = m_now();
+		m_current.Data.Duration = 0;
+		m_current.GPUOffset = 0;
+		m_gpuDepth = 0;
+
+		m_recording = m_enabled;
+		if (!m_recording)
+			return;
+
+		// map GPU timestamps to our clock
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		m_current.GPUOffset = (int64_t)m_now() - (int64_t)gpuNow;
+	}
+	void Profiler::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		if (m_recording) {
+			m_current.Data.Duration = m_now() - m_current.Data.Start;
+			m_pending.push_back(std::move(m_current));
+			m_current = Capture();
+			m_recording = false;
+		}
+
+		// move every frame whose GPU results are ready to the history - never wait for the GPU
+		while (!m_pending.empty()) {
+			bool force = m_pending.size() > PROFILER_MAX_FRAME_LATENCY;
+			if (!m_resolve(m_pending.front(), force))
+				break;
+
+			m_history.push_back(std::move(m_pending.front().Data));
+			m_pending.pop_front();
+
+			if (m_history.size() > PROFILER_HISTORY_SIZE)
+				m_history.pop_front();
+		}
+	}
+	int Profiler::BeginScope(const char* name, bool gpu, uint64_t& frame)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		if (!m_recording)
+			return -1;
+
+		frame = m_current.Data.Index;
+
+		Event evt;
+		evt.Name = name;
+		evt.Start = m_now();
+		evt.Duration = 0;
+		evt.Thread = m_threadIndex();
+		evt.Depth = scopeDepth++;
+
+		std::vector<Event>& events = m_current.Data.Events;
+		int id = events.size();
+		events.push_back(evt);
+		m_current.ScopeQuery.push_back(-1);
+
+		if (gpu) {
+			PendingQuery query;
+			query.Event = events.size();
+			query.Begin = m_getQuery();
+			query.End = 0;
+			glQueryCounter(query.Begin, GL_TIMESTAMP);
+
+			evt.Thread = 0;
+			evt.Depth = m_gpuDepth++;
+			events.push_back(evt);
+			m_current.ScopeQuery.push_back(-1);
+
+			m_current.ScopeQuery[id] = m_current.Queries.size();
+			m_current.Queries.push_back(query);
+		}
+
+		return id;
+	}
+	void Profiler::EndScope(int id, uint64_t frame)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		scopeDepth--;
+
+		// scope started in some other frame
+		if (!m_recording || frame != m_current.Data.Index || id >= m_current.Data.Events.size())
+			return;
+
+		Event& evt = m_current.Data.Events[id];
+		evt.Duration = m_now() - evt.Start;
+
+		int query = m_current.ScopeQuery[id];
+		if (query != -1) {
+			PendingQuery& pending = m_current.Queries[query];
+			pending.End = m_getQuery();
+			glQueryCounter(pending.End, GL_TIMESTAMP);
+			m_gpuDepth--;
+		}
+	}
+	void Profiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_history.clear();
+	}
+	bool Profiler::Export(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		std::ofstream file(path);
+		if (!file.is_open())
+			return false;
+
+		char buffer[64];
+		auto toMicroseconds = [&](uint64_t ns) -> const char* {
+			snprintf(buffer, sizeof(buffer), "%.3f", ns / 1000.0);
+			return buffer;
+		};
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		// thread names
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+		for (uint32_t i = 1; i <= std::max<uint32_t>(m_threadCount, 1); i++)
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << (i == 1 ? std::string("Main thread") : ("Worker " + std::to_string(i - 1))) << "\"}}";
+
+		for (const auto& frame : m_history) {
+			file << ",\n{\"name\":\"Frame " << frame.Index << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << toMicroseconds(frame.Start);
+			file << ",\"dur\":" << toMicroseconds(frame.Duration) << "}";
+
+			for (const auto& evt : frame.Events) {
+				file << ",\n{\"name\":\"" << escapeJSON(evt.Name) << "\",\"cat\":\"" << (evt.Thread == 0 ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << evt.Thread;
+				file << ",\"ts\":" << toMicroseconds(evt.Start);
+				file << ",\"dur\":" << toMicroseconds(evt.Duration) << "}";
+			}
+		}
+
+		file << "\n]}\n";
+
+		return file.good();
+	}
+
+	uint64_t Profiler::m_now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+	}
+	uint32_t Profiler::m_threadIndex()
+	{
+		// m_lock is already held
+		if (threadIndex == 0)
+			threadIndex = ++m_threadCount;
+		return threadIndex;
+	}
+	unsigned int Profiler::m_getQuery()
+	{
+		GLuint query = 0;
+		if (!m_freeQueries.empty()) {
+			query = m_freeQueries.back();
+			m_freeQueries.pop_back();
+		} else
+			glGenQueries(1, &query);
+		return query;
+	}
+	bool Profiler::m_resolve(Capture& capture, bool force)
+	{
+		bool available = true;
+		for (const auto& query : capture.Queries) {
+			if (query.End == 0)
+				continue;
+
+			GLint done = 0;
+			glGetQueryObjectiv(query.End, GL_QUERY_RESULT_AVAILABLE, &done);
+			if (!done) {
+				available = false;
+				break;
+			}
+		}
+
+		if (!available && !force)
+			return false;
+
+		std::vector<Event>& events = capture.Data.Events;
+		for (const auto& query : capture.Queries) {
+			Event& evt = events[query.Event];
+
+			if (available && query.End != 0) {
+				GLuint64 begin = 0, end = 0;
+				glGetQueryObjectui64v(query.Begin, GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(query.End, GL_QUERY_RESULT, &end);
+
+				evt.Start = (int64_t)begin + capture.GPUOffset;
+				evt.Duration = end > begin ? end - begin : 0;
+
+				m_freeQueries.push_back(query.Begin);
+				m_freeQueries.push_back(query.End);
+			} else {
+				// the GPU took too long (or the scope was never closed) - drop this event instead of stalling.
+				// the queries might still be in flight so they can't be reused
+				evt.Name.clear();
+				glDeleteQueries(1, &query.Begin);
+				if (query.End != 0)
+					glDeleteQueries(1, &query.End);
+			}
+		}
+
+		if (!available)
+			events.erase(std::remove_if(events.begin(), events.end(), [](const Event& evt) { return evt.Thread == 0 && evt.Name.empty(); }), events.end());
+
+		capture.Queries.clear();
+
+		return true;
+	}
+}
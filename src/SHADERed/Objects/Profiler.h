@@ -0,0 +1,105 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define PROFILER_HISTORY_SIZE 300	 // resolved frames kept for the UI & export
+#define PROFILER_MAX_FRAME_LATENCY 6 // frames that can wait on GPU results - older ones lose their GPU timings instead of stalling
+
+namespace ed {
+	// CPU & GPU timings of named scopes, grouped by frames. GPU scopes use GL_TIMESTAMP queries that are only
+	// read once they are available, so the results of a frame show up a few frames later
+	class Profiler {
+	public:
+		struct Event {
+			std::string Name;
+			uint64_t Start;	   // nanoseconds since the profiler was created
+			uint64_t Duration; // nanoseconds
+			uint32_t Thread;   // 0 -> GPU, 1 -> the first thread that used the profiler (main thread), ...
+			int Depth;
+		};
+		struct Frame {
+			uint64_t Index;
+			uint64_t Start;
+			uint64_t Duration;
+			std::vector<Event> Events;
+		};
+
+		Profiler();
+
+		static inline Profiler& Instance()
+		{
+			static Profiler ret;
+			return ret;
+		}
+
+		inline void SetEnabled(bool enabled) { m_enabled = enabled; }
+		inline bool IsEnabled() { return m_enabled; }
+
+		// must be called on the GL thread
+		void BeginFrame();
+		void EndFrame();
+
+		// gpu == true also measures the GPU time of the commands issued in this scope (GL thread only)
+		int BeginScope(const char* name, bool gpu, uint64_t& frame);
+		void EndScope(int id, uint64_t frame);
+
+		inline const std::deque<Frame>& GetHistory() { return m_history; } // oldest first
+		void Clear();
+
+		// Chrome trace event format - can be opened in chrome://tracing or ui.perfetto.dev
+		bool Export(const std::string& path);
+
+	private:
+		struct PendingQuery {
+			int Event; // GPU event that will receive the result
+			unsigned int Begin, End; // End == 0 -> the scope was never closed
+		};
+		struct Capture {
+			Frame Data;
+			std::vector<PendingQuery> Queries;
+			std::vector<int> ScopeQuery; // CPU event -> index in Queries, -1 if it's a CPU only scope
+			int64_t GPUOffset;			 // CPU time - GPU time, both in nanoseconds
+		};
+
+		uint64_t m_now();
+		uint32_t m_threadIndex();
+		unsigned int m_getQuery();
+		bool m_resolve(Capture& capture, bool force);
+
+		bool m_enabled;
+		bool m_recording;
+		int m_gpuDepth;
+		uint64_t m_frameIndex;
+		std::chrono::steady_clock::time_point m_epoch;
+
+		Capture m_current;
+		std::deque<Capture> m_pending;
+		std::deque<Frame> m_history;
+		std::vector<unsigned int> m_freeQueries;
+
+		uint32_t m_threadCount;
+		std::mutex m_lock; // CPU scopes can be opened on worker threads
+	};
+
+	// measures the time between its construction and destruction
+	class ProfileScope {
+	public:
+		ProfileScope(const char* name, bool gpu = false)
+		{
+			m_id = Profiler::Instance().IsEnabled() ? Profiler::Instance().BeginScope(name, gpu, m_frame) : -1;
+		}
+		~ProfileScope()
+		{
+			if (m_id != -1)
+				Profiler::Instance().EndScope(m_id, m_frame);
+		}
+
+	private:
+		int m_id;
+		uint64_t m_frame;
+	};
+}
@@ -16,6 +16,8 @@
 
 #include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Engine/GeometryFactory.h>
+#include <SHADERed/Engine/ThreadPool.h>
+#include <SHADERed/Engine/Timer.h>
 #include <SHADERed/UI/CodeEditorUI.h>
 #include <SHADERed/UI/PinnedUI.h>
 #include <SHADERed/UI/PipelineUI.h>
@@ -78,12 +80,15 @@ namespace ed {
 	{
 		Logger::Get().Log("Opening a project file " + file);
 
+		eng::Timer loadTimer;
+
 		pugi::xml_document doc;
 		pugi::xml_parse_result result = doc.load_file(file.c_str());
 		if (!result) {
 			Logger::Get().Log("Failed to parse a project file", true);
 			return;
 		}
+		Logger::Get().Log("Project loading phase \"xml\" took " + std::to_string((int)(loadTimer.GetElapsedTime() * 1000)) + "ms");
 
 		// check if user has all required plugins
 		m_pluginList.clear();
@@ -214,7 +219,7 @@ namespace ed {
 		for (const auto& pname : m_pluginList)
 			m_plugins->GetPlugin(pname)->Project_EndLoad();
 
-		Logger::Get().Log("Finished with parsing a project file");
+		Logger::Get().Log("Finished with parsing a project file in " + std::to_string((int)(loadTimer.GetElapsedTime() * 1000)) + "ms");
 	}
 	void ProjectParser::OpenTemplate()
 	{
@@ -1000,11 +1005,13 @@ namespace ed {
 
 		// load the model
 		std::string path = GetProjectPath(file);
-		bool loaded = m_models[m_models.size() - 1].second->LoadFromFile(path);
+		eng::Model* mdl = m_models[m_models.size() - 1].second;
+		bool loaded = mdl->Import(path);
 		if (!loaded) {
 			m_models.erase(m_models.begin() + (m_models.size() - 1));
 			return nullptr;
 		}
+		mdl->Upload(Settings::Instance().General.CompactModels, !Settings::Instance().General.ReleaseModelData);
 
 		return m_models[m_models.size() - 1].second;
 	}
@@ -2295,6 +2302,15 @@ namespace ed {
 	{
 		Logger::Get().Log("Parsing a V2 project file...");
 
+		eng::Timer phaseTimer;
+		auto logPhase = [&](const std::string& phase) {
+			Logger::Get().Log("Project loading phase \"" + phase + "\" took " + std::to_string((int)(phaseTimer.Restart() * 1000)) + "ms");
+		};
+
+		// decode all models up front, in parallel - LoadModel() then just returns the cached ones
+		m_preloadModels(projectNode);
+		logPhase("models");
+
 		Settings::Instance().Project.IncludePaths.clear();
 
 		std::map<pipe::ShaderPass*, std::vector<std::string>> fbos;
@@ -2753,6 +2769,8 @@ namespace ed {
 			}
 		}
 
+		logPhase("shader passes");
+
 		// camera snapshots
 		for (pugi::xml_node camNode : projectNode.child("cameras").children("camera")) {
 			std::string camName = "";
@@ -3194,6 +3212,8 @@ namespace ed {
 			}
 		}
 
+		logPhase("objects");
+
 		// bind ARRAY_BUFFERS
 		for (auto& geo : geoUBOs) {
 			BufferObject* bojb = m_objects->Get(geo.second.first)->Buffer;
@@ -3206,10 +3226,10 @@ namespace ed {
 				mdl.first->InstanceBuffer = bobj;
 
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO, bobj->ID, m_objects->ParseBufferFormat(bobj->ViewFormat));
+					gl::CreateVAO(mesh, mdl.second.second->InputLayout, bobj->ID, m_objects->ParseBufferFormat(bobj->ViewFormat));
 			} else { // recreate vao anyway
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO);
+					gl::CreateVAO(mesh, mdl.second.second->InputLayout);
 			}
 		}
 		for (auto& vb : vbUBOs) {
@@ -3242,6 +3262,8 @@ namespace ed {
 				if (!id.empty())
 					m_objects->BindUniform(m_objects->Get(id), b.first);
 
+		logPhase("bindings");
+
 		// settings
 		for (pugi::xml_node settingItem : projectNode.child("settings").children("entry")) {
 			if (!settingItem.attribute("type").empty()) {
@@ -3422,5 +3444,54 @@ namespace ed {
 				index++;
 			}
 		}
+
+		logPhase("settings");
+	}
+	void ProjectParser::m_preloadModels(const pugi::xml_node& projectNode)
+	{
+		std::vector<std::string> files;
+		for (pugi::xml_node passNode : projectNode.child("pipeline").children("pass")) {
+			for (pugi::xml_node itemNode : passNode.child("items").children()) {
+				if (strcmp(itemNode.attribute("type").as_string(), "model") != 0)
+					continue;
+
+				// same key as the one LoadModel() gets later
+				std::string file = toGenericPath(itemNode.child("filepath").text().as_string());
+				if (!file.empty() && std::count(files.begin(), files.end(), file) == 0)
+					files.push_back(file);
+			}
+		}
+
+		if (files.empty())
+			return;
+
+		// Assimp import runs on the worker threads, GL buffers are created here
+		std::vector<eng::Model*> models(files.size(), nullptr);
+		std::vector<char> loaded(files.size(), 0);
+		auto importModel = [&](size_t i, size_t worker) {
+			models[i] = new eng::Model();
+			loaded[i] = models[i]->Import(GetProjectPath(files[i]));
+		};
+
+		size_t workerCount = std::min<size_t>(files.size(), std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+		if (workerCount <= 1) {
+			for (size_t i = 0; i < files.size(); i++)
+				importModel(i, 0);
+		} else {
+			eng::ThreadPool pool(workerCount - 1);
+			pool.ParallelFor(files.size(), importModel);
+		}
+
+		int loadedCount = 0;
+		for (size_t i = 0; i < files.size(); i++) {
+			if (loaded[i]) {
+				models[i]->Upload(Settings::Instance().General.CompactModels, !Settings::Instance().General.ReleaseModelData);
+				m_models.push_back(std::make_pair(files[i], models[i]));
+				loadedCount++;
+			} else
+				delete models[i];
+		}
+
+		Logger::Get().Log("Loaded " + std::to_string(loadedCount) + "/" + std::to_string(files.size()) + " models on " + std::to_string(workerCount) + " threads");
 	}
 }
\ No newline at end of file
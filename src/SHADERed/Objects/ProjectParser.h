@@ -68,6 +68,7 @@ namespace ed {
 
 	private:
 		void m_parseV1(pugi::xml_node& projectNode); // old
+		void m_preloadModels(const pugi::xml_node& projectNode);
 		void m_parseV2(pugi::xml_node& projectNode); // current -> merge blend, rasterizer and depth states into one "render state" ||| remove input layout parsing ||| ignore shader entry property
 
 		void m_parseVariableValue(pugi::xml_node& node, ShaderVariable* var);
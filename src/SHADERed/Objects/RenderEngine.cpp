@@ -6,6 +6,7 @@
 #include <SHADERed/Objects/Names.h>
 #include <SHADERed/Objects/ObjectManager.h>
 #include <SHADERed/Objects/PipelineManager.h>
+#include <SHADERed/Objects/Profiler.h>
 #include <SHADERed/Objects/RenderEngine.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
@@ -89,6 +90,11 @@ namespace ed {
 			, m_wasMultiPick(false)
 	{
 		m_paused = false;
+		m_compilePool = nullptr;
+		m_scissor = false;
+		m_scissorPos = glm::vec2(0.0f);
+		m_overrideItem = nullptr;
+		m_overrideShader = m_overrideFBO = 0;
 
 		glGenTextures(1, &m_rtColor);
 		glGenTextures(1, &m_rtDepth);
@@ -108,16 +114,16 @@ namespace ed {
 		glDeleteTextures(1, &m_rtColorMS);
 		glDeleteTextures(1, &m_rtDepthMS);
 		glDeleteShader(m_generalDebugShader);
-		FlushCache();
-	}
-	void RenderEngine::Render(int width, int height, bool isDebug, PipelineItem* breakItem)
-	{
-		bool isMSAA = (Settings::Instance().Preview.MSAA != 1) && !isDebug;
 
-		if (isMSAA)
-			glEnable(GL_MULTISAMPLE);
+		// the pipeline is already gone at this point, so don't call FlushCache()
+		for (auto& rec : m_records)
+			m_deleteRecord(rec);
 
-		// recreate render texture if size has changed
+		if (m_compilePool != nullptr)
+			delete m_compilePool;
+	}
+	void RenderEngine::Resize(int width, int height)
+	{
 		if (m_lastSize.x != width || m_lastSize.y != height) {
 			m_lastSize = glm::vec2(width, height);
 
@@ -150,6 +156,18 @@ namespace ed {
 				}
 			}
 		}
+	}
+	void RenderEngine::Render(int width, int height, bool isDebug, PipelineItem* breakItem)
+	{
+		ProfileScope renderScope("Render", true);
+
+		bool isMSAA = (Settings::Instance().Preview.MSAA != 1) && !isDebug;
+
+		if (isMSAA)
+			glEnable(GL_MULTISAMPLE);
+
+		// recreate render texture if size has changed
+		Resize(width, height);
 
 		// cache elements
 		m_cache();
@@ -164,41 +182,9 @@ namespace ed {
 
 		m_plugins->BeginRender();
 
-		// check if we need to perform performance measurement
-		bool performPerfMeasure = Settings::Instance().General.Profiler && m_lastPerfMeasure.GetElapsedTime() > 0.4f;
-		if (performPerfMeasure) {
-			bool isAllDone = true;
-			unsigned long long totalTime = 0;
-
-			for (int i = 0; i < m_perfTimers.size(); i++) {
-				if (!m_perfTimers[i].IsDone) {
-					isAllDone = false;
-
-					int queryDone = 0;
-					glGetQueryObjectiv(m_perfTimers[i].Object, GL_QUERY_RESULT_AVAILABLE, &queryDone);
-
-					if (queryDone) {
-						glGetQueryObjectui64v(m_perfTimers[i].Object, GL_QUERY_RESULT, &m_perfTimers[i].LastTime);
-						m_perfTimers[i].IsDone = true;
-					}
-				}
-				totalTime += m_perfTimers[i].LastTime;
-			}
-			
-			m_totalPerfTime = totalTime;
-			performPerfMeasure &= isAllDone;
-
-			if (performPerfMeasure)
-				m_lastPerfMeasure.Restart();
-		}
-
-		for (int i = 0; i < m_items.size(); i++) {
-			PipelineItem* it = m_items[i];
-
-			if (performPerfMeasure) {
-				glBeginQuery(GL_TIME_ELAPSED, m_perfTimers[i].Object);
-				m_perfTimers[i].IsDone = false;
-			}
+		for (int i = 0; i < m_records.size(); i++) {
+			PipelineItem* it = m_records[i].Item;
+			ProfileScope passScope(it->Name, true);
 
 			if (it->Type == PipelineItem::ItemType::ShaderPass) {
 				pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
@@ -206,24 +192,37 @@ namespace ed {
 				if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0)
 					continue;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_records[i].Item);
+				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_records[i].Item);
 
 				// create/update fbo if necessary
 				m_updatePassFBO(data);
 
-				if (m_shaders[i] == 0)
+				if (m_records[i].Shader == 0)
 					continue;
 
+				bool isOverride = it == m_overrideItem && m_overrideShader != 0 && !isDebug;
+				GLuint shaderProgram = isOverride ? m_overrideShader : m_records[i].Shader;
+
 				if (data->TSUsed && m_tessellationSupported) 
 					glPatchParameteri(GL_PATCH_VERTICES, data->TSPatchVertices);
 
 				// bind fbo and buffers
-				glBindFramebuffer(GL_FRAMEBUFFER, isMSAA ? m_fboMS[data] : data->FBO);
-				glDrawBuffers(data->RTCount, fboBuffers);
+				if (isOverride) {
+					glBindFramebuffer(GL_FRAMEBUFFER, m_overrideFBO);
+					glDrawBuffers(1, fboBuffers);
+				} else {
+					glBindFramebuffer(GL_FRAMEBUFFER, isMSAA ? m_fboMS[data] : data->FBO);
+					glDrawBuffers(data->RTCount, fboBuffers);
+				}
+				m_enableScissor(data, width, height); // clears & MSAA resolve are limited by it too
 
 				// clear depth texture
-				if (data->DepthTexture != previousDepth) {
+				if (isOverride) {
+					glStencilMask(0xFFFFFFFF);
+					glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+					glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f)));
+				} else if (data->DepthTexture != previousDepth) {
 					if ((data->DepthTexture == m_rtDepth && !clearedWindow) || data->DepthTexture != m_rtDepth) {
 						glStencilMask(0xFFFFFFFF);
 						glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
@@ -247,6 +246,7 @@ namespace ed {
 						ed::RenderTextureObject* rtObject = m_objects->GetByTextureID(rt)->RT;
 
 						rtSize = rtObject->CalculateSize(width, height);
+						m_objects->BumpTextureGeneration(rt); // debugger's copy of this texture is now outdated
 
 						// clear and bind rt (only if not used in last shader pass)
 						bool usedPreviously = false;
@@ -255,10 +255,10 @@ namespace ed {
 								usedPreviously = true;
 								break;
 							}
-						if (!usedPreviously && rtObject->Clear)
+						if (!usedPreviously && rtObject->Clear && !isOverride)
 							glClearBufferfv(GL_COLOR, i, isDebug ? glm::value_ptr(glm::vec4(0.0f)) : glm::value_ptr(rtObject->ClearColor));
 
-					} else if (!clearedWindow) {
+					} else if (!clearedWindow && !isOverride) {
 						glClearBufferfv(GL_COLOR, i, isDebug ? glm::value_ptr(glm::vec4(0.0f)) : glm::value_ptr(Settings::Instance().Project.ClearColor));
 
 						clearedWindow = true;
@@ -273,10 +273,13 @@ namespace ed {
 
 				// bind shaders
 				if (isDebug) {
-					data->Variables.UpdateUniformInfo(m_debugShaders[i]);
-					glUseProgram(m_debugShaders[i]);
-				} else
-					glUseProgram(m_shaders[i]);
+					data->Variables.UpdateUniformInfo(m_records[i].DebugShader, false);
+					glUseProgram(m_records[i].DebugShader);
+				} else {
+					if (isOverride)
+						data->Variables.UpdateUniformInfo(shaderProgram, false);
+					glUseProgram(shaderProgram);
+				}
 
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
@@ -295,7 +298,7 @@ namespace ed {
 
 					
 					if (ShaderCompiler::GetShaderLanguageFromExtension(data->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-						data->Variables.UpdateTexture(m_shaders[i], j);
+						data->Variables.UpdateTexture(shaderProgram, j);
 				}
 
 				for (int j = 0; j < ubos.size(); j++)
@@ -326,7 +329,7 @@ namespace ed {
 							float g = ((debugID & 0x0000FF00) >> 8) / 255.0f;
 							float b = ((debugID & 0x00FF0000) >> 16) / 255.0f;
 							float a = 0.0f; // Maybe pack additional data here?
-							glUniform4f(glGetUniformLocation(m_debugShaders[i], "_sed_dbg_pixel_color"), r, g, b, a);
+							glUniform4f(glGetUniformLocation(m_records[i].DebugShader, "_sed_dbg_pixel_color"), r, g, b, a);
 							debugID++;
 						}
 					}
@@ -459,10 +462,10 @@ namespace ed {
 								itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
 				}
 
-				if (isDebug)
-					data->Variables.UpdateUniformInfo(m_shaders[i]); // return old variable data
+				if (isDebug || isOverride)
+					data->Variables.UpdateUniformInfo(m_records[i].Shader, false); // return old variable data
 
-				if (isMSAA) {
+				if (isMSAA && !isOverride) {
 					glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fboMS[data]);
 					glBindFramebuffer(GL_DRAW_FRAMEBUFFER, data->FBO);
 					glDrawBuffer(GL_BACK);
@@ -472,6 +475,8 @@ namespace ed {
 						glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 					}
 				}
+
+				m_disableScissor();
 			}
 			else if (it->Type == PipelineItem::ItemType::ComputePass && !isDebug && (!m_paused || SystemVariableManager::Instance().IsSavingToFile()) && m_computeSupported) {
 				pipe::ComputePass* data = (pipe::ComputePass*)it->Data;
@@ -479,14 +484,14 @@ namespace ed {
 				if (!data->Active)
 					continue;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_records[i].Item);
+				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_records[i].Item);
 
-				if (m_shaders[i] == 0)
+				if (m_records[i].Shader == 0)
 					continue;
 
 				// bind shaders
-				glUseProgram(m_shaders[i]);
+				glUseProgram(m_records[i].Shader);
 				
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
@@ -504,7 +509,7 @@ namespace ed {
 						glBindTexture(GL_TEXTURE_2D, srvs[j]);
 
 					if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL)
-						data->Variables.UpdateTexture(m_shaders[i], j);
+						data->Variables.UpdateTexture(m_records[i].Shader, j);
 				}
 
 				// bind buffers
@@ -520,9 +525,11 @@ namespace ed {
 					if (uboData->Type == ObjectType::Image) {
 						ImageObject* iobj = uboData->Image;
 						glBindImageTexture(j, ubos[j], 0, GL_FALSE, 0, GL_WRITE_ONLY | GL_READ_ONLY, iobj->Format);
+						m_objects->BumpTextureGeneration(ubos[j]);
 					} else if (uboData->Type == ObjectType::Image3D) {
 						Image3DObject* iobj = uboData->Image3D;
 						glBindImageTexture(j, ubos[j], 0, GL_TRUE, 0, GL_WRITE_ONLY | GL_READ_ONLY, iobj->Format);
+						m_objects->BumpTextureGeneration(ubos[j]);
 					} else if (uboData->Type == ObjectType::PluginObject) {
 						PluginObject* pobj = uboData->Plugin;
 						pobj->Owner->Object_Bind(pobj->Type, pobj->Data, pobj->ID);
@@ -543,8 +550,8 @@ namespace ed {
 			else if (it->Type == PipelineItem::ItemType::AudioPass && !isDebug) {
 				pipe::AudioPass* data = (pipe::AudioPass*)it->Data;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_records[i].Item);
+				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_records[i].Item);
 
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
@@ -562,7 +569,7 @@ namespace ed {
 						glBindTexture(GL_TEXTURE_2D, srvs[j]);
 
 					if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-						data->Variables.UpdateTexture(m_shaders[i], j);
+						data->Variables.UpdateTexture(m_records[i].Shader, j);
 				}
 
 				// bind buffers
@@ -577,17 +584,21 @@ namespace ed {
 			else if (it->Type == PipelineItem::ItemType::PluginItem) {
 				pipe::PluginItemData* pldata = reinterpret_cast<pipe::PluginItemData*>(it->Data);
 
+				// we can't know what the plugin writes to
+				for (ObjectManagerItem* obj : m_objects->GetObjects())
+					if (obj->Type == ObjectType::RenderTexture || obj->Type == ObjectType::Image || obj->Type == ObjectType::Image3D)
+						m_objects->BumpTextureGeneration(obj->Texture);
+
 				if (!isDebug)
 					pldata->Owner->PipelineItem_Execute(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size());
 				else if (pldata->Owner->PipelineItem_IsDebuggable(pldata->Type, pldata->PluginData))
 					pldata->Owner->PipelineItem_DebugExecute(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size(), &debugID);
 			}
 
-			if (performPerfMeasure)
-				glEndQuery(GL_TIME_ELAPSED);
-
 			if (it == breakItem && breakItem != nullptr)
 				break;
+			if (it == m_overrideItem && m_overrideShader != 0 && !isDebug)
+				break;
 		}
 
 		m_plugins->EndRender();
@@ -617,16 +628,14 @@ namespace ed {
 		if (vertexData->Type == PipelineItem::ItemType::ShaderPass) {
 			pipe::ShaderPass* vertexPass = (pipe::ShaderPass*)vertexData->Data;
 
-			int vertexPassID = 0;
-			for (int i = 0; i < m_items.size(); i++)
-				if (m_items[i] == vertexData)
-					vertexPassID = i;
+			auto vertexPassRecord = m_recordIndex.find(vertexData);
+			int vertexPassID = vertexPassRecord == m_recordIndex.end() ? 0 : vertexPassRecord->second;
 
 			// _sed_dbg_pixel_color
-			GLuint sedVarLoc = glGetUniformLocation(m_debugShaders[vertexPassID], "_sed_dbg_pixel_color");
+			GLuint sedVarLoc = glGetUniformLocation(m_records[vertexPassID].DebugShader, "_sed_dbg_pixel_color");
 
 			// update info
-			vertexPass->Variables.UpdateUniformInfo(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.UpdateUniformInfo(m_records[vertexPassID].DebugShader, false);
 
 			// get resources
 			const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
@@ -638,6 +647,7 @@ namespace ed {
 			// bind fbo and buffers
 			glBindFramebuffer(GL_FRAMEBUFFER, vertexPass->FBO);
 			glDrawBuffers(vertexPass->RTCount, fboBuffers);
+			m_enableScissor(vertexPass, m_lastSize.x, m_lastSize.y);
 
 			glStencilMask(0xFFFFFFFF);
 			glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
@@ -665,7 +675,7 @@ namespace ed {
 			glViewport(0, 0, rtSize.x, rtSize.y);
 
 			// bind shaders
-			glUseProgram(m_debugShaders[vertexPassID]);
+			glUseProgram(m_records[vertexPassID].DebugShader);
 
 			// bind shader resource views
 			for (int j = 0; j < srvs.size(); j++) {
@@ -683,7 +693,7 @@ namespace ed {
 					glBindTexture(GL_TEXTURE_2D, srvs[j]);
 
 				if (ShaderCompiler::GetShaderLanguageFromExtension(vertexPass->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-					vertexPass->Variables.UpdateTexture(m_debugShaders[vertexPassID], j);
+					vertexPass->Variables.UpdateTexture(m_records[vertexPassID].DebugShader, j);
 			}
 			for (int j = 0; j < ubos.size(); j++)
 				glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
@@ -694,7 +704,6 @@ namespace ed {
 			// data
 			int x = r.x * rtSize.x;
 			int y = r.y * rtSize.y;
-			uint8_t* mainPixelData = new uint8_t[(int)(rtSize.x * rtSize.y) * 4];
 
 			// render pipeline items
 			DefaultState::Bind();
@@ -833,12 +842,17 @@ namespace ed {
 							itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
 			}
 
+			m_disableScissor();
+
 			// window pixel color
-			int vertexGroup = 0x00ffffff & getPixelID(vertexPass->RenderTextures[0], mainPixelData, x, y, rtSize.x);
+			m_pickReadback.Begin(1);
+			m_pickReadback.Read(vertexPass->RenderTextures[0], x, y);
+			m_pickReadback.End();
+			m_pickReadback.Wait(); // the next pick depends on this result
+			int vertexGroup = 0x00ffffff & m_pickReadback.GetID(0);
 
 			// return old info
-			vertexPass->Variables.UpdateUniformInfo(m_shaders[vertexPassID]);
-			delete[] mainPixelData;
+			vertexPass->Variables.UpdateUniformInfo(m_records[vertexPassID].Shader, false);
 
 			return vertexGroup;
 		}
@@ -872,16 +886,14 @@ namespace ed {
 		if (vertexData->Type == PipelineItem::ItemType::ShaderPass) {
 			pipe::ShaderPass* vertexPass = (pipe::ShaderPass*)vertexData->Data;
 
-			int vertexPassID = 0;
-			for (int i = 0; i < m_items.size(); i++)
-				if (m_items[i] == vertexData)
-					vertexPassID = i;
+			auto vertexPassRecord = m_recordIndex.find(vertexData);
+			int vertexPassID = vertexPassRecord == m_recordIndex.end() ? 0 : vertexPassRecord->second;
 
 			// _sed_dbg_pixel_color
-			GLuint sedVarLoc = glGetUniformLocation(m_debugShaders[vertexPassID], "_sed_dbg_pixel_color");
+			GLuint sedVarLoc = glGetUniformLocation(m_records[vertexPassID].DebugShader, "_sed_dbg_pixel_color");
 
 			// update info
-			vertexPass->Variables.UpdateUniformInfo(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.UpdateUniformInfo(m_records[vertexPassID].DebugShader, false);
 
 			// get resources
 			const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
@@ -893,6 +905,7 @@ namespace ed {
 			// bind fbo and buffers
 			glBindFramebuffer(GL_FRAMEBUFFER, vertexPass->FBO);
 			glDrawBuffers(vertexPass->RTCount, fboBuffers);
+			m_enableScissor(vertexPass, m_lastSize.x, m_lastSize.y);
 
 			glStencilMask(0xFFFFFFFF);
 			glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
@@ -920,7 +933,7 @@ namespace ed {
 			glViewport(0, 0, rtSize.x, rtSize.y);
 
 			// bind shaders
-			glUseProgram(m_debugShaders[vertexPassID]);
+			glUseProgram(m_records[vertexPassID].DebugShader);
 
 			// bind shader resource views
 			for (int j = 0; j < srvs.size(); j++) {
@@ -938,7 +951,7 @@ namespace ed {
 					glBindTexture(GL_TEXTURE_2D, srvs[j]);
 
 				if (ShaderCompiler::GetShaderLanguageFromExtension(vertexPass->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-					vertexPass->Variables.UpdateTexture(m_debugShaders[vertexPassID], j);
+					vertexPass->Variables.UpdateTexture(m_records[vertexPassID].DebugShader, j);
 			}
 			for (int j = 0; j < ubos.size(); j++)
 				glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
@@ -949,7 +962,6 @@ namespace ed {
 			// data
 			int x = r.x * rtSize.x;
 			int y = r.y * rtSize.y;
-			uint8_t* mainPixelData = new uint8_t[(int)(rtSize.x * rtSize.y) * 4];
 
 			// render pipeline items
 			DefaultState::Bind();
@@ -1064,12 +1076,17 @@ namespace ed {
 							itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
 			}
 
+			m_disableScissor();
+
 			// window pixel color
-			int vertexGroup = 0x00ffffff & getPixelID(vertexPass->RenderTextures[0], mainPixelData, x, y, rtSize.x);
+			m_pickReadback.Begin(1);
+			m_pickReadback.Read(vertexPass->RenderTextures[0], x, y);
+			m_pickReadback.End();
+			m_pickReadback.Wait(); // the next pick depends on this result
+			int vertexGroup = 0x00ffffff & m_pickReadback.GetID(0);
 
 			// return old info
-			vertexPass->Variables.UpdateUniformInfo(m_shaders[vertexPassID]);
-			delete[] mainPixelData;
+			vertexPass->Variables.UpdateUniformInfo(m_records[vertexPassID].Shader, false);
 
 			return vertexGroup;
 		}
@@ -1108,6 +1125,41 @@ namespace ed {
 	}
 	void RenderEngine::Recompile(const char* name)
 	{
+		std::vector<PipelineItem*> items;
+		for (const auto& rec : m_records)
+			if (strcmp(rec.Item->Name, name) == 0)
+				items.push_back(rec.Item);
+
+		if (items.empty()) {
+			Render();
+			return;
+		}
+
+		Recompile(items);
+	}
+	void RenderEngine::Recompile(const std::vector<PipelineItem*>& items)
+	{
+		ProfileScope recompileScope("Recompile");
+
+		std::vector<PipelineItem*> cached;
+		for (const auto& rec : m_records)
+			if (std::count(items.begin(), items.end(), rec.Item))
+				cached.push_back(rec.Item);
+
+		// run glslang & SPIRV-Cross for every stage of every pass in parallel, GL work stays on this thread
+		m_prepareFrontEnds(cached);
+
+		for (PipelineItem* item : cached)
+			m_recompile(item->Name);
+
+		m_frontEnds.clear();
+
+		Render();
+	}
+	void RenderEngine::m_recompile(const char* name)
+	{
+		ProfileScope compileScope("Compile item");
+
 		Logger::Get().Log("Recompiling " + std::string(name));
 
 		m_msgs->BuildOccured = true;
@@ -1116,8 +1168,8 @@ namespace ed {
 		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemCompiled, (void*)name, nullptr);
 
 		GLchar shaderMessage[1024] = { 0 };
-		for (int i = 0; i < m_items.size(); i++) {
-			PipelineItem* item = m_items[i];
+		for (int i = 0; i < m_records.size(); i++) {
+			PipelineItem* item = m_records[i].Item;
 			if (strcmp(item->Name, name) == 0) {
 				if (item->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
@@ -1127,67 +1179,23 @@ namespace ed {
 
 					m_msgs->ClearGroup(name);
 
-					glDeleteShader(m_shaderSources[i].VS);
-					glDeleteShader(m_shaderSources[i].PS);
-					glDeleteShader(m_shaderSources[i].GS);
-					glDeleteShader(m_shaderSources[i].TCS);
-					glDeleteShader(m_shaderSources[i].TES);
+					glDeleteShader(m_records[i].Sources.VS);
+					glDeleteShader(m_records[i].Sources.PS);
+					glDeleteShader(m_records[i].Sources.GS);
+					glDeleteShader(m_records[i].Sources.TCS);
+					glDeleteShader(m_records[i].Sources.TES);
 
-					std::string psContent = "", vsContent = "",
-								vsEntry = shader->VSEntry,
-								psEntry = shader->PSEntry;
-					int lineBias = 0;
-					ShaderLanguage psLang = ShaderCompiler::GetShaderLanguageFromExtension(shader->PSPath);
-					ShaderLanguage vsLang = ShaderCompiler::GetShaderLanguageFromExtension(shader->VSPath);
-					ShaderLanguage gsLang = ShaderCompiler::GetShaderLanguageFromExtension(shader->GSPath);
-					ShaderLanguage tcsLang = ShaderCompiler::GetShaderLanguageFromExtension(shader->TCSPath);
-					ShaderLanguage tesLang = ShaderCompiler::GetShaderLanguageFromExtension(shader->TESPath);
+					std::string psContent = "", vsContent = "";
 
 					// pixel shader
-					bool psCompiled = false;
-
-					if (psLang == ShaderLanguage::Plugin)
-						psCompiled = m_pluginCompileToSpirv(item, shader->PSSPV, shader->PSPath, psEntry, plugin::ShaderStage::Pixel, shader->Macros.data(), shader->Macros.size());
-					else
-						psCompiled = ShaderCompiler::CompileToSPIRV(shader->PSSPV, psLang, shader->PSPath, ShaderStage::Pixel, psEntry, shader->Macros, m_msgs, m_project);
-
-					if (psLang == ShaderLanguage::GLSL) { // GLSL
-						psContent = m_project->LoadProjectFile(shader->PSPath);
-						m_includeCheck(psContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(psContent, shader);
-					} else { // HLSL / VK
-						psContent = ShaderCompiler::ConvertToGLSL(shader->PSSPV, psLang, ShaderStage::Pixel, shader->TSUsed, shader->GSUsed, m_msgs);
-						psEntry = "main";
-
-						if (psLang == ShaderLanguage::Plugin)
-							psContent = m_pluginProcessGLSL(shader->PSPath, psContent.c_str());		
-					}
+					bool psCompiled = m_compileFrontEnd(item, ShaderStage::Pixel, psContent);
 
 					shader->Variables.UpdateTextureList(psContent);
 					GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
 					psCompiled &= gl::CheckShaderCompilationStatus(ps, shaderMessage);
 
 					// vertex shader
-					lineBias = 0;
-					bool vsCompiled = false;
-
-					if (vsLang == ShaderLanguage::Plugin)
-						vsCompiled = m_pluginCompileToSpirv(item, shader->VSSPV, shader->VSPath, vsEntry, plugin::ShaderStage::Vertex, shader->Macros.data(), shader->Macros.size());
-					else
-						vsCompiled = ShaderCompiler::CompileToSPIRV(shader->VSSPV, vsLang, shader->VSPath, ShaderStage::Vertex, vsEntry, shader->Macros, m_msgs, m_project);
-					
-					// generate glsl
-					if (vsLang == ShaderLanguage::GLSL) { // GLSL
-						vsContent = m_project->LoadProjectFile(shader->VSPath);
-						m_includeCheck(vsContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(vsContent, shader);
-					} else { // HLSL / VK
-						vsContent = ShaderCompiler::ConvertToGLSL(shader->VSSPV, vsLang, ShaderStage::Vertex, shader->TSUsed, shader->GSUsed, m_msgs);
-						vsEntry = "main";
-
-						if (vsLang == ShaderLanguage::Plugin)
-							vsContent = m_pluginProcessGLSL(shader->VSPath, vsContent.c_str());
-					}
+					bool vsCompiled = m_compileFrontEnd(item, ShaderStage::Vertex, vsContent);
 
 					GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
 					vsCompiled &= gl::CheckShaderCompilationStatus(vs, shaderMessage);
@@ -1196,27 +1204,8 @@ namespace ed {
 					bool gsCompiled = true;
 					GLuint gs = 0;
 					if (shader->GSUsed && strlen(shader->GSPath) > 0 && strlen(shader->GSEntry) > 0) {
-						std::string gsContent = "",
-									gsEntry = shader->GSEntry;
-
-						lineBias = 0;
-						
-						if (gsLang == ShaderLanguage::Plugin)
-							gsCompiled = m_pluginCompileToSpirv(item, shader->GSSPV, shader->GSPath, gsEntry, plugin::ShaderStage::Geometry, shader->Macros.data(), shader->Macros.size());
-						else
-							gsCompiled = ShaderCompiler::CompileToSPIRV(shader->GSSPV, gsLang, shader->GSPath, ShaderStage::Geometry, gsEntry, shader->Macros, m_msgs, m_project);
-						
-						if (gsLang == ShaderLanguage::GLSL) { // GLSL
-							gsContent = m_project->LoadProjectFile(shader->GSPath);
-							m_includeCheck(gsContent, std::vector<std::string>(), lineBias);
-							m_applyMacros(gsContent, shader);
-						} else { // HLSL / VK
-							gsContent = ShaderCompiler::ConvertToGLSL(shader->GSSPV, gsLang, ShaderStage::Geometry, shader->TSUsed, shader->GSUsed, m_msgs);
-							gsEntry = "main";
-
-							if (gsLang == ShaderLanguage::Plugin)
-								gsContent = m_pluginProcessGLSL(shader->GSPath, gsContent.c_str());
-						}
+						std::string gsContent = "";
+						gsCompiled = m_compileFrontEnd(item, ShaderStage::Geometry, gsContent);
 
 						gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
 						gsCompiled &= gl::CheckShaderCompilationStatus(gs, shaderMessage);
@@ -1231,27 +1220,8 @@ namespace ed {
 					if (shader->TSUsed && m_tessellationSupported) {
 						// tess control
 						if (strlen(shader->TCSPath) > 0 && strlen(shader->TCSEntry) > 0) {
-							std::string tcsContent = "",
-										tcsEntry = shader->TCSEntry;
-
-							lineBias = 0;
-
-							if (gsLang == ShaderLanguage::Plugin)
-								tsCompiled &= m_pluginCompileToSpirv(item, shader->TCSSPV, shader->TCSPath, tcsEntry, plugin::ShaderStage::TessellationControl, shader->Macros.data(), shader->Macros.size());
-							else
-								tsCompiled &= ShaderCompiler::CompileToSPIRV(shader->TCSSPV, tcsLang, shader->TCSPath, ShaderStage::TessellationControl, tcsEntry, shader->Macros, m_msgs, m_project);
-
-							if (tcsLang == ShaderLanguage::GLSL) { // GLSL
-								tcsContent = m_project->LoadProjectFile(shader->TCSPath);
-								m_includeCheck(tcsContent, std::vector<std::string>(), lineBias);
-								m_applyMacros(tcsContent, shader);
-							} else { // HLSL / VK
-								tcsContent = ShaderCompiler::ConvertToGLSL(shader->TCSSPV, gsLang, ShaderStage::TessellationControl, shader->TSUsed, shader->GSUsed, m_msgs);
-								tcsEntry = "main";
-
-								if (tcsLang == ShaderLanguage::Plugin)
-									tcsContent = m_pluginProcessGLSL(shader->TCSPath, tcsContent.c_str());
-							}
+							std::string tcsContent = "";
+							tsCompiled &= m_compileFrontEnd(item, ShaderStage::TessellationControl, tcsContent);
 
 							tcs = gl::CompileShader(GL_TESS_CONTROL_SHADER, tcsContent.c_str());
 							tsCompiled &= gl::CheckShaderCompilationStatus(tcs, shaderMessage);
@@ -1262,27 +1232,8 @@ namespace ed {
 						
 						// tess evaluation
 						if (strlen(shader->TESPath) > 0 && strlen(shader->TESEntry) > 0) {
-							std::string tesContent = "",
-										tesEntry = shader->TESEntry;
-
-							lineBias = 0;
-
-							if (gsLang == ShaderLanguage::Plugin)
-								tsCompiled &= m_pluginCompileToSpirv(item, shader->TESSPV, shader->TESPath, tesEntry, plugin::ShaderStage::TessellationEvaluation, shader->Macros.data(), shader->Macros.size());
-							else
-								tsCompiled &= ShaderCompiler::CompileToSPIRV(shader->TESSPV, tcsLang, shader->TESPath, ShaderStage::TessellationEvaluation, tesEntry, shader->Macros, m_msgs, m_project);
-
-							if (tesLang == ShaderLanguage::GLSL) { // GLSL
-								tesContent = m_project->LoadProjectFile(shader->TESPath);
-								m_includeCheck(tesContent, std::vector<std::string>(), lineBias);
-								m_applyMacros(tesContent, shader);
-							} else { // HLSL / VK
-								tesContent = ShaderCompiler::ConvertToGLSL(shader->TESSPV, gsLang, ShaderStage::TessellationEvaluation, shader->TSUsed, shader->GSUsed, m_msgs);
-								tesEntry = "main";
-
-								if (tesLang == ShaderLanguage::Plugin)
-									tesContent = m_pluginProcessGLSL(shader->TESPath, tesContent.c_str());
-							}
+							std::string tesContent = "";
+							tsCompiled &= m_compileFrontEnd(item, ShaderStage::TessellationEvaluation, tesContent);
 
 							tes = gl::CompileShader(GL_TESS_EVALUATION_SHADER, tesContent.c_str());
 							tsCompiled &= gl::CheckShaderCompilationStatus(tes, shaderMessage);
@@ -1293,8 +1244,8 @@ namespace ed {
 					}
 
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						glDeleteProgram(m_records[i].Shader);
 
 					if (!vsCompiled || !psCompiled || !gsCompiled || !tsCompiled || vsContent.empty() || psContent.empty()) {
 						Logger::Get().Log("Shaders not compiled", true);
@@ -1306,27 +1257,27 @@ namespace ed {
 							m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the shader(s)");
 						}
 
-						m_shaders[i] = 0;
+						m_records[i].Shader = 0;
 					} else {
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the shaders.");
 
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], vs);
-						if (shader->TSUsed) glAttachShader(m_shaders[i], tcs);
-						if (shader->TSUsed) glAttachShader(m_shaders[i], tes);
-						if (shader->GSUsed) glAttachShader(m_shaders[i], gs);
-						glAttachShader(m_shaders[i], ps);
-						glLinkProgram(m_shaders[i]);
+						m_records[i].Shader = glCreateProgram();
+						glAttachShader(m_records[i].Shader, vs);
+						if (shader->TSUsed) glAttachShader(m_records[i].Shader, tcs);
+						if (shader->TSUsed) glAttachShader(m_records[i].Shader, tes);
+						if (shader->GSUsed) glAttachShader(m_records[i].Shader, gs);
+						glAttachShader(m_records[i].Shader, ps);
+						glLinkProgram(m_records[i].Shader);
 					}
 
-					if (m_shaders[i] != 0)
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						shader->Variables.UpdateUniformInfo(m_records[i].Shader);
 
-					m_shaderSources[i].VS = vs;
-					m_shaderSources[i].PS = ps;
-					m_shaderSources[i].GS = gs;
-					m_shaderSources[i].TCS = tcs;
-					m_shaderSources[i].TES = tes;
+					m_records[i].Sources.VS = vs;
+					m_records[i].Sources.PS = ps;
+					m_records[i].Sources.GS = gs;
+					m_records[i].Sources.TCS = tcs;
+					m_records[i].Sources.TES = tes;
 				} 
 				else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
@@ -1336,36 +1287,17 @@ namespace ed {
 
 					m_msgs->ClearGroup(name);
 
-					std::string content = "", entry = shader->Entry;
-					int lineBias = 0;
-					ShaderLanguage lang = ShaderCompiler::GetShaderLanguageFromExtension(shader->Path);
+					std::string content = "";
 
 					// compute shader
-					bool compiled = false;
-						
-					if (lang == ShaderLanguage::Plugin)
-						compiled = m_pluginCompileToSpirv(item, shader->SPV, shader->Path, entry, plugin::ShaderStage::Compute, shader->Macros.data(), shader->Macros.size());
-					else
-						compiled = ShaderCompiler::CompileToSPIRV(shader->SPV, lang, shader->Path, ShaderStage::Compute, entry, shader->Macros, m_msgs, m_project);
-					
-					if (lang == ShaderLanguage::GLSL) { // GLSL
-						content = m_project->LoadProjectFile(shader->Path);
-						m_includeCheck(content, std::vector<std::string>(), lineBias);
-						m_applyMacros(content, shader);
-					} else { // HLSL / VK
-						content = ShaderCompiler::ConvertToGLSL(shader->SPV, lang, ShaderStage::Compute, false, false, m_msgs);
-						entry = "main";
-
-						if (lang == ShaderLanguage::Plugin)
-							content = m_pluginProcessGLSL(shader->Path, content.c_str());		
-					}
+					bool compiled = m_compileFrontEnd(item, ShaderStage::Compute, content);
 
 					// compute shader supported == version 4.3 == not needed: shader->Variables.UpdateTextureList(content);
 					GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
 					compiled &= gl::CheckShaderCompilationStatus(cs, shaderMessage);
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						glDeleteProgram(m_records[i].Shader);
 
 					if (!compiled || content.empty()) {
 						Logger::Get().Log("Compute shader was not compiled", true);
@@ -1377,19 +1309,19 @@ namespace ed {
 							m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the compute shader");
 						}
 
-						m_shaders[i] = 0;
+						m_records[i].Shader = 0;
 					} else {
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the compute shader.");
 
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
+						m_records[i].Shader = glCreateProgram();
+						glAttachShader(m_records[i].Shader, cs);
+						glLinkProgram(m_records[i].Shader);
 					}
 
 					glDeleteShader(cs);
 
-					if (m_shaders[i] != 0)
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						shader->Variables.UpdateUniformInfo(m_records[i].Shader);
 				} 
 				else if (item->Type == PipelineItem::ItemType::AudioPass) {
 					pipe::AudioPass* shader = (pipe::AudioPass*)item->Data;
@@ -1411,28 +1343,30 @@ namespace ed {
 				}
 			}
 		}
-
-		Render();
 	}
 	void RenderEngine::RecompileFile(const char* fname)
 	{
-		for (int i = 0; i < m_items.size(); i++) {
-			PipelineItem* item = m_items[i];
+		std::vector<PipelineItem*> items;
+		for (int i = 0; i < m_records.size(); i++) {
+			PipelineItem* item = m_records[i].Item;
 			if (item->Type == PipelineItem::ItemType::ShaderPass) {
 				pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
 				if (strcmp(shader->VSPath, fname) == 0 || strcmp(shader->TESPath, fname) == 0 || strcmp(shader->TCSPath, fname) == 0 || strcmp(shader->PSPath, fname) == 0 || strcmp(shader->GSPath, fname) == 0) {
-					Recompile(item->Name);
+					items.push_back(item);
 				}
 			} else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 				pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
 				if (strcmp(shader->Path, fname) == 0)
-					Recompile(item->Name);
+					items.push_back(item);
 			} else if (item->Type == PipelineItem::ItemType::AudioPass) {
 				pipe::AudioPass* shader = (pipe::AudioPass*)item->Data;
 				if (strcmp(shader->Path, fname) == 0)
-					Recompile(item->Name);
+					items.push_back(item);
 			}
 		}
+
+		if (!items.empty())
+			Recompile(items);
 	}
 	void RenderEngine::RecompileFromSource(const char* name, const std::string& vssrc, const std::string& pssrc, const std::string& gssrc, const std::string& tcssrc, const std::string& tessrc)
 	{
@@ -1442,8 +1376,8 @@ namespace ed {
 		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemCompiled, (void*)name, nullptr);
 
 		GLchar shaderMessage[1024] = { 0 };
-		for (int i = 0; i < m_items.size(); i++) {
-			PipelineItem* item = m_items[i];
+		for (int i = 0; i < m_records.size(); i++) {
+			PipelineItem* item = m_records[i].Item;
 			if (strcmp(item->Name, name) == 0) {
 				if (item->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
@@ -1482,8 +1416,8 @@ namespace ed {
 						GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
 						psCompiled &= gl::CheckShaderCompilationStatus(ps, shaderMessage);
 
-						glDeleteShader(m_shaderSources[i].PS);
-						m_shaderSources[i].PS = ps;
+						glDeleteShader(m_records[i].Sources.PS);
+						m_records[i].Sources.PS = ps;
 					}
 
 					// vertex shader
@@ -1511,8 +1445,8 @@ namespace ed {
 						GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
 						vsCompiled &= gl::CheckShaderCompilationStatus(vs, shaderMessage);
 
-						glDeleteShader(m_shaderSources[i].VS);
-						m_shaderSources[i].VS = vs;
+						glDeleteShader(m_records[i].Sources.VS);
+						m_records[i].Sources.VS = vs;
 					}
 
 					// geometry shader
@@ -1538,12 +1472,12 @@ namespace ed {
 
 
 						GLuint gs = 0;
-						glDeleteShader(m_shaderSources[i].GS);
+						glDeleteShader(m_records[i].Sources.GS);
 						if (shader->GSUsed && strlen(shader->GSPath) > 0 && strlen(shader->GSEntry) > 0) {
 							gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
 							gsCompiled &= gl::CheckShaderCompilationStatus(gs, shaderMessage);
 
-							m_shaderSources[i].GS = gs;
+							m_records[i].Sources.GS = gs;
 						}
 					}
 
@@ -1569,12 +1503,12 @@ namespace ed {
 						}
 
 						GLuint tcs = 0;
-						glDeleteShader(m_shaderSources[i].TCS);
+						glDeleteShader(m_records[i].Sources.TCS);
 						if (shader->TSUsed && strlen(shader->TCSPath) > 0 && strlen(shader->TCSEntry) > 0) {
 							tcs = gl::CompileShader(GL_TESS_CONTROL_SHADER, tcsContent.c_str());
 							tsCompiled &= gl::CheckShaderCompilationStatus(tcs, shaderMessage);
 
-							m_shaderSources[i].TCS = tcs;
+							m_records[i].Sources.TCS = tcs;
 						}
 					}
 
@@ -1600,37 +1534,37 @@ namespace ed {
 						}
 
 						GLuint tes = 0;
-						glDeleteShader(m_shaderSources[i].TES);
+						glDeleteShader(m_records[i].Sources.TES);
 						if (shader->TSUsed && strlen(shader->TESPath) > 0 && strlen(shader->TESEntry) > 0) {
 							tes = gl::CompileShader(GL_TESS_EVALUATION_SHADER, tesContent.c_str());
 							tsCompiled &= gl::CheckShaderCompilationStatus(tes, shaderMessage);
 
-							m_shaderSources[i].TES = tes;
+							m_records[i].Sources.TES = tes;
 						}
 					}
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						glDeleteProgram(m_records[i].Shader);
 
 					if (!vsCompiled || !psCompiled || !gsCompiled || !tsCompiled) {
 						if (shaderMessage[0] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(name))
 							m_msgs->Add(MessageStack::Type::Error, name, shaderMessage);
 						m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the shader(s)");
-						m_shaders[i] = 0;
+						m_records[i].Shader = 0;
 					} else {
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the shaders.");
 
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], m_shaderSources[i].VS);
-						glAttachShader(m_shaders[i], m_shaderSources[i].PS);
-						if (shader->GSUsed) glAttachShader(m_shaders[i], m_shaderSources[i].GS);
-						if (shader->TSUsed) glAttachShader(m_shaders[i], m_shaderSources[i].TCS);
-						if (shader->TSUsed) glAttachShader(m_shaders[i], m_shaderSources[i].TES);
-						glLinkProgram(m_shaders[i]);
+						m_records[i].Shader = glCreateProgram();
+						glAttachShader(m_records[i].Shader, m_records[i].Sources.VS);
+						glAttachShader(m_records[i].Shader, m_records[i].Sources.PS);
+						if (shader->GSUsed) glAttachShader(m_records[i].Shader, m_records[i].Sources.GS);
+						if (shader->TSUsed) glAttachShader(m_records[i].Shader, m_records[i].Sources.TCS);
+						if (shader->TSUsed) glAttachShader(m_records[i].Shader, m_records[i].Sources.TES);
+						glLinkProgram(m_records[i].Shader);
 					}
 
-					if (m_shaders[i] != 0)
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						shader->Variables.UpdateUniformInfo(m_records[i].Shader);
 				} 
 				else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
@@ -1669,21 +1603,21 @@ namespace ed {
 						compiled &= gl::CheckShaderCompilationStatus(cs);
 					}
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
+					if (m_records[i].Shader != 0)
+						glDeleteProgram(m_records[i].Shader);
 
-					if (m_shaders[i] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(name))
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+					if (m_records[i].Shader != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(name))
+						shader->Variables.UpdateUniformInfo(m_records[i].Shader);
 
 					if (!compiled) {
 						m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the compute shader");
-						m_shaders[i] = 0;
+						m_records[i].Shader = 0;
 					} else {
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the compute shader.");
 
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
+						m_records[i].Shader = glCreateProgram();
+						glAttachShader(m_records[i].Shader, cs);
+						glLinkProgram(m_records[i].Shader);
 					}
 
 					glDeleteShader(cs);
@@ -1826,33 +1760,10 @@ namespace ed {
 		} else if (item->Type == PipelineItem::ItemType::Model) {
 			pipe::Model* obj = (pipe::Model*)item->Data;
 
-			glm::vec3 minb = obj->Data->GetMinBound();
-			glm::vec3 maxb = obj->Data->GetMaxBound();
-
-			float triDist = std::numeric_limits<float>::infinity();
-			if (ray::IntersectBox(vec3Origin, vec3Dir, minb, maxb, triDist)) {
-				bool donetris = false;
-				for (auto& mesh : obj->Data->Meshes) {
-					for (int i = 0; i + 2 < mesh.Vertices.size(); i += 3) {
-						glm::vec3 v0 = mesh.Vertices[i + 0].Position;
-						glm::vec3 v1 = mesh.Vertices[i + 1].Position;
-						glm::vec3 v2 = mesh.Vertices[i + 2].Position;
-
-						if (ray::IntersectTriangle(vec3Origin, vec3Dir, v0, v1, v2, triDist))
-							if (triDist < myDist) {
-								myDist = triDist;
-
-								if (triDist < m_pickDist) {
-									donetris = true;
-									break;
-								}
-							}
-					}
-
-					if (donetris)
-						break;
-				}
-			}
+			// anything farther than the current pick can't win, so let the BVH skip it
+			float triDist = 0.0f;
+			if (obj->Data->Intersect(vec3Origin, vec3Dir, triDist, m_pickDist))
+				myDist = triDist;
 		} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
 			pipe::VertexBuffer* obj = (pipe::VertexBuffer*)item->Data;
 
@@ -1910,13 +1821,13 @@ namespace ed {
 	std::pair<PipelineItem*, PipelineItem*> RenderEngine::GetPipelineItemByDebugID(int id)
 	{
 		int debugID = DEBUG_ID_START;
-		for (int i = 0; i < m_items.size(); i++) {
-			PipelineItem* it = m_items[i];
+		for (int i = 0; i < m_records.size(); i++) {
+			PipelineItem* it = m_records[i].Item;
 
 			if (it->Type == PipelineItem::ItemType::ShaderPass) {
 				pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
 
-				if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0 || m_shaders[i] == 0)
+				if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0 || m_records[i].Shader == 0)
 					continue;
 
 				// render pipeline items
@@ -1945,27 +1856,45 @@ namespace ed {
 
 		return std::make_pair(nullptr, nullptr);
 	}
-	void RenderEngine::FlushCache()
+	void RenderEngine::m_enableScissor(pipe::ShaderPass* pass, int width, int height)
 	{
-		for (int i = 0; i < m_shaders.size(); i++) {
-			glDeleteShader(m_shaderSources[i].VS);
-			glDeleteShader(m_shaderSources[i].PS);
-			glDeleteShader(m_shaderSources[i].GS);
-			glDeleteShader(m_shaderSources[i].TCS);
-			glDeleteShader(m_shaderSources[i].TES);
-			glDeleteProgram(m_shaders[i]);
-			glDeleteQueries(1, &m_perfTimers[i].Object);
+		if (!m_scissor)
+			return;
+
+		glm::ivec2 rtSize(width, height);
+		if (pass->RenderTextures[0] != m_rtColor) {
+			ObjectManagerItem* rtObject = m_objects->GetByTextureID(pass->RenderTextures[0]);
+			if (rtObject != nullptr && rtObject->RT != nullptr)
+				rtSize = rtObject->RT->CalculateSize(width, height);
 		}
 
+		// same rounding as the code that reads the pixel back + a small border
+		int x = m_scissorPos.x * rtSize.x;
+		int y = m_scissorPos.y * rtSize.y;
+
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(std::max<int>(x - 2, 0), std::max<int>(y - 2, 0), 5, 5);
+	}
+	void RenderEngine::m_disableScissor()
+	{
+		if (m_scissor)
+			glDisable(GL_SCISSOR_TEST);
+	}
+	void RenderEngine::FlushCache()
+	{
+		for (auto& rec : m_records)
+			m_deleteRecord(rec);
+
 		m_fbos.clear();
 		m_fboCount.clear();
-		m_items.clear();
-		m_shaders.clear();
-		m_perfTimers.clear();
-		m_shaderSources.clear();
+		m_records.clear();
+		m_recordIndex.clear();
 		m_uboMax.clear();
 		m_fbosNeedUpdate = true;
 
+		// everything that is still in the pipeline has to be compiled again
+		m_pendingItems = m_pipeline->GetList();
+
 		// clear textures
 		glBindTexture(GL_TEXTURE_2D, m_rtColor);
 		glTexImage2D(GL_TEXTURE_2D, 0, Settings::Instance().Project.UseAlphaChannel ? GL_RGBA32F : GL_RGB32F, m_lastSize.x, m_lastSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -1977,435 +1906,294 @@ namespace ed {
 	}
 	void RenderEngine::m_cache()
 	{
-		// check for any changes
-		std::vector<ed::PipelineItem*>& items = m_pipeline->GetList();
-
-		// check if no major changes were made, if so dont cache for another 0.25s
-		if (m_items.size() == items.size()) {
-			if (m_cacheTimer.GetElapsedTime() > 0.5f)
-				m_cacheTimer.Restart();
-			else
-				return;
-		}
-
-		// check if some item was added
-		GLchar shaderMessage[1024] = { 0 };
-		for (int i = 0; i < items.size(); i++) {
-			bool found = false;
-			for (int j = 0; j < m_items.size(); j++)
-				if (items[i]->Data == m_items[j]->Data) {
-					found = true;
-					break;
-				}
-
-			if (!found) {
-				Logger::Get().Log("Caching a new shader pass " + std::string(items[i]->Name));
-
-				if (items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-					pipe::ShaderPass* data = reinterpret_cast<ed::pipe::ShaderPass*>(items[i]->Data);
-					int shaderMessagesBefore = m_msgs->GetGroupErrorAndWarningMsgCount(items[i]->Name);
-
-					m_items.insert(m_items.begin() + i, items[i]);
-					m_shaders.insert(m_shaders.begin() + i, 0);
-					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
-					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
-					
-					SPIRVQueue.push_back(items[i]);
-
-					// cache performance timer
-					m_perfTimers.insert(m_perfTimers.begin() + i, PerformanceTimer(items[i]));
-					glGenQueries(1, &m_perfTimers[i].Object);
-					m_perfTimers[i].IsCreated = true;
-
-					if (strlen(data->VSPath) == 0 || strlen(data->PSPath) == 0) {
-						Logger::Get().Log("No shader paths are set", true);
-						continue;
-					}
-
-					glDeleteShader(m_shaderSources[i].VS);
-					glDeleteShader(m_shaderSources[i].PS);
-					glDeleteShader(m_shaderSources[i].GS);
-					glDeleteShader(m_shaderSources[i].TCS);
-					glDeleteShader(m_shaderSources[i].TES);
-
-					/*
-						ITEM CACHING
-					*/
+		if (m_pendingItems.empty())
+			return;
 
-					m_fbos[data].resize(MAX_RENDER_TEXTURES);
+		ProfileScope cacheScope("Compile new items");
 
-					GLuint ps = 0, vs = 0, gs = 0, tcs = 0, tes = 0;
+		std::vector<PipelineItem*> added;
+		added.swap(m_pendingItems);
 
-					m_msgs->CurrentItem = items[i]->Name;
+		// compile the front-end of all newly added passes in parallel
+		m_prepareFrontEnds(added);
 
-					int lineBias = 0;
-					std::string psContent = "", vsContent = "",
-								vsEntry = data->VSEntry,
-								psEntry = data->PSEntry;
-					ShaderLanguage vsLang = ShaderCompiler::GetShaderLanguageFromExtension(data->VSPath);
-					ShaderLanguage psLang = ShaderCompiler::GetShaderLanguageFromExtension(data->PSPath);
+		GLchar shaderMessage[1024] = { 0 };
+		for (PipelineItem* item : added) {
+			Logger::Get().Log("Caching a new shader pass " + std::string(item->Name));
 
-					// vertex shader
-					bool vsCompiled = false;
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = reinterpret_cast<ed::pipe::ShaderPass*>(item->Data);
+				int shaderMessagesBefore = m_msgs->GetGroupErrorAndWarningMsgCount(item->Name);
 
-					if (vsLang == ShaderLanguage::Plugin)
-						vsCompiled = m_pluginCompileToSpirv(items[i], data->VSSPV, data->VSPath, vsEntry, plugin::ShaderStage::Vertex, data->Macros.data(), data->Macros.size());
-					else
-						vsCompiled = ShaderCompiler::CompileToSPIRV(data->VSSPV, vsLang, data->VSPath, ShaderStage::Vertex, vsEntry, data->Macros, m_msgs, m_project);
-					
-					// generate glsl
-					if (vsLang == ShaderLanguage::GLSL) { // GLSL
-						vsContent = m_project->LoadProjectFile(data->VSPath);
-						m_includeCheck(vsContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(vsContent, data);
-					} else if (vsCompiled) {
-						vsContent = ShaderCompiler::ConvertToGLSL(data->VSSPV, vsLang, ShaderStage::Vertex, data->TSUsed, data->GSUsed, m_msgs);
-						vsEntry = "main";
+				CachedItem& rec = m_insertRecord(item);
+				
+				SPIRVQueue.push_back(item);
 
-						if (vsLang == ShaderLanguage::Plugin)
-							vsContent = std::string(m_pluginProcessGLSL(data->VSPath, vsContent.c_str()));
-					}
+				if (strlen(data->VSPath) == 0 || strlen(data->PSPath) == 0) {
+					Logger::Get().Log("No shader paths are set", true);
+					continue;
+				}
 
-					vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
-					vsCompiled &= gl::CheckShaderCompilationStatus(vs, shaderMessage);
-					
-					// pixel shader
-					lineBias = 0;
-					bool psCompiled = false;
+				glDeleteShader(rec.Sources.VS);
+				glDeleteShader(rec.Sources.PS);
+				glDeleteShader(rec.Sources.GS);
+				glDeleteShader(rec.Sources.TCS);
+				glDeleteShader(rec.Sources.TES);
 
-					if (psLang == ShaderLanguage::Plugin)
-						psCompiled = m_pluginCompileToSpirv(items[i], data->PSSPV, data->PSPath, psEntry, plugin::ShaderStage::Pixel, data->Macros.data(), data->Macros.size());
-					else
-						psCompiled = ShaderCompiler::CompileToSPIRV(data->PSSPV, psLang, data->PSPath, ShaderStage::Pixel, psEntry, data->Macros, m_msgs, m_project);
-					
-					if (psLang == ShaderLanguage::GLSL) { // GLSL
-						psContent = m_project->LoadProjectFile(data->PSPath);
-						m_includeCheck(psContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(psContent, data);
-					} else if (psCompiled) { // HLSL / VK
-						psContent = ShaderCompiler::ConvertToGLSL(data->PSSPV, psLang, ShaderStage::Pixel, data->TSUsed, data->GSUsed, m_msgs);
-						psEntry = "main";
+				/*
+					ITEM CACHING
+				*/
 
-						if (psLang == ShaderLanguage::Plugin)
-							psContent = m_pluginProcessGLSL(data->PSPath, psContent.c_str());
-					}
+				m_fbos[data].resize(MAX_RENDER_TEXTURES);
 
-					data->Variables.UpdateTextureList(psContent);
-					ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
-					psCompiled &= gl::CheckShaderCompilationStatus(ps, shaderMessage);
+				GLuint ps = 0, vs = 0, gs = 0, tcs = 0, tes = 0;
 
-					// geometry shader
-					lineBias = 0;
-					bool gsCompiled = true;
-					if (data->GSUsed && strlen(data->GSEntry) > 0 && strlen(data->GSPath) > 0) {
-						std::string gsContent = "", gsEntry = data->GSEntry;
-						ShaderLanguage gsLang = ShaderCompiler::GetShaderLanguageFromExtension(data->GSPath);
-						
-						if (gsLang == ShaderLanguage::Plugin)
-							gsCompiled = m_pluginCompileToSpirv(items[i], data->GSSPV, data->GSPath, gsEntry, plugin::ShaderStage::Geometry, data->Macros.data(), data->Macros.size());
-						else
-							gsCompiled = ShaderCompiler::CompileToSPIRV(data->GSSPV, gsLang, data->GSPath, ShaderStage::Geometry, gsEntry, data->Macros, m_msgs, m_project);
-						
-						if (gsLang == ShaderLanguage::GLSL) { // GLSL
-							gsContent = m_project->LoadProjectFile(data->GSPath);
-							m_includeCheck(gsContent, std::vector<std::string>(), lineBias);
-							m_applyMacros(gsContent, data);
-						} else if (gsCompiled) { // HLSL
-							gsContent = ShaderCompiler::ConvertToGLSL(data->GSSPV, gsLang, ShaderStage::Geometry, data->TSUsed, data->GSUsed, m_msgs);
-							gsEntry = "main";
+				m_msgs->CurrentItem = item->Name;
 
-							if (gsLang == ShaderLanguage::Plugin)
-								gsContent = m_pluginProcessGLSL(data->GSPath, gsContent.c_str());
-						}
+				std::string psContent = "", vsContent = "";
 
-						gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
-						gsCompiled &= gl::CheckShaderCompilationStatus(gs, shaderMessage);
-					}
+				// vertex shader
+				bool vsCompiled = m_compileFrontEnd(item, ShaderStage::Vertex, vsContent);
 
-					// tessellation shader
-					lineBias = 0;
-					bool tsCompiled = ((data->TSUsed && m_tessellationSupported) || !data->TSUsed);
-					if (data->TSUsed && m_tessellationSupported) {
-						// tessellation control shader
-						if (strlen(data->TCSEntry) > 0 && strlen(data->TCSPath) > 0) {
-							std::string tcsContent = "", tcsEntry = data->TCSEntry;
-							ShaderLanguage tcsLang = ShaderCompiler::GetShaderLanguageFromExtension(data->TCSPath);
+				vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
+				vsCompiled &= gl::CheckShaderCompilationStatus(vs, shaderMessage);
+				
+				// pixel shader
+				bool psCompiled = m_compileFrontEnd(item, ShaderStage::Pixel, psContent);
 
-							if (tcsLang == ShaderLanguage::Plugin)
-								tsCompiled &= m_pluginCompileToSpirv(items[i], data->TCSSPV, data->TCSPath, tcsEntry, plugin::ShaderStage::TessellationControl, data->Macros.data(), data->Macros.size());
-							else
-								tsCompiled &= ShaderCompiler::CompileToSPIRV(data->TCSSPV, tcsLang, data->TCSPath, ShaderStage::TessellationControl, tcsEntry, data->Macros, m_msgs, m_project);
-
-							if (tcsLang == ShaderLanguage::GLSL) { // GLSL
-								tcsContent = m_project->LoadProjectFile(data->TCSPath);
-								m_includeCheck(tcsContent, std::vector<std::string>(), lineBias);
-								m_applyMacros(tcsContent, data);
-							} else if (gsCompiled) { // HLSL
-								tcsContent = ShaderCompiler::ConvertToGLSL(data->TCSSPV, tcsLang, ShaderStage::TessellationControl, data->TSUsed, data->GSUsed, m_msgs);
-								tcsEntry = "main";
-
-								if (tcsLang == ShaderLanguage::Plugin)
-									tcsContent = m_pluginProcessGLSL(data->TCSPath, tcsContent.c_str());
-							}
+				data->Variables.UpdateTextureList(psContent);
+				ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
+				psCompiled &= gl::CheckShaderCompilationStatus(ps, shaderMessage);
 
-							tcs = gl::CompileShader(GL_TESS_CONTROL_SHADER, tcsContent.c_str());
-							tsCompiled &= gl::CheckShaderCompilationStatus(tcs, shaderMessage);
-						}
+				// geometry shader
+				bool gsCompiled = true;
+				if (data->GSUsed && strlen(data->GSEntry) > 0 && strlen(data->GSPath) > 0) {
+					std::string gsContent = "";
+					gsCompiled = m_compileFrontEnd(item, ShaderStage::Geometry, gsContent);
 
-						// tessellation evauluation shader
-						if (strlen(data->TESEntry) > 0 && strlen(data->TESPath) > 0) {
-							std::string tesContent = "", tesEntry = data->TESEntry;
-							ShaderLanguage tesLang = ShaderCompiler::GetShaderLanguageFromExtension(data->TESPath);
+					gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
+					gsCompiled &= gl::CheckShaderCompilationStatus(gs, shaderMessage);
+				}
 
-							if (tesLang == ShaderLanguage::Plugin)
-								tsCompiled &= m_pluginCompileToSpirv(items[i], data->TESSPV, data->TESPath, tesEntry, plugin::ShaderStage::TessellationEvaluation, data->Macros.data(), data->Macros.size());
-							else
-								tsCompiled &= ShaderCompiler::CompileToSPIRV(data->TESSPV, tesLang, data->TESPath, ShaderStage::TessellationEvaluation, tesEntry, data->Macros, m_msgs, m_project);
-
-							if (tesLang == ShaderLanguage::GLSL) { // GLSL
-								tesContent = m_project->LoadProjectFile(data->TESPath);
-								m_includeCheck(tesContent, std::vector<std::string>(), lineBias);
-								m_applyMacros(tesContent, data);
-							} else if (gsCompiled) { // HLSL
-								tesContent = ShaderCompiler::ConvertToGLSL(data->TESSPV, tesLang, ShaderStage::TessellationEvaluation, data->TSUsed, data->GSUsed, m_msgs);
-								tesEntry = "main";
-
-								if (tesLang == ShaderLanguage::Plugin)
-									tesContent = m_pluginProcessGLSL(data->TESPath, tesContent.c_str());
-							}
+				// tessellation shader
+				bool tsCompiled = ((data->TSUsed && m_tessellationSupported) || !data->TSUsed);
+				if (data->TSUsed && m_tessellationSupported) {
+					// tessellation control shader
+					if (strlen(data->TCSEntry) > 0 && strlen(data->TCSPath) > 0) {
+						std::string tcsContent = "";
+						tsCompiled &= m_compileFrontEnd(item, ShaderStage::TessellationControl, tcsContent);
 
-							tes = gl::CompileShader(GL_TESS_EVALUATION_SHADER, tesContent.c_str());
-							tsCompiled &= gl::CheckShaderCompilationStatus(tes, shaderMessage);
-						}
+						tcs = gl::CompileShader(GL_TESS_CONTROL_SHADER, tcsContent.c_str());
+						tsCompiled &= gl::CheckShaderCompilationStatus(tcs, shaderMessage);
 					}
 
+					// tessellation evauluation shader
+					if (strlen(data->TESEntry) > 0 && strlen(data->TESPath) > 0) {
+						std::string tesContent = "";
+						tsCompiled &= m_compileFrontEnd(item, ShaderStage::TessellationEvaluation, tesContent);
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (m_debugShaders[i] != 0)
-						glDeleteProgram(m_debugShaders[i]);
-
-					if (!vsCompiled || !psCompiled || !gsCompiled || !tsCompiled) {
-						if (shaderMessage[0] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(items[i]->Name))
-							m_msgs->Add(MessageStack::Type::Error, items[i]->Name, shaderMessage);
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->ClearGroup(items[i]->Name);
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], vs);
-						glAttachShader(m_shaders[i], ps);
-						if (data->GSUsed) glAttachShader(m_shaders[i], gs);
-						if (data->TSUsed) glAttachShader(m_shaders[i], tcs);
-						if (data->TSUsed) glAttachShader(m_shaders[i], tes);
-						glLinkProgram(m_shaders[i]);
-						// XXX TODO check link status
-
-						m_debugShaders[i] = glCreateProgram();
-						glAttachShader(m_debugShaders[i], m_generalDebugShader);
-						glAttachShader(m_debugShaders[i], vs);
-						if (data->GSUsed) glAttachShader(m_debugShaders[i], gs);
-						if (data->TSUsed) glAttachShader(m_debugShaders[i], tcs);
-						if (data->TSUsed) glAttachShader(m_debugShaders[i], tes);
-						glLinkProgram(m_debugShaders[i]);
+						tes = gl::CompileShader(GL_TESS_EVALUATION_SHADER, tesContent.c_str());
+						tsCompiled &= gl::CheckShaderCompilationStatus(tes, shaderMessage);
 					}
+				}
 
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
 
-					m_shaderSources[i].VS = vs;
-					m_shaderSources[i].PS = ps;
-					m_shaderSources[i].GS = gs;
-					m_shaderSources[i].TCS = tcs;
-					m_shaderSources[i].TES = tes;
+				if (rec.Shader != 0)
+					glDeleteProgram(rec.Shader);
+
+				if (rec.DebugShader != 0)
+					glDeleteProgram(rec.DebugShader);
+
+				if (!vsCompiled || !psCompiled || !gsCompiled || !tsCompiled) {
+					if (shaderMessage[0] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(item->Name))
+						m_msgs->Add(MessageStack::Type::Error, item->Name, shaderMessage);
+					m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the shader");
+					rec.Shader = 0;
+				} else {
+					m_msgs->ClearGroup(item->Name);
+
+					rec.Shader = glCreateProgram();
+					glAttachShader(rec.Shader, vs);
+					glAttachShader(rec.Shader, ps);
+					if (data->GSUsed) glAttachShader(rec.Shader, gs);
+					if (data->TSUsed) glAttachShader(rec.Shader, tcs);
+					if (data->TSUsed) glAttachShader(rec.Shader, tes);
+					glLinkProgram(rec.Shader);
+					// XXX TODO check link status
+
+					rec.DebugShader = glCreateProgram();
+					glAttachShader(rec.DebugShader, m_generalDebugShader);
+					glAttachShader(rec.DebugShader, vs);
+					if (data->GSUsed) glAttachShader(rec.DebugShader, gs);
+					if (data->TSUsed) glAttachShader(rec.DebugShader, tcs);
+					if (data->TSUsed) glAttachShader(rec.DebugShader, tes);
+					glLinkProgram(rec.DebugShader);
 				}
-				else if (items[i]->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
-					pipe::ComputePass* data = reinterpret_cast<ed::pipe::ComputePass*>(items[i]->Data);
-					int shaderMessagesBefore = m_msgs->GetGroupErrorAndWarningMsgCount(items[i]->Name);
 
-					m_items.insert(m_items.begin() + i, items[i]);
-					m_shaders.insert(m_shaders.begin() + i, 0);
-					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
-					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
+				if (rec.Shader != 0)
+					data->Variables.UpdateUniformInfo(rec.Shader);
 
-					SPIRVQueue.push_back(items[i]);
+				rec.Sources.VS = vs;
+				rec.Sources.PS = ps;
+				rec.Sources.GS = gs;
+				rec.Sources.TCS = tcs;
+				rec.Sources.TES = tes;
+			}
+			else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
+				pipe::ComputePass* data = reinterpret_cast<ed::pipe::ComputePass*>(item->Data);
+				int shaderMessagesBefore = m_msgs->GetGroupErrorAndWarningMsgCount(item->Name);
 
-					// cache performance timer
-					m_perfTimers.insert(m_perfTimers.begin() + i, PerformanceTimer(items[i]));
-					glGenQueries(1, &m_perfTimers[i].Object);
-					m_perfTimers[i].IsCreated = true;
+				CachedItem& rec = m_insertRecord(item);
 
-					if (strlen(data->Path) == 0) {
-						Logger::Get().Log("No shader paths are set", true);
-						continue;
-					}
+				SPIRVQueue.push_back(item);
 
-					/*
-						ITEM CACHING
-					*/
+				if (strlen(data->Path) == 0) {
+					Logger::Get().Log("No shader paths are set", true);
+					continue;
+				}
 
-					GLuint cs = 0;
+				/*
+					ITEM CACHING
+				*/
 
-					m_msgs->CurrentItem = items[i]->Name;
+				GLuint cs = 0;
 
-					std::string content = "", entry = data->Entry;
-					int lineBias = 0;
-					ShaderLanguage lang = ShaderCompiler::GetShaderLanguageFromExtension(data->Path);
+				m_msgs->CurrentItem = item->Name;
 
-					// compute shader
-					bool compiled = false;
+				std::string content = "";
 
-					if (lang == ShaderLanguage::Plugin)
-						compiled = m_pluginCompileToSpirv(items[i], data->SPV, data->Path, entry, plugin::ShaderStage::Compute, data->Macros.data(), data->Macros.size());
-					else
-						compiled = ShaderCompiler::CompileToSPIRV(data->SPV, lang, data->Path, ShaderStage::Compute, entry, data->Macros, m_msgs, m_project);
-					
-					if (lang == ShaderLanguage::GLSL) { // GLSL
-						content = m_project->LoadProjectFile(data->Path);
-						m_includeCheck(content, std::vector<std::string>(), lineBias);
-						m_applyMacros(content, data);
-					} else if (compiled) { // HLSL / VK
-						content = ShaderCompiler::ConvertToGLSL(data->SPV, lang, ShaderStage::Compute, false, false, m_msgs);
-						entry = "main";
+				// compute shader
+				bool compiled = m_compileFrontEnd(item, ShaderStage::Compute, content);
 
-						if (lang == ShaderLanguage::Plugin)
-							content = m_pluginProcessGLSL(data->Path, content.c_str());
-					}
-
-					cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
-					compiled &= gl::CheckShaderCompilationStatus(cs, shaderMessage);
+				cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
+				compiled &= gl::CheckShaderCompilationStatus(cs, shaderMessage);
 
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
+				if (rec.Shader != 0)
+					glDeleteProgram(rec.Shader);
 
-					if (!compiled) {
-						if (shaderMessage[0] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(items[i]->Name))
-							m_msgs->Add(MessageStack::Type::Error, items[i]->Name, shaderMessage);
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the compute shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->ClearGroup(items[i]->Name);
+				if (!compiled) {
+					if (shaderMessage[0] != 0 && shaderMessagesBefore == m_msgs->GetGroupErrorAndWarningMsgCount(item->Name))
+						m_msgs->Add(MessageStack::Type::Error, item->Name, shaderMessage);
+					m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the compute shader");
+					rec.Shader = 0;
+				} else {
+					m_msgs->ClearGroup(item->Name);
 
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
-					}
+					rec.Shader = glCreateProgram();
+					glAttachShader(rec.Shader, cs);
+					glLinkProgram(rec.Shader);
+				}
 
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
+				if (rec.Shader != 0)
+					data->Variables.UpdateUniformInfo(rec.Shader);
 
-					m_shaderSources[i].VS = 0;
-					m_shaderSources[i].PS = 0;
-					m_shaderSources[i].GS = 0;
-					m_shaderSources[i].TCS = 0;
-					m_shaderSources[i].TES = 0;
-				} 
-				else if (items[i]->Type == PipelineItem::ItemType::AudioPass) {
-					pipe::AudioPass* data = reinterpret_cast<ed::pipe::AudioPass*>(items[i]->Data);
+				rec.Sources.VS = 0;
+				rec.Sources.PS = 0;
+				rec.Sources.GS = 0;
+				rec.Sources.TCS = 0;
+				rec.Sources.TES = 0;
+			} 
+			else if (item->Type == PipelineItem::ItemType::AudioPass) {
+				pipe::AudioPass* data = reinterpret_cast<ed::pipe::AudioPass*>(item->Data);
 
-					m_items.insert(m_items.begin() + i, items[i]);
-					m_shaders.insert(m_shaders.begin() + i, 0);
-					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
-					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
+				CachedItem& rec = m_insertRecord(item);
 
-					// cache performance timer
-					m_perfTimers.insert(m_perfTimers.begin() + i, PerformanceTimer(items[i]));
-					glGenQueries(1, &m_perfTimers[i].Object);
-					m_perfTimers[i].IsCreated = true;
+				/*
+					ITEM CACHING
+				*/
 
-					/*
-						ITEM CACHING
-					*/
+				m_msgs->CurrentItem = item->Name;
+				std::string content = m_project->LoadProjectFile(data->Path);
 
-					m_msgs->CurrentItem = items[i]->Name;
-					std::string content = m_project->LoadProjectFile(data->Path);
+				// vertex shader
+				if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL)
+					m_applyMacros(content, data);
+				data->Stream.CompileFromShaderSource(m_project, m_msgs, content, data->Macros, ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::HLSL);
 
-					// vertex shader
-					if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL)
-						m_applyMacros(content, data);
-					data->Stream.CompileFromShaderSource(m_project, m_msgs, content, data->Macros, ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::HLSL);
+				data->Variables.UpdateUniformInfo(data->Stream.GetShader());
+			} 
+			else if (item->Type == PipelineItem::ItemType::PluginItem) {
+				pipe::PluginItemData* data = reinterpret_cast<pipe::PluginItemData*>(item->Data);
 
-					data->Variables.UpdateUniformInfo(data->Stream.GetShader());
-				} 
-				else if (items[i]->Type == PipelineItem::ItemType::PluginItem) {
-					pipe::PluginItemData* data = reinterpret_cast<pipe::PluginItemData*>(items[i]->Data);
-
-					m_items.insert(m_items.begin() + i, items[i]);
-					m_shaders.insert(m_shaders.begin() + i, 0);
-					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
-					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
-
-					// cache performance timer
-					m_perfTimers.insert(m_perfTimers.begin() + i, PerformanceTimer(items[i]));
-					glGenQueries(1, &m_perfTimers[i].Object);
-					m_perfTimers[i].IsCreated = true;
-				}
+				m_insertRecord(item);
 			}
 		}
 
-		// check if some item was removed
-		for (int i = 0; i < m_items.size(); i++) {
-			bool found = false;
-			for (int j = 0; j < items.size(); j++)
-				if (items[j]->Data == m_items[i]->Data) {
-					found = true;
-					break;
-				}
-
-			if (!found) {
-				glDeleteProgram(m_shaders[i]);
-				glDeleteProgram(m_debugShaders[i]);
-				glDeleteQueries(1, &m_perfTimers[i].Object);
-
-				Logger::Get().Log("Removing an item from cache");
-
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass)
-					m_fbos.erase((pipe::ShaderPass*)m_items[i]->Data);
-
-				m_items.erase(m_items.begin() + i);
-				m_shaders.erase(m_shaders.begin() + i);
-				m_debugShaders.erase(m_debugShaders.begin() + i);
-				m_shaderSources.erase(m_shaderSources.begin() + i);
-				m_perfTimers.erase(m_perfTimers.begin() + i);
+		m_frontEnds.clear();
+	}
+	RenderEngine::CachedItem& RenderEngine::m_insertRecord(PipelineItem* item)
+	{
+		std::vector<PipelineItem*>& items = m_pipeline->GetList();
+
+		// the new record goes right after the closest cached item that comes before it in the pipeline
+		size_t pos = 0;
+		auto it = std::find(items.begin(), items.end(), item);
+		while (it != items.begin()) {
+			--it;
+			auto prev = m_recordIndex.find(*it);
+			if (prev != m_recordIndex.end()) {
+				pos = prev->second + 1;
+				break;
 			}
 		}
 
-		// check if the order of the items changed
-		for (int i = 0; i < m_items.size(); i++) {
-			// two items at the same position dont match
-			if (items[i]->Data != m_items[i]->Data) {
-				// find the real position from original list
-				for (int j = 0; j < items.size(); j++) {
-					// we found the original position so move the item
-					if (items[j]->Data == m_items[i]->Data) {
-						Logger::Get().Log("Updating cached item " + std::string(items[j]->Name));
+		m_records.insert(m_records.begin() + pos, CachedItem(item));
+		m_updateRecordIndex(pos);
 
-						int dest = j > i ? (j - 1) : j;
-						m_items.erase(m_items.begin() + i, m_items.begin() + i + 1);
-						m_items.insert(m_items.begin() + dest, items[j]);
+		return m_records[pos];
+	}
+	void RenderEngine::m_updateRecordIndex(size_t start)
+	{
+		for (size_t i = start; i < m_records.size(); i++)
+			m_recordIndex[m_records[i].Item] = i;
+	}
+	void RenderEngine::m_deleteRecord(CachedItem& rec)
+	{
+		glDeleteShader(rec.Sources.VS);
+		glDeleteShader(rec.Sources.PS);
+		glDeleteShader(rec.Sources.GS);
+		glDeleteShader(rec.Sources.TCS);
+		glDeleteShader(rec.Sources.TES);
+		glDeleteProgram(rec.Shader);
+		glDeleteProgram(rec.DebugShader);
+	}
+	void RenderEngine::OnItemAdded(PipelineItem* item)
+	{
+		// compiled on the next m_cache() call so that items added together get compiled together
+		m_pendingItems.push_back(item);
+	}
+	void RenderEngine::OnItemRemoved(PipelineItem* item)
+	{
+		m_pendingItems.erase(std::remove(m_pendingItems.begin(), m_pendingItems.end(), item), m_pendingItems.end());
+		SPIRVQueue.erase(std::remove(SPIRVQueue.begin(), SPIRVQueue.end(), item), SPIRVQueue.end());
 
-						GLuint sCopy = m_shaders[i];
-						GLuint sdbgCopy = m_debugShaders[i];
-						ShaderPack ssrcCopy = m_shaderSources[i];
-						PerformanceTimer perfTimerCopy = m_perfTimers[i];
+		auto index = m_recordIndex.find(item);
+		if (index == m_recordIndex.end())
+			return;
 
-						m_shaders.erase(m_shaders.begin() + i);
-						m_shaders.insert(m_shaders.begin() + dest, sCopy);
+		Logger::Get().Log("Removing an item from cache");
 
-						m_debugShaders.erase(m_debugShaders.begin() + i);
-						m_debugShaders.insert(m_debugShaders.begin() + dest, sdbgCopy);
+		size_t i = index->second;
+		m_deleteRecord(m_records[i]);
 
-						m_shaderSources.erase(m_shaderSources.begin() + i);
-						m_shaderSources.insert(m_shaderSources.begin() + dest, ssrcCopy);
+		if (item->Type == PipelineItem::ItemType::ShaderPass)
+			m_fbos.erase((pipe::ShaderPass*)item->Data);
 
-						m_perfTimers.erase(m_perfTimers.begin() + i);
-						m_perfTimers.insert(m_perfTimers.begin() + dest, perfTimerCopy);
-					}
-				}
-			}
-		}
+		m_recordIndex.erase(index);
+		m_records.erase(m_records.begin() + i);
+		m_updateRecordIndex(i);
+	}
+	void RenderEngine::OnItemsSwapped(PipelineItem* item1, PipelineItem* item2)
+	{
+		// neighbours in the pipeline are also neighbours in m_records, unless one of them isn't cached yet
+		// in which case the order of the records doesn't change
+		auto index1 = m_recordIndex.find(item1);
+		auto index2 = m_recordIndex.find(item2);
+		if (index1 == m_recordIndex.end() || index2 == m_recordIndex.end())
+			return;
+
+		std::swap(m_records[index1->second], m_records[index2->second]);
+		std::swap(index1->second, index2->second);
 	}
 	void RenderEngine::m_applyMacros(std::string& src, pipe::ShaderPass* pass)
 	{
@@ -2519,8 +2307,138 @@ namespace ed {
 		
 		return ret;
 	}
-	void RenderEngine::m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias)
+	static bool getStageInfo(PipelineItem* item, ShaderStage stage, const char*& path, const char*& entry, std::vector<GLuint>*& spv)
+	{
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			switch (stage) {
+			case ShaderStage::Vertex: path = pass->VSPath; entry = pass->VSEntry; spv = &pass->VSSPV; return true;
+			case ShaderStage::Pixel: path = pass->PSPath; entry = pass->PSEntry; spv = &pass->PSSPV; return true;
+			case ShaderStage::Geometry: path = pass->GSPath; entry = pass->GSEntry; spv = &pass->GSSPV; return true;
+			case ShaderStage::TessellationControl: path = pass->TCSPath; entry = pass->TCSEntry; spv = &pass->TCSSPV; return true;
+			case ShaderStage::TessellationEvaluation: path = pass->TESPath; entry = pass->TESEntry; spv = &pass->TESSPV; return true;
+			default: return false;
+			}
+		} else if (item->Type == PipelineItem::ItemType::ComputePass && stage == ShaderStage::Compute) {
+			pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+			path = pass->Path;
+			entry = pass->Entry;
+			spv = &pass->SPV;
+			return true;
+		}
+		return false;
+	}
+	bool RenderEngine::m_runFrontEnd(PipelineItem* item, ShaderStage stage, std::string& source, MessageStack* msgs)
+	{
+		ProfileScope frontEndScope("Compile front-end"); // worker thread
+
+		const char *path = nullptr, *entry = nullptr;
+		std::vector<GLuint>* spv = nullptr;
+		if (!getStageInfo(item, stage, path, entry, spv))
+			return false;
+
+		bool isCompute = item->Type == PipelineItem::ItemType::ComputePass;
+		std::vector<ShaderMacro>& macros = isCompute ? ((pipe::ComputePass*)item->Data)->Macros : ((pipe::ShaderPass*)item->Data)->Macros;
+		bool tsUsed = !isCompute && ((pipe::ShaderPass*)item->Data)->TSUsed;
+		bool gsUsed = !isCompute && ((pipe::ShaderPass*)item->Data)->GSUsed;
+
+		ShaderLanguage lang = ShaderCompiler::GetShaderLanguageFromExtension(path);
+
+		bool compiled = false;
+		if (lang == ShaderLanguage::Plugin)
+			compiled = m_pluginCompileToSpirv(item, *spv, path, entry, (plugin::ShaderStage)stage, macros.data(), macros.size());
+		else
+			compiled = ShaderCompiler::CompileToSPIRV(*spv, lang, path, stage, entry, macros, msgs, m_project);
+
+		// generate glsl
+		if (lang == ShaderLanguage::GLSL) { // GLSL
+			int lineBias = 0;
+			source = m_project->LoadProjectFile(path);
+			m_includeCheck(source, std::vector<std::string>(), lineBias, msgs);
+			if (isCompute)
+				m_applyMacros(source, (pipe::ComputePass*)item->Data);
+			else
+				m_applyMacros(source, (pipe::ShaderPass*)item->Data);
+		} else if (compiled) { // HLSL / VK
+			source = ShaderCompiler::ConvertToGLSL(*spv, lang, stage, tsUsed, gsUsed, msgs);
+
+			if (lang == ShaderLanguage::Plugin)
+				source = m_pluginProcessGLSL(path, source.c_str());
+		}
+
+		return compiled;
+	}
+	void RenderEngine::m_prepareFrontEnds(const std::vector<PipelineItem*>& items)
 	{
+		std::vector<std::pair<PipelineItem*, ShaderStage>> jobs;
+		auto addJob = [&](PipelineItem* item, ShaderStage stage) {
+			const char *path = nullptr, *entry = nullptr;
+			std::vector<GLuint>* spv = nullptr;
+			if (!getStageInfo(item, stage, path, entry, spv) || strlen(path) == 0 || strlen(entry) == 0)
+				return;
+
+			// plugins aren't expected to be thread safe - their stages get compiled later, on this thread
+			if (ShaderCompiler::GetShaderLanguageFromExtension(path) == ShaderLanguage::Plugin)
+				return;
+
+			if (m_frontEnds.count(std::make_pair(item->Data, stage)) == 0)
+				jobs.push_back(std::make_pair(item, stage));
+		};
+
+		for (PipelineItem* item : items) {
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+				if (strlen(pass->VSPath) == 0 || strlen(pass->PSPath) == 0)
+					continue;
+
+				addJob(item, ShaderStage::Vertex);
+				addJob(item, ShaderStage::Pixel);
+				if (pass->GSUsed)
+					addJob(item, ShaderStage::Geometry);
+				if (pass->TSUsed && m_tessellationSupported) {
+					addJob(item, ShaderStage::TessellationControl);
+					addJob(item, ShaderStage::TessellationEvaluation);
+				}
+			} else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported)
+				addJob(item, ShaderStage::Compute);
+		}
+
+		// a single stage is compiled just as fast on the GL thread
+		if (jobs.size() < 2)
+			return;
+
+		if (m_compilePool == nullptr)
+			m_compilePool = new eng::ThreadPool();
+
+		std::vector<ShaderFrontEnd> results(jobs.size());
+		m_compilePool->ParallelFor(jobs.size(), [&](size_t index, size_t worker) {
+			ShaderFrontEnd& result = results[index];
+			result.Messages.CurrentItem = jobs[index].first->Name;
+			result.Compiled = m_runFrontEnd(jobs[index].first, jobs[index].second, result.Source, &result.Messages);
+		});
+
+		for (size_t i = 0; i < jobs.size(); i++)
+			m_frontEnds[std::make_pair(jobs[i].first->Data, jobs[i].second)] = std::move(results[i]);
+	}
+	bool RenderEngine::m_compileFrontEnd(PipelineItem* item, ShaderStage stage, std::string& source)
+	{
+		auto result = m_frontEnds.find(std::make_pair(item->Data, stage));
+		if (result == m_frontEnds.end())
+			return m_runFrontEnd(item, stage, source, m_msgs);
+
+		// messages were collected on a worker thread - add them now, in the same place a serial compile would
+		m_msgs->Add(result->second.Messages.GetMessages());
+		source = std::move(result->second.Source);
+		bool compiled = result->second.Compiled;
+		m_frontEnds.erase(result);
+
+		return compiled;
+	}
+	void RenderEngine::m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias, MessageStack* msgs)
+	{
+		if (msgs == nullptr)
+			msgs = m_msgs;
+
 		size_t incLoc = src.find("#include");
 		Settings& settings = Settings::Instance();
 
@@ -2553,7 +2471,7 @@ namespace ed {
 				src.erase(incLoc, src.find_first_of('\n', incLoc) - incLoc);
 
 				if (std::count(includeStack.begin(), includeStack.end(), ipath) > 0)
-					m_msgs->Add(ed::MessageStack::Type::Error, m_msgs->CurrentItem, "Recursive #include detected");
+					msgs->Add(ed::MessageStack::Type::Error, msgs->CurrentItem, "Recursive #include detected");
 
 				if (m_project->FileExists(ipath) && std::count(includeStack.begin(), includeStack.end(), ipath) == 0) {
 					includeStack.push_back(ipath);
@@ -2561,7 +2479,7 @@ namespace ed {
 					std::string incFileSrc = m_project->LoadProjectFile(ipath);
 					lineBias = std::count(incFileSrc.begin(), incFileSrc.end(), '\n');
 
-					m_includeCheck(incFileSrc, includeStack, lineBias);
+					m_includeCheck(incFileSrc, includeStack, lineBias, msgs);
 
 					src.insert(incLoc, incFileSrc);
 
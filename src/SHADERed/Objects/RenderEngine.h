@@ -1,13 +1,15 @@
 #pragma once
+#include <SHADERed/Engine/PixelReadback.h>
+#include <SHADERed/Engine/ThreadPool.h>
 #include <SHADERed/Engine/Timer.h>
 #include <SHADERed/Objects/DebugInformation.h>
 #include <SHADERed/Objects/MessageStack.h>
 #include <SHADERed/Objects/PipelineManager.h>
 #include <SHADERed/Objects/PluginManager.h>
 #include <SHADERed/Objects/ProjectParser.h>
-#include <SHADERed/Objects/PerformanceTimer.h>
 
 #include <functional>
+#include <map>
 #include <unordered_map>
 
 #include <glm/glm.hpp>
@@ -24,8 +26,6 @@
 namespace ed {
 	class ObjectManager;
 
-	uint32_t getPixelID(GLuint rt, uint8_t* data, int x, int y, int width);
-
 	class RenderEngine {
 	public:
 		RenderEngine(PipelineManager* pipeline, ObjectManager* objects, ProjectParser* project, MessageStack* messages, PluginManager* plugins, DebugInformation* debugger);
@@ -34,16 +34,40 @@ namespace ed {
 		int DebugVertexPick(PipelineItem* pass, PipelineItem* item, glm::vec2 r, int group);
 		int DebugInstancePick(PipelineItem* pass, PipelineItem* item, glm::vec2 r, int group);
 
+		void Resize(int width, int height); // resize window & render textures - called by Render()
 		void Render(int width, int height, bool isDebug = false, PipelineItem* breakItem = nullptr);
 		inline void Render(bool isDebug = false, PipelineItem* breakItem = nullptr) { Render(m_lastSize.x, m_lastSize.y, isDebug, breakItem); }
 		void Recompile(const char* name);
+		void Recompile(const std::vector<PipelineItem*>& items); // shader front-ends of all items are compiled in parallel
 		void RecompileFile(const char* fname);
 		void RecompileFromSource(const char* name, const std::string& vs = "", const std::string& ps = "", const std::string& gs = "", const std::string& tcs = "", const std::string& tes = "");
 		void Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func = nullptr);
 		void Pick(PipelineItem* item, bool add = false);
 		inline bool IsPicked(PipelineItem* item) { return std::count(m_pick.begin(), m_pick.end(), item); }
 
+		// limit shader passes to a few pixels around r (relative position) - used when only a single pixel's value is needed
+		inline void SetScissor(bool enabled, const glm::vec2& r = glm::vec2(0.0f))
+		{
+			m_scissor = enabled;
+			m_scissorPos = r;
+		}
+
+		// render pass with shader into fbo (single color attachment + depth) instead of its own render textures
+		// and stop after it - used by the variable viewer. shader == 0 -> render normally
+		inline void SetPassOverride(PipelineItem* pass, GLuint shader = 0, GLuint fbo = 0)
+		{
+			m_overrideItem = pass;
+			m_overrideShader = shader;
+			m_overrideFBO = fbo;
+		}
+
 		void FlushCache();
+		inline void UpdateCache() { m_cache(); } // compile newly added/changed items without rendering
+
+		// called by PipelineManager for top level items (passes) - the cache follows the pipeline through these instead of polling it
+		void OnItemAdded(PipelineItem* item);
+		void OnItemRemoved(PipelineItem* item); // item is still valid here
+		void OnItemsSwapped(PipelineItem* item1, PipelineItem* item2); // PipelineManager only swaps neighbours
 		void AddPickedItem(PipelineItem* pipe, bool multiPick = false);
 
 		std::pair<PipelineItem*, PipelineItem*> GetPipelineItemByDebugID(int id); // get pipeline item by it's debug id
@@ -60,8 +84,6 @@ namespace ed {
 		inline GLuint GetDepthTexture() { return m_rtDepth; }
 		inline glm::ivec2 GetLastRenderSize() { return m_lastSize; }
 
-		inline const std::vector<PerformanceTimer>& GetPerformanceTimers() { return m_perfTimers; }
-		inline unsigned long long GetGPUTime() { return m_totalPerfTime; }
 
 		inline bool IsPaused() { return m_paused; }
 		void Pause(bool pause);
@@ -70,6 +92,26 @@ namespace ed {
 		std::vector<PipelineItem*> SPIRVQueue;
 
 	public:
+		struct ShaderPack {
+			ShaderPack() { VS = GS = PS = TCS = TES = 0; }
+			GLuint VS, PS, GS, TCS, TES;
+		};
+
+		// everything the renderer keeps for a single top level pipeline item
+		struct CachedItem {
+			CachedItem(PipelineItem* item)
+					: Item(item)
+			{
+				Shader = DebugShader = 0;
+			}
+
+			PipelineItem* Item;
+			GLuint Shader;
+			GLuint DebugShader;
+			ShaderPack Sources;
+		};
+		inline const std::vector<CachedItem>& GetCachedItems() { return m_records; }
+
 		struct ItemVariableValue {
 			ItemVariableValue(ed::ShaderVariable* var)
 			{
@@ -128,7 +170,22 @@ namespace ed {
 		bool m_fbosNeedUpdate;
 
 		// check for the #include's & change the source code accordingly (includeStack == prevent recursion)
-		void m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias);
+		void m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias, MessageStack* msgs = nullptr);
+
+		// recompile a single item - used by Recompile()
+		void m_recompile(const char* name);
+
+		// glslang -> SPIR-V -> SPIRV-Cross part of the compilation, doesn't touch GL so it can run on any thread
+		struct ShaderFrontEnd {
+			bool Compiled;
+			std::string Source; // GLSL code that is passed to gl::CompileShader()
+			MessageStack Messages;
+		};
+		std::map<std::pair<void*, ShaderStage>, ShaderFrontEnd> m_frontEnds; // (item->Data, stage) -> prepared front-end
+		eng::ThreadPool* m_compilePool;
+		bool m_runFrontEnd(PipelineItem* item, ShaderStage stage, std::string& source, MessageStack* msgs);
+		void m_prepareFrontEnds(const std::vector<PipelineItem*>& items);
+		bool m_compileFrontEnd(PipelineItem* item, ShaderStage stage, std::string& source); // uses the prepared result if there is one
 
 		// apply macros to GLSL source code
 		void m_applyMacros(std::string& source, pipe::ShaderPass* pass);
@@ -149,23 +206,25 @@ namespace ed {
 		bool m_wasMultiPick;
 		void m_pickItem(PipelineItem* item, bool multiPick);
 
+		/* pixel debugging */
+		bool m_scissor;
+		glm::vec2 m_scissorPos;
+		void m_enableScissor(pipe::ShaderPass* pass, int width, int height);
+		void m_disableScissor();
+		eng::PixelReadback m_pickReadback;
+
+		/* variable viewer */
+		PipelineItem* m_overrideItem;
+		GLuint m_overrideShader, m_overrideFBO;
+
 		// cache
-		std::vector<PipelineItem*> m_items;
-		std::vector<GLuint> m_shaders;
-		std::vector<GLuint> m_debugShaders;
+		std::vector<CachedItem> m_records;		   // same order as the pipeline
+		std::unordered_map<PipelineItem*, size_t> m_recordIndex; // item -> index in m_records
+		std::vector<PipelineItem*> m_pendingItems; // added to the pipeline but not compiled yet
 		std::unordered_map<pipe::ShaderPass*, std::vector<GLuint>> m_fbos;
 		std::unordered_map<pipe::ShaderPass*, GLuint> m_fboMS; // multisampled fbo's
 		std::unordered_map<pipe::ShaderPass*, GLuint> m_fboCount;
 		std::unordered_map<pipe::ComputePass*, int> m_uboMax;
-		struct ShaderPack {
-			ShaderPack() { VS = GS = PS = TCS = TES = 0; }
-			GLuint VS, PS, GS, TCS, TES;
-		};
-		std::vector<ShaderPack> m_shaderSources;
-
-		std::vector<PerformanceTimer> m_perfTimers;
-		unsigned long long m_totalPerfTime;
-		eng::Timer m_lastPerfMeasure;
 
 		GLuint m_generalDebugShader;
 
@@ -173,7 +232,9 @@ namespace ed {
 
 		std::vector<ItemVariableValue> m_itemValues; // list of all values to apply once we start rendering
 
-		eng::Timer m_cacheTimer;
 		void m_cache();
+		CachedItem& m_insertRecord(PipelineItem* item);
+		void m_updateRecordIndex(size_t start);
+		void m_deleteRecord(CachedItem& rec);
 	};
 }
\ No newline at end of file
@@ -36,6 +36,8 @@ namespace ed {
 		General.Log = true;
 		General.PipeLogsToTerminal = false;
 		General.Tips = false;
+		General.CompactModels = true;
+		General.ReleaseModelData = false;
 		DPIScale = 1.0f;
 		strcpy(General.Font, "null");
 		General.FontSize = 15;
@@ -67,6 +69,8 @@ namespace ed {
 		Debug.AutoFetch = true;
 		Debug.PrimitiveOutline = true;
 		Debug.PixelOutline = true;
+		Debug.AnalysisThreads = 0;
+		Debug.AnalysisQuads = false;
 
 		Preview.PausedOnStartup = false;
 		Preview.SwitchLeftRightClick = false;
@@ -84,6 +88,7 @@ namespace ed {
 		Preview.ApplyFPSLimitToApp = false;
 		Preview.LostFocusLimitFPS = false;
 		Preview.MSAA = 1;
+		Preview.AudioShaderCPU = false;
 	}
 	void Settings::Load()
 	{
@@ -122,6 +127,8 @@ namespace ed {
 		General.StartUpTemplate = ini.Get("general", "template", "GLSL");
 		General.AutoScale = ini.GetBoolean("general", "autoscale", true);
 		General.Tips = ini.GetBoolean("general", "tips", false);
+		General.CompactModels = ini.GetBoolean("general", "compactmodels", true);
+		General.ReleaseModelData = ini.GetBoolean("general", "releasemodeldata", false);
 		DPIScale = ini.GetReal("general", "uiscale", 1.0f);
 		strcpy(General.Font, ini.Get("general", "font", "data/NotoSans.ttf").c_str());
 		General.FontSize = ini.GetInteger("general", "fontsize", 18);
@@ -154,6 +161,8 @@ namespace ed {
 		Debug.AutoFetch = ini.GetBoolean("debug", "autofetch", true);
 		Debug.PixelOutline = ini.GetBoolean("debug", "pixeloutline", true);
 		Debug.PrimitiveOutline = ini.GetBoolean("debug", "primitiveoutline", true);
+		Debug.AnalysisThreads = std::max<int>(0, ini.GetInteger("debug", "analysisthreads", 0));
+		Debug.AnalysisQuads = ini.GetBoolean("debug", "analysisquads", false);
 
 		Preview.PausedOnStartup = ini.GetBoolean("preview", "pausedonstartup", false);
 		Preview.SwitchLeftRightClick = ini.GetBoolean("preview", "switchleftrightclick", false);
@@ -171,6 +180,7 @@ namespace ed {
 		Preview.ApplyFPSLimitToApp = ini.GetBoolean("preview", "fpslimitwholeapp", false);
 		Preview.LostFocusLimitFPS = ini.GetBoolean("preview", "fpslimitlostfocus", false);
 		Preview.MSAA = ini.GetInteger("preview", "msaa", 1);
+		Preview.AudioShaderCPU = ini.GetBoolean("preview", "audioshadercpu", false);
 
 		m_parseExt(ini.Get("plugins", "notloaded", ""), Plugins.NotLoaded);
 
@@ -217,6 +227,8 @@ namespace ed {
 		ini << "autoscale=" << General.AutoScale << std::endl;
 		ini << "uiscale=" << DPIScale << std::endl;
 		ini << "tips=" << General.Tips << std::endl;
+		ini << "compactmodels=" << General.CompactModels << std::endl;
+		ini << "releasemodeldata=" << General.ReleaseModelData << std::endl;
 
 		ini << "hlslext=";
 		for (int i = 0; i < General.HLSLExtensions.size(); i++) {
@@ -262,6 +274,7 @@ namespace ed {
 		ini << "fpslimitwholeapp=" << Preview.ApplyFPSLimitToApp << std::endl;
 		ini << "fpslimitlostfocus=" << Preview.LostFocusLimitFPS << std::endl;
 		ini << "msaa=" << Preview.MSAA << std::endl;
+		ini << "audioshadercpu=" << Preview.AudioShaderCPU << std::endl;
 
 		ini << "[editor]" << std::endl;
 		ini << "smartpred=" << Editor.SmartPredictions << std::endl;
@@ -290,6 +303,8 @@ namespace ed {
 		ini << "autofetch=" << Debug.AutoFetch << std::endl;
 		ini << "pixeloutline=" << Debug.PixelOutline << std::endl;
 		ini << "primitiveoutline=" << Debug.PrimitiveOutline << std::endl;
+		ini << "analysisthreads=" << Debug.AnalysisThreads << std::endl;
+		ini << "analysisquads=" << Debug.AnalysisQuads << std::endl;
 
 		ini << "[plugins]" << std::endl;
 		ini << "notloaded=";
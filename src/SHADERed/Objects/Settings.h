@@ -47,6 +47,8 @@ namespace ed {
 			int FontSize;
 			bool AutoScale;
 			bool Tips;
+			bool CompactModels;		// pack model vertices (snorm normals, unorm texcoords, ...) before uploading them
+			bool ReleaseModelData; // free the CPU copy of model vertices once they are on the GPU
 			std::vector<std::string> HLSLExtensions;
 			std::vector<std::string> VulkanGLSLExtensions;
 			std::unordered_map<std::string, std::vector<std::string>> PluginShaderExtensions;
@@ -80,6 +82,8 @@ namespace ed {
 			bool AutoFetch;
 			bool PrimitiveOutline;
 			bool PixelOutline;
+			int AnalysisThreads; // 0 -> use all cores
+			bool AnalysisQuads;	 // shade 2x2 quads at once in frame analysis when the shader uses derivatives
 		} Debug;
 
 		struct strPreview {
@@ -98,6 +102,7 @@ namespace ed {
 			bool ApplyFPSLimitToApp; // apply FPSLimit to whole app, not only preview
 			bool LostFocusLimitFPS;	 // limit to 30FPS when app loses focus
 			int MSAA;				 // 1 (off), 2, 4, 8
+			bool AudioShaderCPU;	 // run audio shaders on the CPU (SPIR-V VM) instead of reading them back from the GPU
 		} Preview;
 
 		struct strProject {
@@ -1,10 +1,16 @@
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include <SHADERed/Engine/GLUtils.h>
+#include <SHADERed/Engine/Hash.h>
 #include <SHADERed/Objects/ShaderFileIncluder.h>
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/Settings.h>
@@ -134,21 +140,133 @@ const TBuiltInResource DefaultTBuiltInResource = {
 	}
 };
 
+#define SHADER_CACHE_VERSION 1
+#define SHADER_CACHE_MAX_SIZE 64		 // MB - least recently used files in cache/shaders are removed above this
+#define SHADER_CACHE_PRUNE_INTERVAL 64 // cache/shaders is only scanned every N writes
+
 namespace ed {
+	/*
+		glslang & SPIRV-Cross output is cached on disk, keyed on everything that goes into it. cache file layout:
+			char[4] magic; uint32 version; uint32 size; byte[size] data
+	*/
+	static bool loadShaderCache(const std::string& path, const char* magic, std::string& data)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+
+		char fileMagic[4] = { 0 };
+		uint32_t version = 0, size = 0;
+		bool ok = fread(fileMagic, 1, 4, file) == 4 && memcmp(fileMagic, magic, 4) == 0;
+		ok = ok && fread(&version, sizeof(uint32_t), 1, file) == 1 && version == SHADER_CACHE_VERSION;
+		ok = ok && fread(&size, sizeof(uint32_t), 1, file) == 1;
+		if (ok) {
+			data.resize(size);
+			ok = fread(&data[0], 1, size, file) == size;
+		}
+
+		fclose(file);
+
+		// mark the file as recently used so that it's the last one to be evicted
+		if (ok) {
+			std::error_code errCode;
+			std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), errCode);
+		}
+
+		return ok;
+	}
+	static void pruneShaderCache(const std::filesystem::path& cacheDir)
+	{
+		// another thread is already doing this
+		static std::mutex pruneLock;
+		std::unique_lock<std::mutex> lock(pruneLock, std::try_to_lock);
+		if (!lock.owns_lock())
+			return;
+
+		struct CacheFile {
+			std::filesystem::path Path;
+			std::filesystem::file_time_type Time;
+			uintmax_t Size;
+		};
+
+		std::error_code errCode;
+		std::vector<CacheFile> files;
+		uintmax_t total = 0;
+		for (const auto& entry : std::filesystem::directory_iterator(cacheDir, errCode)) {
+			if (!entry.is_regular_file(errCode) || entry.path().extension() == ".tmp")
+				continue;
+
+			CacheFile file = { entry.path(), entry.last_write_time(errCode), entry.file_size(errCode) };
+			total += file.Size;
+			files.push_back(file);
+		}
+
+		const uintmax_t maxSize = (uintmax_t)SHADER_CACHE_MAX_SIZE * 1024 * 1024;
+		if (total <= maxSize)
+			return;
+
+		// oldest first - a cache hit refreshes the modification time
+		std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.Time < b.Time; });
+		for (size_t i = 0; i < files.size() && total > maxSize; i++)
+			if (std::filesystem::remove(files[i].Path, errCode))
+				total -= files[i].Size;
+	}
+	static void saveShaderCache(const std::string& path, const char* magic, const void* data, uint32_t size)
+	{
+		std::error_code errCode;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), errCode);
+
+		// passes can be compiled from multiple threads - give each writer its own temporary file
+		std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (file == nullptr)
+			return;
+
+		uint32_t version = SHADER_CACHE_VERSION;
+		fwrite(magic, 1, 4, file);
+		fwrite(&version, sizeof(uint32_t), 1, file);
+		fwrite(&size, sizeof(uint32_t), 1, file);
+		fwrite(data, 1, size, file);
+
+		bool failed = ferror(file) != 0;
+		fclose(file);
+
+		if (failed)
+			std::filesystem::remove(tempPath, errCode);
+		else
+			std::filesystem::rename(tempPath, path, errCode);
+
+		static std::atomic<uint32_t> writeCount(0);
+		if (writeCount++ % SHADER_CACHE_PRUNE_INTERVAL == 0)
+			pruneShaderCache(std::filesystem::path(path).parent_path());
+	}
+
 	std::string ShaderCompiler::ConvertToGLSL(const std::vector<unsigned int>& spvIn, ShaderLanguage inLang, ShaderStage sType, bool tsUsed, bool gsUsed, MessageStack* msgs, bool convertNames)
 	{
 		if (spvIn.empty())
 			return "";
 
+		int ver = 330;
+		if (GLEW_ARB_shader_storage_buffer_object)
+			ver = 430;
+		ver = (sType == ShaderStage::Compute) ? 430 : ver;
+
+		// check if this exact SPIR-V was already transcompiled with the same settings
+		uint32_t cacheParams[7] = { SHADERED_VERSION, (uint32_t)inLang, (uint32_t)sType, tsUsed, gsUsed, convertNames, (uint32_t)ver };
+		uint64_t cacheHash = eng::Hash(cacheParams, sizeof(cacheParams));
+		cacheHash = eng::Hash(spvIn.data(), spvIn.size() * sizeof(unsigned int), cacheHash);
+		std::string cachePath = Settings::Instance().ConvertPath("cache/shaders/" + eng::HashToString(cacheHash) + ".glsl");
+
+		std::string cached;
+		if (loadShaderCache(cachePath, "SEDG", cached))
+			return cached;
+
 		// Read SPIR-V
 		spirv_cross::CompilerGLSL glsl(std::move(spvIn));
 
 		// Set options
 		spirv_cross::CompilerGLSL::Options options;
-		int ver = 330;
-		if (GLEW_ARB_shader_storage_buffer_object)
-			ver = 430;
-		options.version = (sType == ShaderStage::Compute) ? 430 : ver;
+		options.version = ver;
 		glsl.set_common_options(options);
 
 		// Set entry
@@ -349,6 +467,8 @@ namespace ed {
 			}
 		}
 
+		saveShaderCache(cachePath, "SEDG", source.data(), source.size());
+
 		return source;
 	}
 	std::string ShaderCompiler::ConvertToHLSL(const std::vector<unsigned int>& spvIn, ShaderStage sType)
@@ -505,6 +625,23 @@ namespace ed {
 			return false;
 		}
 
+		// skip parsing, linking & SPIR-V generation if the preprocessed source was already compiled with the same settings
+		uint32_t cacheParams[4] = { SHADERED_VERSION, (uint32_t)inLang, (uint32_t)sType, (uint32_t)processedShader.size() };
+		uint64_t cacheHash = eng::Hash(cacheParams, sizeof(cacheParams));
+		cacheHash = eng::Hash(entry + '\0' + filename + '\0', cacheHash); // file name ends up in the debug info
+		for (auto& macro : macros)
+			if (macro.Active)
+				cacheHash = eng::Hash(std::string(macro.Name) + '=' + std::string(macro.Value) + '\0', cacheHash);
+		cacheHash = eng::Hash(processedShader, cacheHash);
+		std::string cachePath = Settings::Instance().ConvertPath("cache/shaders/" + eng::HashToString(cacheHash) + ".spv");
+
+		std::string cached;
+		if (loadShaderCache(cachePath, "SEDS", cached) && cached.size() % sizeof(unsigned int) == 0) {
+			spvOut.resize(cached.size() / sizeof(unsigned int));
+			memcpy(spvOut.data(), cached.data(), cached.size());
+			return true;
+		}
+
 		// update strings
 		const char* processedStr = processedShader.c_str();
 		shader.setStrings(&processedStr, 1);
@@ -549,6 +686,8 @@ namespace ed {
 		spvOptions.validate = true;
 
 		glslang::GlslangToSpv(*prog.getIntermediate(shaderType), spvOut, &logger, &spvOptions);
+
+		saveShaderCache(cachePath, "SEDS", spvOut.data(), spvOut.size() * sizeof(unsigned int));
 	
 		return true;
 	}
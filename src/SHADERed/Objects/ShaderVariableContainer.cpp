@@ -1,13 +1,21 @@
 #include <SHADERed/Objects/FunctionVariableManager.h>
+#include <SHADERed/Objects/Profiler.h>
 #include <SHADERed/Objects/ShaderVariableContainer.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
+#include <algorithm>
 #include <iostream>
 #include <regex>
 
 namespace ed {
-	ShaderVariableContainer::ShaderVariableContainer() { }
+	ShaderVariableContainer::ShaderVariableContainer()
+	{
+		m_program = 0;
+		m_info = nullptr;
+	}
 	ShaderVariableContainer::~ShaderVariableContainer()
 	{
+		m_clearPrograms();
+
 		for (int i = 0; i < m_vars.size(); i++) {
 			free(m_vars[i]->Data);
 			if (m_vars[i]->Arguments != nullptr)
@@ -35,11 +43,22 @@ namespace ed {
 				break;
 			}
 	}
-	void ShaderVariableContainer::UpdateUniformInfo(GLuint pass)
+	void ShaderVariableContainer::UpdateUniformInfo(GLuint pass, bool relinked)
 	{
 		if (pass == 0)
 			return;
 
+		// already known -> just switch to it
+		if (!relinked) {
+			auto cached = m_programs.find(pass);
+			if (cached != m_programs.end()) {
+				m_program = pass;
+				m_info = &cached->second;
+				return;
+			}
+		} else
+			m_clearPrograms(); // the other programs of this pass were most likely relinked too
+
 		GLint count;
 
 		const GLsizei bufSize = 64; // maximum name length
@@ -47,7 +66,12 @@ namespace ed {
 		GLsizei length;				// name length
 		GLuint samplerLoc = 0;
 
-		m_uLocs.clear();
+		ProgramInfo& info = m_programs[pass];
+		info.Uniforms.clear();
+		info.UniformNames.clear();
+		info.Slots.clear(); // new program -> everything has to be uploaded again
+		m_program = pass;
+		m_info = &info;
 
 		glGetProgramiv(pass, GL_ACTIVE_UNIFORMS, &count);
 		for (GLuint i = 0; i < count; i++) {
@@ -56,12 +80,54 @@ namespace ed {
 
 			glGetActiveUniform(pass, (GLuint)i, bufSize, &length, &size, &type, name);
 
-			if (type == GL_SAMPLER_2D)
+			if (type == GL_SAMPLER_2D) {
 				glUniform1i(glGetUniformLocation(pass, name), samplerLoc++);
-			else
-				m_uLocs[name] = glGetUniformLocation(pass, name);
+				continue;
+			}
+
+			// uniform block members are set through the buffers the user binds to the block
+			GLint blockIndex = -1;
+			glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+			if (blockIndex != -1)
+				continue;
+
+			UniformInfo uniform;
+			uniform.Type = type;
+			uniform.Location = glGetUniformLocation(pass, name);
+
+			info.UniformNames[name] = info.Uniforms.size();
+			info.Uniforms.push_back(uniform);
+		}
+	}
+	void ShaderVariableContainer::ForgetProgram(GLuint pass)
+	{
+		m_programs.erase(pass);
+
+		if (m_program == pass) {
+			m_program = 0;
+			m_info = nullptr;
 		}
 	}
+	void ShaderVariableContainer::m_clearPrograms()
+	{
+		m_programs.clear();
+		m_info = nullptr;
+	}
+	void ShaderVariableContainer::m_resolve(UniformSlot& slot, ShaderVariable* var)
+	{
+		slot.Variable = var;
+		slot.Type = var->GetType();
+		slot.Name = var->Name;
+		slot.Uniform = -1;
+		slot.Value.resize(ShaderVariable::GetSize(slot.Type));
+		slot.Uploaded = false;
+
+		auto it = m_info->UniformNames.find(slot.Name);
+		if (it == m_info->UniformNames.end())
+			return;
+
+		slot.Uniform = it->second;
+	}
 	void ShaderVariableContainer::UpdateTextureList(const std::string& fragShader)
 	{
 		m_samplers.clear();
@@ -91,20 +157,36 @@ namespace ed {
 	}
 	void ShaderVariableContainer::Bind(void* item)
 	{
+		ProfileScope bindScope("Bind variables");
+
+		if (m_info == nullptr)
+			return;
+
+		std::vector<UniformSlot>& slots = m_info->Slots;
+		if (slots.size() != m_vars.size()) {
+			slots.resize(m_vars.size());
+			for (auto& slot : slots)
+				slot.Variable = nullptr;
+		}
+
 		for (int i = 0; i < m_vars.size(); i++) {
 			FunctionVariableManager::Instance().AddToList(m_vars[i]);
 
-			if (m_uLocs.count(m_vars[i]->Name) == 0)
+			// variables can be added, removed, renamed or retyped at any time - only look them up again when that happens
+			UniformSlot& slot = slots[i];
+			if (slot.Variable != m_vars[i] || slot.Type != m_vars[i]->GetType() || strcmp(slot.Name.c_str(), m_vars[i]->Name) != 0)
+				m_resolve(slot, m_vars[i]);
+
+			if (slot.Uniform == -1)
 				continue;
 
-			GLint loc = m_uLocs[m_vars[i]->Name];
+			const UniformInfo& info = m_info->Uniforms[slot.Uniform];
+			GLint loc = info.Location;
 
 			// update values if needed
 			SystemVariableManager::Instance().Update(m_vars[i], item);
 			FunctionVariableManager::Instance().Update(m_vars[i]);
 
-			// update uniform every time we bind this container
-			// TODO: maybe we shouldn't update variables that havent changed
 			ShaderVariable::ValueType type = m_vars[i]->GetType();
 
 			// check the flags
@@ -121,6 +203,12 @@ namespace ed {
 				}
 			}
 
+			// skip the upload if the program already has this value
+			if (slot.Uploaded && memcmp(slot.Value.data(), m_vars[i]->Data, slot.Value.size()) == 0)
+				continue;
+			memcpy(slot.Value.data(), m_vars[i]->Data, slot.Value.size());
+			slot.Uploaded = true;
+
 			switch (type) {
 			case ShaderVariable::ValueType::Boolean1:
 				glUniform1i(loc, m_vars[i]->AsBoolean());
@@ -163,6 +251,7 @@ namespace ed {
 				break;
 			}
 		}
+
 	}
 	bool ShaderVariableContainer::ContainsVariable(const char* name)
 	{
@@ -1,6 +1,7 @@
 #pragma once
 #include <SHADERed/Objects/ShaderVariable.h>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
@@ -24,7 +25,10 @@ namespace ed {
 		void Remove(const char* name);
 
 		bool ContainsVariable(const char* name);
-		void UpdateUniformInfo(GLuint pass);
+		// relinked == false -> pass was already seen by this container and wasn't linked again since, so
+		// the cached uniform info is reused (switching between the normal and debug programs every frame)
+		void UpdateUniformInfo(GLuint pass, bool relinked = true);
+		void ForgetProgram(GLuint pass); // pass was deleted - its ID might be reused by a different program
 		void UpdateTexture(GLuint pass, GLuint unit);
 		void UpdateTextureList(const std::string& fragShader);
 		void Bind(void* item = nullptr);
@@ -32,8 +36,38 @@ namespace ed {
 		inline const std::vector<std::string>& GetSamplerList() { return m_samplers; }
 
 	private:
+		// an active uniform of the linked program (uniform block members aren't included)
+		struct UniformInfo {
+			GLint Location;
+			GLenum Type;
+		};
+
+		// m_vars[i] resolved to a uniform - Value holds the last value uploaded with glUniform*, so that
+		// unchanged variables are skipped
+		struct UniformSlot {
+			ShaderVariable* Variable;
+			ShaderVariable::ValueType Type;
+			std::string Name;
+			int Uniform; // index in Uniforms, -1 -> not used by the program
+			std::vector<char> Value;
+			bool Uploaded;
+		};
+
+		// everything that belongs to a single linked program
+		struct ProgramInfo {
+			std::vector<UniformInfo> Uniforms;
+			std::unordered_map<std::string, int> UniformNames;
+			std::vector<UniformSlot> Slots;
+		};
+
+		void m_resolve(UniformSlot& slot, ShaderVariable* var);
+		void m_clearPrograms();
+
 		std::vector<ShaderVariable*> m_vars;
-		std::map<std::string, GLint> m_uLocs;
 		std::vector<std::string> m_samplers;
+
+		GLuint m_program;
+		std::unordered_map<GLuint, ProgramInfo> m_programs;
+		ProgramInfo* m_info; // m_programs[m_program], nullptr if no program was set yet
 	};
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <SHADERed/Objects/SoftwareRenderer.h>
+#include <SHADERed/Objects/RenderEngine.h>
+#include <SHADERed/Objects/ObjectManager.h>
+#include <SHADERed/Objects/Settings.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ed {
+	SoftwareRenderer::SoftwareRenderer(DebugInformation* dbgr, RenderEngine* render, PipelineManager* pipeline, ObjectManager* objects, MessageStack* msgs)
+			: m_analysis(dbgr, render, pipeline, objects, msgs)
+	{
+		m_debugger = dbgr;
+		m_renderer = render;
+		m_pipeline = pipeline;
+		m_objects = objects;
+		m_msgs = msgs;
+
+		// no breakpoints -> FrameAnalysis shades blocks on all threads
+		m_analysis.SetBreakpoints({}, {}, {});
+	}
+
+	void SoftwareRenderer::Render(int width, int height)
+	{
+		// window & render textures have to have the right size + SPIR-V has to be up to date
+		m_renderer->Resize(width, height);
+		m_renderer->UpdateCache();
+
+		glm::vec4 windowClearColor = Settings::Instance().Project.ClearColor;
+		windowClearColor.a = Settings::Instance().Project.UseAlphaChannel ? windowClearColor.a : 1.0f;
+
+		GLuint windowRT = m_renderer->GetTexture();
+		GLuint previousTexture[MAX_RENDER_TEXTURES] = { 0 }; // dont clear the render target if we use it two times in a row
+		GLuint previousDepth = 0;
+		bool clearedWindow = false, clearedWindowDepth = false, hasPreviousDepth = false;
+
+		m_window.assign(width * height, 0);
+
+		std::vector<PipelineItem*>& passes = m_pipeline->GetList();
+		for (PipelineItem* item : passes) {
+			if (item->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+			if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0)
+				continue;
+			if (data->VSSPV.empty() || data->PSSPV.empty())
+				continue;
+
+			// a render texture might've been removed while the pass still references it -> skip the pass
+			std::vector<ed::RenderTextureObject*> rtObjects(data->RTCount, nullptr);
+			bool hasMissingRT = false;
+			for (int i = 0; i < data->RTCount && !hasMissingRT; i++) {
+				GLuint rt = data->RenderTextures[i];
+				if (rt == windowRT)
+					continue;
+
+				ObjectManagerItem* rtItem = m_objects->GetByTextureID(rt);
+				rtObjects[i] = rtItem == nullptr ? nullptr : rtItem->RT;
+				hasMissingRT = rtObjects[i] == nullptr;
+			}
+			if (hasMissingRT)
+				continue;
+
+			// same rules as RenderEngine::Render(): the viewport is set by the last render texture & every target
+			// that wasn't used by the previous pass is cleared
+			glm::ivec2 rtSize(width, height);
+			std::vector<bool> clear(data->RTCount, false);
+			std::vector<glm::vec4> clearColor(data->RTCount, windowClearColor);
+			for (int i = 0; i < data->RTCount; i++) {
+				GLuint rt = data->RenderTextures[i];
+				if (rt != windowRT) {
+					ed::RenderTextureObject* rtObject = rtObjects[i];
+					rtSize = rtObject->CalculateSize(width, height);
+					clearColor[i] = rtObject->ClearColor;
+					clear[i] = rtObject->Clear && std::find(previousTexture, previousTexture + MAX_RENDER_TEXTURES, rt) == previousTexture + MAX_RENDER_TEXTURES;
+				} else {
+					clear[i] = !clearedWindow;
+					clearedWindow = true;
+				}
+			}
+			for (int i = 0; i < MAX_RENDER_TEXTURES; i++)
+				previousTexture[i] = i < data->RTCount ? data->RenderTextures[i] : 0;
+
+			// the depth buffer is shared with the passes that follow until a pass with a different one is reached
+			GLuint lastRT = data->RenderTextures[data->RTCount - 1];
+			GLuint depthBuffer = lastRT == windowRT ? 0 : rtObjects[data->RTCount - 1]->DepthStencilBuffer;
+			size_t pixelCount = rtSize.x * rtSize.y;
+			std::vector<float>& depth = m_depths[depthBuffer];
+			if (!hasPreviousDepth || depthBuffer != previousDepth) {
+				if (depthBuffer != 0 || !clearedWindowDepth)
+					depth.clear();
+				clearedWindowDepth |= depthBuffer == 0;
+				previousDepth = depthBuffer;
+				hasPreviousDepth = true;
+			}
+			std::vector<float> passDepth = depth; // every target starts with the depth from before this pass
+
+			// FrameAnalysis stores a single output location -> the pass is rasterized once per render target
+			for (int i = 0; i < data->RTCount; i++) {
+				GLuint rt = data->RenderTextures[i];
+				std::vector<uint32_t>& target = rt == windowRT ? m_window : m_targets[rt];
+
+				m_analysis.Init(rtSize.x, rtSize.y, clearColor[i]);
+				if (!clear[i] && target.size() == pixelCount)
+					memcpy(m_analysis.GetColorOutput(), target.data(), pixelCount * sizeof(uint32_t));
+				if (passDepth.size() == pixelCount)
+					memcpy(m_analysis.GetDepthOutput(), passDepth.data(), pixelCount * sizeof(float));
+
+				m_analysis.SetRenderTextureIndex(i);
+				m_analysis.RenderPass(item);
+
+				target.resize(pixelCount);
+				memcpy(target.data(), m_analysis.GetColorOutput(), pixelCount * sizeof(uint32_t));
+
+				// upload the results so that the passes which follow can sample them
+				glBindTexture(GL_TEXTURE_2D, rt);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rtSize.x, rtSize.y, GL_RGBA, GL_UNSIGNED_BYTE, target.data());
+				glBindTexture(GL_TEXTURE_2D, 0);
+				m_objects->BumpTextureGeneration(rt);
+			}
+			m_analysis.SetRenderTextureIndex(0);
+
+			depth.resize(pixelCount);
+			memcpy(depth.data(), m_analysis.GetDepthOutput(), pixelCount * sizeof(float));
+		}
+
+		// nothing was rendered to the window
+		if (!clearedWindow) {
+			uint32_t clearColorU32 = (uint32_t)(windowClearColor.r * 255) | (uint32_t)(windowClearColor.g * 255) << 8 | (uint32_t)(windowClearColor.b * 255) << 16 | (uint32_t)(windowClearColor.a * 255) << 24;
+			std::fill(m_window.begin(), m_window.end(), clearColorU32);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <SHADERed/Objects/FrameAnalysis.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace ed {
+	/* renders the whole pipeline on the CPU with the FrameAnalysis rasterizer - used for --render when
+		--rendersoftware is passed. This only replaces the draw calls: a GL context is still required, since
+		textures, buffers & render textures are GL objects (passes sample the results of the previous ones from
+		them) and the shaders are compiled through the same code path as the GPU renderer. Compute, audio and
+		plugin passes are skipped */
+	class SoftwareRenderer {
+	public:
+		SoftwareRenderer(DebugInformation* dbgr, RenderEngine* render, PipelineManager* pipeline, ObjectManager* objects, MessageStack* msgs);
+
+		void Render(int width, int height);
+
+		// RGBA8 window contents, bottom row first (same layout as glGetTexImage)
+		inline uint32_t* GetColorOutput() { return m_window.data(); }
+
+	private:
+		DebugInformation* m_debugger;
+		RenderEngine* m_renderer;
+		PipelineManager* m_pipeline;
+		ObjectManager* m_objects;
+		MessageStack* m_msgs;
+
+		FrameAnalysis m_analysis;
+
+		std::vector<uint32_t> m_window;
+		std::unordered_map<GLuint, std::vector<uint32_t>> m_targets; // contents of render textures that aren't cleared every frame
+		std::unordered_map<GLuint, std::vector<float>> m_depths; // depth buffer -> contents, 0 is the window's depth buffer
+	};
+}
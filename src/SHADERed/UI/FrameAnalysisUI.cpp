@@ -4,36 +4,19 @@
 namespace ed {
 	void FrameAnalysisUI::Process()
 	{
-		for (int i = 0; i < 256; i++) {
-			m_histogramR[i] = m_histogramG[i] = m_histogramB[i] = 0.0f;
-			m_histogramRGB[i] = 0.0f;
-		}
-
-		// get texture data
+		// histograms & statistics are computed where the texture is - only the results are copied
 		glm::ivec2 rendererSize = m_data->Renderer.GetLastRenderSize();
-		uint8_t* pixels = (uint8_t*)malloc(rendererSize.x * rendererSize.y * 4);
-		glBindTexture(GL_TEXTURE_2D, m_data->Renderer.GetTexture());
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		m_statistics.Compute(m_data->Renderer.GetTexture(), rendererSize.x, rendererSize.y, m_stats);
 
-		// build histogram
-		for (int x = 0; x < rendererSize.x; x++) {
-			for (int y = 0; y < rendererSize.y; y++) {
-				uint8_t* px = &pixels[(y * rendererSize.x + x) * 4];
-
-				m_histogramR[px[0]]++;
-				m_histogramG[px[1]]++;
-				m_histogramB[px[2]]++;
+		for (int i = 0; i < 256; i++) {
+			m_histogramR[i] = m_stats.Histogram[eng::ImageStatistics::Red][i];
+			m_histogramG[i] = m_stats.Histogram[eng::ImageStatistics::Green][i];
+			m_histogramB[i] = m_stats.Histogram[eng::ImageStatistics::Blue][i];
+			m_histogramLum[i] = m_stats.Histogram[eng::ImageStatistics::Luminance][i];
 
-				// TODO: is this even how RGB histogram works? I just did this by my logic idk tho, compare with Photoshop 
-				m_histogramRGB[px[0]]++;
-				m_histogramRGB[px[1]]++;
-				m_histogramRGB[px[2]]++;
-			}
+			// TODO: is this even how RGB histogram works? I just did this by my logic idk tho, compare with Photoshop 
+			m_histogramRGB[i] = m_histogramR[i] + m_histogramG[i] + m_histogramB[i];
 		}
-
-		// free memory
-		free(pixels);
 	}
 	void FrameAnalysisUI::OnEvent(const SDL_Event& e)
 	{
@@ -43,7 +26,7 @@ namespace ed {
 		ImGui::TextWrapped("Color histogram");
 		ImGui::Separator();
 		ImGui::PushItemWidth(-1);
-		ImGui::Combo("##histogram_combo", &m_histogramType, "RGB\0R\0G\0B\0");
+		ImGui::Combo("##histogram_combo", &m_histogramType, "RGB\0R\0G\0B\0Luminance\0");
 		ImGui::PopItemWidth();
 
 		const float* histogramData = m_histogramRGB;
@@ -53,10 +36,21 @@ namespace ed {
 			histogramData = m_histogramG;
 		else if (m_histogramType == 3)
 			histogramData = m_histogramB;
+		else if (m_histogramType == 4)
+			histogramData = m_histogramLum;
 
 		ImGui::PlotHistogram("##testhistogram", histogramData, 256, 0, 0, 0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvailWidth(), 256));
 		ImGui::NewLine();
 
+		ImGui::TextWrapped("Color statistics");
+		ImGui::Separator();
+		const char* channelNames[] = { "Red", "Green", "Blue", "Alpha", "Luminance" };
+		for (int i = 0; i < eng::ImageStatistics::ChannelCount; i++)
+			ImGui::TextWrapped("%s: min %.3f, max %.3f, mean %.3f", channelNames[i], m_stats.Min[i], m_stats.Max[i], m_stats.Mean[i]);
+		ImGui::TextWrapped("%llu pixels contain NaN", (unsigned long long)m_stats.NaNCount);
+		ImGui::TextWrapped("%llu pixels contain Inf", (unsigned long long)m_stats.InfCount);
+		ImGui::NewLine();
+
 		ImGui::TextWrapped("Miscellaneous");
 		ImGui::Separator();
 		ImGui::TextWrapped("%u pixels rendered", m_data->Analysis.GetPixelCount());
@@ -1,5 +1,6 @@
 #pragma once
 #include <SHADERed/UI/UIView.h>
+#include <SHADERed/Engine/ImageStatistics.h>
 #include <SDL2/SDL_events.h>
 
 namespace ed {
@@ -9,6 +10,7 @@ namespace ed {
 				: UIView(ui, objects, name, visible)
 		{ 
 			m_histogramType = 0;
+			memset(&m_stats, 0, sizeof(m_stats));
 		}
 		~FrameAnalysisUI() { }
 
@@ -19,7 +21,10 @@ namespace ed {
 
 	private:
 		int m_histogramType;
-		float m_histogramR[256], m_histogramG[256], m_histogramB[256], m_histogramRGB[256];
+		float m_histogramR[256], m_histogramG[256], m_histogramB[256], m_histogramRGB[256], m_histogramLum[256];
+
+		eng::ImageStatistics m_statistics;
+		eng::ImageStatistics::Result m_stats;
 
 		std::vector<float> m_pixelHeights;
 	};
@@ -245,7 +245,7 @@ namespace ed {
 
 									if (mitem->InstanceBuffer == (void*)oItem->Buffer) {
 										for (auto& mesh : mitem->Data->Meshes)
-											gl::CreateVAO(mesh.VAO, mesh.VBO, pdata->InputLayout, mesh.EBO);
+											gl::CreateVAO(mesh, pdata->InputLayout);
 										mitem->InstanceBuffer = nullptr;
 									}
 								} else if (pitem->Type == ed::PipelineItem::ItemType::VertexBuffer) {
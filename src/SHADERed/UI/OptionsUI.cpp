@@ -378,6 +378,16 @@ namespace ed {
 		ImGui::SameLine();
 		ImGui::Checkbox("##optg_tips", &settings->General.Tips);
 
+		/* COMPACT MODELS: */
+		ImGui::Text("Store 3D models in a compact vertex format: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_compactmodels", &settings->General.CompactModels);
+
+		/* RELEASE MODEL DATA: */
+		ImGui::Text("Free the CPU copy of 3D models after loading: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_releasemodeldata", &settings->General.ReleaseModelData);
+
 		/* STARTUP TEMPLATE: */
 		ImGui::Text("Default template: ");
 		ImGui::SameLine();
@@ -830,6 +840,11 @@ namespace ed {
 		ImGui::SameLine();
 		ImGui::Checkbox("##optp_status_bar", &settings->Preview.StatusBar);
 
+		/* AUDIO SHADERS ON CPU: */
+		ImGui::Text("Run audio shaders on the CPU (applied on recompile): ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_audio_cpu", &settings->Preview.AudioShaderCPU);
+
 		/* SHOW BOUNDING BOX: */
 		ImGui::Text("Show bounding box: ");
 		ImGui::SameLine();
@@ -992,6 +1007,19 @@ namespace ed {
 		ImGui::Text("Primitive outline: ");
 		ImGui::SameLine();
 		ImGui::Checkbox("##optdbg_primitiveoutline", &settings->Debug.PrimitiveOutline);
+
+		/* FRAME ANALYSIS THREADS: */
+		ImGui::Text("Frame analysis threads (0 = all cores): ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(settings->CalculateSize(100));
+		if (ImGui::InputInt("##optdbg_analysisthreads", &settings->Debug.AnalysisThreads))
+			settings->Debug.AnalysisThreads = std::max<int>(0, settings->Debug.AnalysisThreads);
+		ImGui::PopItemWidth();
+
+		/* FRAME ANALYSIS QUADS: */
+		ImGui::Text("Shade 2x2 quads at once in frame analysis (faster, approximate derivatives): ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optdbg_analysisquads", &settings->Debug.AnalysisQuads);
 	}
 	void OptionsUI::m_renderProject()
 	{
@@ -246,10 +246,10 @@ namespace ed {
 						BufferObject* bobj = (BufferObject*)mitem->InstanceBuffer;
 						if (bobj == nullptr) {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO);
+								gl::CreateVAO(mesh, pass->InputLayout);
 						} else {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
+								gl::CreateVAO(mesh, pass->InputLayout, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
 						}
 					} else if (pitem->Type == PipelineItem::ItemType::VertexBuffer) {
 						pipe::VertexBuffer* mitem = (pipe::VertexBuffer*)pitem->Data;
@@ -366,9 +366,7 @@ namespace ed {
 				if (owner != nullptr)
 					owner->Owner->PipelineItem_MoveUp(owner->PluginData, owner->Type, items[index]->Name);
 
-				ed::PipelineItem* temp = items[index - 1];
-				items[index - 1] = items[index];
-				items[index] = temp;
+				m_data->Pipeline.Swap(items, index - 1, index);
 
 				if (props->HasItemSelected()) {
 					if (oldPropertyItemName == items[index - 1]->Name)
@@ -392,9 +390,7 @@ namespace ed {
 				if (owner != nullptr)
 					owner->Owner->PipelineItem_MoveDown(owner->PluginData, owner->Type, items[index]->Name);
 
-				ed::PipelineItem* temp = items[index + 1];
-				items[index + 1] = items[index];
-				items[index] = temp;
+				m_data->Pipeline.Swap(items, index, index + 1);
 
 				if (props->HasItemSelected()) {
 					if (oldPropertyItemName == items[index + 1]->Name)
@@ -370,9 +370,19 @@ namespace ed {
 			m_varValue = nullptr;
 		}
 
-		if (m_frameAnalyzed) {
-			// variable value viewer
-			m_varValue = m_data->Analysis.AllocateVariableValueMap(item, varName, line, m_varValueComponents);
+		// variable value viewer - the values are uploaded by Update() once the GPU has them
+		m_varValuePending = m_frameAnalyzed && m_data->Analysis.RequestVariableValueMap(item, varName, line);
+	}
+	void PreviewUI::m_updateVariableValue()
+	{
+		if (!m_varValuePending || !m_data->Analysis.IsVariableValueMapReady())
+			return;
+
+		m_varValuePending = false;
+
+		m_varValue = m_data->Analysis.AllocateVariableValueMap(m_varValueComponents);
+		m_varValueSize = m_data->Analysis.GetVariableValueMapSize();
+		if (m_varValue != nullptr) {
 			glDeleteTextures(1, &m_viewVariableValue);
 			glGenTextures(1, &m_viewVariableValue);
 			glBindTexture(GL_TEXTURE_2D, m_viewVariableValue);
@@ -380,7 +390,7 @@ namespace ed {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_imgSize.x, m_imgSize.y, 0, GL_RGBA, GL_FLOAT, m_varValue);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_varValueSize.x, m_varValueSize.y, 0, GL_RGBA, GL_FLOAT, m_varValue);
 		}
 	}
 	void PreviewUI::Update(float delta)
@@ -478,6 +488,8 @@ namespace ed {
 		if (capWholeApp && m_fpsLimit > 0 && 1000 / delta > m_fpsLimit)
 			std::this_thread::sleep_for(std::chrono::milliseconds(1000 / (int)m_fpsLimit - (int)(1000 * delta)));
 
+		m_updateVariableValue();
+
 		m_imgPosition = ImGui::GetCursorScreenPos();
 
 		// display the image on the imgui window
@@ -505,7 +517,7 @@ namespace ed {
 			if (m_view == PreviewView::Heatmap || m_view == PreviewView::VariableValue) {
 				glm::ivec2 outputSize = m_data->Analysis.GetOutputSize();
 				if (m_view == PreviewView::VariableValue)
-					outputSize = m_data->Renderer.GetLastRenderSize();
+					outputSize = m_varValueSize;
 
 				glm::vec2 pixelSize = 1.0f / glm::vec2(outputSize);
 				const float pixelMult = 30.0f;
@@ -525,7 +537,7 @@ namespace ed {
 					drawList->AddRect(ImVec2(selectorPos.x + (pixelCount / 2) * pixelMult, selectorPos.y + (pixelCount / 2) * pixelMult), ImVec2(selectorPos.x + (pixelCount / 2 + 1) * pixelMult, selectorPos.y + (pixelCount / 2 + 1) * pixelMult), 0xFFFFFFFF);
 					if (m_view == PreviewView::VariableValue) {
 						if (m_varValue) {
-							float* varVal = &m_varValue[(pixelPos.y * m_data->Renderer.GetLastRenderSize().x + pixelPos.x) * 4];
+							float* varVal = &m_varValue[(pixelPos.y * m_varValueSize.x + pixelPos.x) * 4];
 							if (m_varValueComponents == 1)
 								ImGui::Text("value: %.6f", varVal[0]);
 							else if (m_varValueComponents == 2)
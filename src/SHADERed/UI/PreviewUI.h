@@ -52,7 +52,9 @@ namespace ed {
 			m_varValueName = "";
 			m_varValueLine = 0;
 			m_varValueComponents = 0;
+			m_varValueSize = glm::ivec2(0, 0);
 			m_varValue = nullptr;
+			m_varValuePending = false;
 		}
 		~PreviewUI()
 		{
@@ -182,6 +184,9 @@ namespace ed {
 		std::string m_varValueName;
 		int m_varValueLine;
 		uint8_t m_varValueComponents;
+		glm::ivec2 m_varValueSize;
 		float* m_varValue;
+		bool m_varValuePending; // waiting for Analysis to read the values back
+		void m_updateVariableValue();
 	};
 }
\ No newline at end of file
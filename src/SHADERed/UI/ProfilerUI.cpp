@@ -1,5 +1,8 @@
 #include <SHADERed/UI/ProfilerUI.h>
+#include <SHADERed/Objects/Profiler.h>
 #include <SHADERed/Objects/Settings.h>
+#include <misc/ImFileDialog.h>
+#include <algorithm>
 
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <imgui/imgui_internal.h>
@@ -16,18 +19,56 @@ namespace ed {
 			ImGui::TextWrapped("Turn on the 'Profiler' in Options -> General.");
 			return;
 		}
-		const std::vector<PerformanceTimer>& perfTimers = m_data->Renderer.GetPerformanceTimers();
-		unsigned long long gpuTime = m_data->Renderer.GetGPUTime();
-		unsigned long long timeOffset = 0;
 
-		m_renderRow(0, "Total time", gpuTime, 0ull, gpuTime);
+		Profiler& profiler = Profiler::Instance();
+		const std::deque<Profiler::Frame>& history = profiler.GetHistory();
+
+		// toolbar
+		ImGui::SetCursorPos(ImVec2(PROFILER_PADDING, ImGui::GetWindowContentRegionMin().y + PROFILER_PADDING));
+		if (ImGui::Button("Export"))
+			ifd::FileDialog::Instance().Save("SaveProfilerTraceDlg", "Export profiler data", "Chrome trace (*.json){.json},.*");
+		ImGui::SameLine();
+		if (ImGui::Button("Clear"))
+			profiler.Clear();
+		ImGui::SameLine();
+		ImGui::Text("%d frames captured", (int)history.size());
+
+		if (ifd::FileDialog::Instance().IsDone("SaveProfilerTraceDlg")) {
+			if (ifd::FileDialog::Instance().HasResult()) {
+				std::string filePathName = ifd::FileDialog::Instance().GetResult().u8string();
+				if (!profiler.Export(filePathName))
+					m_data->Messages.Add(ed::MessageStack::Type::Error, "", "Failed to export the profiler data to " + filePathName);
+			}
+			ifd::FileDialog::Instance().Close();
+		}
+
+		if (history.empty())
+			return;
+
+		const Profiler::Frame& frame = history.back();
+
+		// GPU timeline
+		uint64_t gpuStart = UINT64_MAX, gpuEnd = 0;
+		for (const auto& evt : frame.Events) {
+			if (evt.Thread != 0)
+				continue;
+			gpuStart = std::min<uint64_t>(gpuStart, evt.Start);
+			gpuEnd = std::max<uint64_t>(gpuEnd, evt.Start + evt.Duration);
+		}
 
 		int index = 1;
-		for (const auto& timer : perfTimers) {
-			m_renderRow(index, timer.Pass->Name, timer.LastTime, timeOffset, gpuTime);
-			timeOffset += timer.LastTime;
-			index++;
+		if (gpuEnd > gpuStart) {
+			m_renderRow(index++, "GPU", gpuEnd - gpuStart, 0ull, gpuEnd - gpuStart);
+			for (const auto& evt : frame.Events)
+				if (evt.Thread == 0)
+					m_renderRow(index++, (std::string(evt.Depth * 2 + 2, ' ') + evt.Name).c_str(), evt.Duration, evt.Start - gpuStart, gpuEnd - gpuStart);
 		}
+
+		// main thread timeline
+		m_renderRow(index++, "CPU", frame.Duration, 0ull, frame.Duration);
+		for (const auto& evt : frame.Events)
+			if (evt.Thread == 1 && evt.Start >= frame.Start)
+				m_renderRow(index++, (std::string(evt.Depth * 2 + 2, ' ') + evt.Name).c_str(), evt.Duration, evt.Start - frame.Start, frame.Duration);
 	}
 	void ProfilerUI::m_renderRow(int index, const char* name, uint64_t time, uint64_t timeOffset, uint64_t totalTime)
 	{
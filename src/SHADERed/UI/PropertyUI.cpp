@@ -997,7 +997,7 @@ namespace ed {
 							pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 							for (auto& mesh : item->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO);
+								gl::CreateVAO(mesh, ownerData->InputLayout);
 
 							m_data->Parser.ModifyProject();
 						}
@@ -1016,7 +1016,7 @@ namespace ed {
 								pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 								for (auto& mesh : item->Data->Meshes)
-									gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO, buf->ID, fmtList);
+									gl::CreateVAO(mesh, ownerData->InputLayout, buf->ID, fmtList);
 
 								m_data->Parser.ModifyProject();
 							}